@@ -0,0 +1,117 @@
+#include "mod-ollama-chat_admission.h"
+#include "mod-ollama-chat_config.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+const char* LLMRequestSourceStr[] =
+{
+    "Chat",
+    "Event",
+    "Random"
+};
+
+namespace
+{
+    struct TokenBucket
+    {
+        double ratePerSecond = 0.0;   // 0 = unlimited
+        double capacity      = 0.0;
+        double tokens        = 0.0;
+        std::chrono::steady_clock::time_point lastRefill;
+
+        void Configure(float rate, uint32_t burst, std::chrono::steady_clock::time_point now)
+        {
+            ratePerSecond = rate > 0.0f ? rate : 0.0;
+            // A bucket that refills but can never hold a whole token would reject everything
+            capacity      = std::max<double>(burst, 1.0);
+            tokens        = capacity;
+            lastRefill    = now;
+        }
+
+        bool Unlimited() const { return ratePerSecond <= 0.0; }
+
+        void Refill(std::chrono::steady_clock::time_point now)
+        {
+            if (Unlimited())
+                return;
+            double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+            tokens = std::min(capacity, tokens + elapsed * ratePerSecond);
+            lastRefill = now;
+        }
+
+        bool HasToken() const { return Unlimited() || tokens >= 1.0; }
+
+        void Take()
+        {
+            if (!Unlimited())
+                tokens -= 1.0;
+        }
+    };
+
+    std::mutex        s_AdmissionMutex;
+    TokenBucket       s_SourceBuckets[LLM_SOURCE_COUNT];
+    TokenBucket       s_GlobalBucket;
+    LLMAdmissionStats s_AdmissionStats = {};
+}
+
+void ConfigureLLMAdmission()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(s_AdmissionMutex);
+    s_SourceBuckets[LLM_SOURCE_CHAT].Configure(g_ChatRequestsPerSecond, g_ChatRequestBurst, now);
+    s_SourceBuckets[LLM_SOURCE_EVENT].Configure(g_EventRequestsPerSecond, g_EventRequestBurst, now);
+    s_SourceBuckets[LLM_SOURCE_RANDOM].Configure(g_RandomRequestsPerSecond, g_RandomRequestBurst, now);
+    s_GlobalBucket.Configure(g_GlobalRequestsPerSecond, g_GlobalRequestBurst, now);
+}
+
+bool TryAdmitLLMRequest(LLMRequestSource source)
+{
+    if (source >= LLM_SOURCE_COUNT)
+        return false;
+
+    if (!g_EnableAdmissionControl)
+    {
+        std::lock_guard<std::mutex> lock(s_AdmissionMutex);
+        ++s_AdmissionStats.admitted[source];
+        return true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(s_AdmissionMutex);
+    TokenBucket& bucket = s_SourceBuckets[source];
+    bucket.Refill(now);
+    s_GlobalBucket.Refill(now);
+
+    if (!bucket.HasToken())
+    {
+        ++s_AdmissionStats.rejectedSource[source];
+        if (g_DebugEnabled)
+            LOG_INFO("server.loading", "[Ollama Chat] Admission: {} request rejected, source budget exhausted.",
+                     LLMRequestSourceStr[source]);
+        return false;
+    }
+
+    if (!s_GlobalBucket.HasToken())
+    {
+        ++s_AdmissionStats.rejectedGlobal[source];
+        if (g_DebugEnabled)
+            LOG_INFO("server.loading", "[Ollama Chat] Admission: {} request rejected, global budget exhausted.",
+                     LLMRequestSourceStr[source]);
+        return false;
+    }
+
+    bucket.Take();
+    s_GlobalBucket.Take();
+    ++s_AdmissionStats.admitted[source];
+    return true;
+}
+
+LLMAdmissionStats GetLLMAdmissionStats()
+{
+    std::lock_guard<std::mutex> lock(s_AdmissionMutex);
+    return s_AdmissionStats;
+}
@@ -0,0 +1,45 @@
+#ifndef MOD_OLLAMA_CHAT_ADMISSION_H
+#define MOD_OLLAMA_CHAT_ADMISSION_H
+
+#include <cstdint>
+
+// Origin of an LLM request, used to pick the token bucket it is charged against.
+enum LLMRequestSource
+{
+    LLM_SOURCE_CHAT   = 0,
+    LLM_SOURCE_EVENT  = 1,
+    LLM_SOURCE_RANDOM = 2,
+    LLM_SOURCE_COUNT
+};
+
+extern const char* LLMRequestSourceStr[];
+
+struct LLMAdmissionStats
+{
+    uint64_t admitted[LLM_SOURCE_COUNT];
+    uint64_t rejectedSource[LLM_SOURCE_COUNT];   // Rejected by the per-source bucket
+    uint64_t rejectedGlobal[LLM_SOURCE_COUNT];   // Rejected by the shared global bucket
+};
+
+/**
+ * Rebuild the token buckets from the current OllamaChat.* admission settings.
+ * Called from LoadOllamaChatConfig; buckets start full.
+ */
+void ConfigureLLMAdmission();
+
+/**
+ * Try to take one token for a new LLM request from the given source.
+ * Both the source bucket and the global bucket must have a token; either
+ * both are consumed or neither is. Call before building the prompt so a
+ * rejected request costs nothing.
+ * @param source Where the request comes from
+ * @return true if the request may proceed
+ */
+bool TryAdmitLLMRequest(LLMRequestSource source);
+
+/**
+ * Snapshot of the admitted/rejected counters since startup.
+ */
+LLMAdmissionStats GetLLMAdmissionStats();
+
+#endif // MOD_OLLAMA_CHAT_ADMISSION_H
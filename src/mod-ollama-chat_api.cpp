@@ -1,5 +1,6 @@
 #include "mod-ollama-chat_api.h"
 #include "mod-ollama-chat_config.h"
+#include "mod-ollama-chat_context.h"
 #include "mod-ollama-chat_httpclient.h"
 #include "mod-ollama-chat-utilities.h"
 #include "Log.h"
@@ -10,6 +11,7 @@
 #include <mutex>
 #include <queue>
 #include <future>
+#include <atomic>
 
 std::string ExtractTextBetweenDoubleQuotes(const std::string& response)
 {
@@ -21,8 +23,53 @@ std::string ExtractTextBetweenDoubleQuotes(const std::string& response)
     return response;
 }
 
-// Function to perform the API call.
+static std::atomic<uint64_t> promptEvalResponses{0};
+static std::atomic<uint64_t> promptEvalCountTotal{0};
+static std::atomic<uint64_t> promptEvalDurationTotal{0};
+static std::atomic<uint64_t> evalCountTotal{0};
+static std::atomic<uint64_t> evalDurationTotal{0};
+
+OllamaPromptEvalStats GetOllamaPromptEvalStats()
+{
+    return {
+        promptEvalResponses.load(),
+        promptEvalCountTotal.load(),
+        promptEvalDurationTotal.load(),
+        evalCountTotal.load(),
+        evalDurationTotal.load()
+    };
+}
+
+// Records the timing fields of the final response line. Ollama only evaluates the part
+// of the prompt that differs from what it already has cached, so a stable prefix shows
+// up here as a low prompt_eval_count.
+static void RecordPromptEvalStats(const nlohmann::json& jsonResponse)
+{
+    if (!jsonResponse.contains("prompt_eval_count") && !jsonResponse.contains("eval_count"))
+        return;
+
+    uint64_t promptEvalCount    = jsonResponse.value("prompt_eval_count", uint64_t(0));
+    uint64_t promptEvalDuration = jsonResponse.value("prompt_eval_duration", uint64_t(0));
+    uint64_t evalCount          = jsonResponse.value("eval_count", uint64_t(0));
+    uint64_t evalDuration       = jsonResponse.value("eval_duration", uint64_t(0));
+
+    ++promptEvalResponses;
+    promptEvalCountTotal += promptEvalCount;
+    promptEvalDurationTotal += promptEvalDuration;
+    evalCountTotal += evalCount;
+    evalDurationTotal += evalDuration;
+
+    LOG_INFO("server.loading", "[Ollama Chat] prompt_eval_count: {}, prompt_eval_duration: {:.1f} ms, eval_count: {}, eval_duration: {:.1f} ms",
+             promptEvalCount, promptEvalDuration / 1e6, evalCount, evalDuration / 1e6);
+}
+
 std::string QueryOllamaAPI(const std::string& prompt)
+{
+    return QueryOllamaAPI(OllamaRequest{ prompt, "" });
+}
+
+// Function to perform the API call.
+std::string QueryOllamaAPI(const OllamaRequest& request)
 {
     // Initialize our custom HTTP client
     static OllamaHttpClient httpClient;
@@ -36,15 +83,17 @@ std::string QueryOllamaAPI(const std::string& prompt)
         return "Hmm... I'm lost in thought.";
     }
 
-    std::string url   = g_OllamaUrl;
+    bool useChat = g_OllamaApiBackend == OLLAMA_BACKEND_CHAT;
+    bool keepContext = g_OllamaApiBackend == OLLAMA_BACKEND_CONTEXT && request.botGuid && request.playerGuid;
+
+    std::string url   = useChat ? g_OllamaChatUrl : g_OllamaUrl;
     std::string model = g_OllamaModel;
 
     // Sanitize the prompt to ensure it's valid UTF-8 before creating JSON
-    std::string sanitizedPrompt = SanitizeUTF8(prompt);
+    std::string sanitizedPrompt = SanitizeUTF8(request.prompt);
 
     nlohmann::json requestData = {
         {"model",  model},
-        {"prompt", sanitizedPrompt},
         {"stream", false}
     };
 
@@ -115,10 +164,42 @@ std::string QueryOllamaAPI(const std::string& prompt)
         if (!stopSeqs.empty())
             requestData["stop"] = stopSeqs;
     }
-    if (!g_OllamaSystemPrompt.empty())
+    // The global system prompt comes first so it stays a common prefix for every bot
+    std::string systemPrompt = g_OllamaSystemPrompt;
+    if (!request.system.empty())
+    {
+        if (!systemPrompt.empty())
+            systemPrompt += "\n";
+        systemPrompt += request.system;
+    }
+
+    if (useChat)
     {
-        // Sanitize system prompt as well
-        requestData["system"] = SanitizeUTF8(g_OllamaSystemPrompt);
+        // Earlier turns go as separate messages, so only the new turn is rendered into the prompt
+        nlohmann::json messages = nlohmann::json::array();
+        if (!systemPrompt.empty())
+            messages.push_back({ {"role", "system"}, {"content", SanitizeUTF8(systemPrompt)} });
+        for (const auto& turn : request.history)
+        {
+            messages.push_back({ {"role", "user"}, {"content", SanitizeUTF8(turn.first)} });
+            messages.push_back({ {"role", "assistant"}, {"content", SanitizeUTF8(turn.second)} });
+        }
+        messages.push_back({ {"role", "user"}, {"content", sanitizedPrompt} });
+        requestData["messages"] = std::move(messages);
+    }
+    else
+    {
+        requestData["prompt"] = sanitizedPrompt;
+        if (request.context)
+        {
+            // The system prompt and earlier turns are already part of the context
+            requestData["context"] = *request.context;
+        }
+        else if (!systemPrompt.empty())
+        {
+            // Sanitize system prompt as well
+            requestData["system"] = SanitizeUTF8(systemPrompt);
+        }
     }
 
     if (g_ThinkModeEnableForModule)
@@ -162,6 +243,21 @@ std::string QueryOllamaAPI(const std::string& prompt)
             {
                 extractedResponse << jsonResponse["response"].get<std::string>();
             }
+            else if (jsonResponse.contains("message") && jsonResponse["message"].contains("content"))
+            {
+                extractedResponse << jsonResponse["message"]["content"].get<std::string>();
+            }
+
+            if (keepContext && jsonResponse.contains("context"))
+            {
+                StoreConversationContext(request.botGuid, request.playerGuid,
+                                         jsonResponse["context"].get<OllamaContextTokens>());
+            }
+
+            if (g_LogPromptEvalStats && jsonResponse.value("done", false))
+            {
+                RecordPromptEvalStats(jsonResponse);
+            }
         }
     }
     catch (const std::exception& e)
@@ -207,7 +303,7 @@ std::string QueryOllamaAPI(const std::string& prompt)
 QueryManager g_queryManager;
 
 // Interface function to submit a query.
-std::future<std::string> SubmitQuery(const std::string& prompt)
+std::future<std::string> SubmitQuery(const OllamaRequest& request)
 {
-    return g_queryManager.submitQuery(prompt);
+    return g_queryManager.submitQuery(request);
 }
\ No newline at end of file
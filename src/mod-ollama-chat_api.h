@@ -3,12 +3,28 @@
 
 #include <string>
 #include <future>
+#include <cstdint>
 #include "mod-ollama-chat_querymanager.h"
 
 std::string QueryOllamaAPI(const std::string& prompt);
+std::string QueryOllamaAPI(const OllamaRequest& request);
 
 // Submits a query to the API.
-std::future<std::string> SubmitQuery(const std::string& prompt);
+std::future<std::string> SubmitQuery(const OllamaRequest& request);
+
+// Totals of the prompt_eval_count / prompt_eval_duration Ollama reports, collected
+// while OllamaChat.LogPromptEvalStats is enabled. A prompt whose prefix was reused
+// from the server's cache reports only the tokens that had to be evaluated.
+struct OllamaPromptEvalStats
+{
+    uint64_t responses;
+    uint64_t promptEvalCount;
+    uint64_t promptEvalDurationNs;
+    uint64_t evalCount;
+    uint64_t evalDurationNs;
+};
+
+OllamaPromptEvalStats GetOllamaPromptEvalStats();
 
 // Declare the global QueryManager variable.
 extern QueryManager g_queryManager;
@@ -0,0 +1,104 @@
+#include "mod-ollama-chat_blacklist.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <mutex>
+
+static constexpr uint32_t BLACKLIST_NO_NODE = UINT32_MAX;
+
+// Current compiled trie. Readers copy the pointer under the mutex and then match
+// without holding it, so a reload never blocks or invalidates an in-flight check.
+static std::shared_ptr<const BlacklistTrie> s_BlacklistTrie = std::make_shared<BlacklistTrie>();
+static std::mutex s_BlacklistTrieMutex;
+
+BlacklistTrie::BlacklistTrie() : m_prefixCount(0)
+{
+    m_nodes.emplace_back(); // root
+}
+
+uint32_t BlacklistTrie::FindChild(uint32_t node, unsigned char c) const
+{
+    const auto& children = m_nodes[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), c,
+        [](const std::pair<unsigned char, uint32_t>& child, unsigned char value) { return child.first < value; });
+    if (it != children.end() && it->first == c)
+        return it->second;
+    return BLACKLIST_NO_NODE;
+}
+
+void BlacklistTrie::Insert(const std::string& prefix)
+{
+    if (prefix.empty())
+        return;
+
+    uint32_t node = 0;
+    for (char ch : prefix)
+    {
+        unsigned char c = static_cast<unsigned char>(ch);
+        uint32_t next = FindChild(node, c);
+        if (next == BLACKLIST_NO_NODE)
+        {
+            next = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+            auto& children = m_nodes[node].children;
+            auto it = std::lower_bound(children.begin(), children.end(), c,
+                [](const std::pair<unsigned char, uint32_t>& child, unsigned char value) { return child.first < value; });
+            children.insert(it, { c, next });
+        }
+        node = next;
+    }
+
+    if (!m_nodes[node].terminal)
+    {
+        m_nodes[node].terminal = true;
+        ++m_prefixCount;
+    }
+}
+
+bool BlacklistTrie::Match(const std::string& text, size_t* matchedLength) const
+{
+    uint32_t node = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        node = FindChild(node, static_cast<unsigned char>(text[i]));
+        if (node == BLACKLIST_NO_NODE)
+            return false;
+
+        // Same word-boundary rule as the old startsWithWord check
+        if (m_nodes[node].terminal &&
+            (i + 1 == text.size() || !std::isalnum(static_cast<unsigned char>(text[i + 1]))))
+        {
+            if (matchedLength)
+                *matchedLength = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RebuildBlacklistTrie(const std::vector<std::string>& commands)
+{
+    auto trie = std::make_shared<BlacklistTrie>();
+    for (const auto& cmd : commands)
+        trie->Insert(cmd);
+
+    std::lock_guard<std::mutex> lock(s_BlacklistTrieMutex);
+    s_BlacklistTrie = std::move(trie);
+}
+
+bool IsBlacklistedCommand(const std::string& message, std::string* matchedPrefix)
+{
+    std::shared_ptr<const BlacklistTrie> trie;
+    {
+        std::lock_guard<std::mutex> lock(s_BlacklistTrieMutex);
+        trie = s_BlacklistTrie;
+    }
+
+    size_t matchedLength = 0;
+    if (!trie->Match(message, &matchedLength))
+        return false;
+
+    if (matchedPrefix)
+        *matchedPrefix = message.substr(0, matchedLength);
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef MOD_OLLAMA_CHAT_BLACKLIST_H
+#define MOD_OLLAMA_CHAT_BLACKLIST_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Prefix trie built from g_BlacklistCommands.
+// A message is blacklisted when it starts with one of the prefixes as a whole word,
+// i.e. the prefix is followed by the end of the message or a non-alphanumeric character.
+class BlacklistTrie
+{
+public:
+    BlacklistTrie();
+
+    void Insert(const std::string& prefix);
+
+    // Walks the message once; cost is bounded by the length of the longest prefix.
+    // On match, the matched prefix length is written to matchedLength (if provided).
+    bool Match(const std::string& text, size_t* matchedLength = nullptr) const;
+
+    size_t GetPrefixCount() const { return m_prefixCount; }
+    size_t GetNodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Node
+    {
+        // Sorted by character; blacklist fan-out is small so a flat vector beats a map.
+        std::vector<std::pair<unsigned char, uint32_t>> children;
+        bool terminal = false;
+    };
+
+    uint32_t FindChild(uint32_t node, unsigned char c) const;
+
+    std::vector<Node> m_nodes;
+    size_t m_prefixCount;
+};
+
+// Compiles the given command prefixes into a new trie and swaps it in atomically.
+void RebuildBlacklistTrie(const std::vector<std::string>& commands);
+
+// Returns true if the message starts with a blacklisted command prefix.
+// matchedPrefix receives the matching prefix for logging (if provided).
+bool IsBlacklistedCommand(const std::string& message, std::string* matchedPrefix = nullptr);
+
+#endif // MOD_OLLAMA_CHAT_BLACKLIST_H
@@ -2,6 +2,14 @@
 #include "mod-ollama-chat_config.h"
 #include "mod-ollama-chat_sentiment.h"
 #include "mod-ollama-chat_personality.h"
+#include "mod-ollama-chat_admission.h"
+#include "mod-ollama-chat_api.h"
+#include "mod-ollama-chat_context.h"
+#include "mod-ollama-chat_history.h"
+#include "mod-ollama-chat_dbsave.h"
+#include "mod-ollama-chat_journal.h"
+#include "mod-ollama-chat_lockstats.h"
+#include "mod-ollama-chat_relationship.h"
 #include "Chat.h"
 #include "Config.h"
 #include "ObjectAccessor.h"
@@ -35,6 +43,7 @@ ChatCommandTable OllamaChatConfigCommand::GetCommands() const
     static ChatCommandTable ollamaReloadCommandTable =
     {
         { "reload",      HandleOllamaReloadCommand,  SEC_ADMINISTRATOR, Console::Yes },
+        { "stats",       HandleOllamaStatsCommand,   SEC_ADMINISTRATOR, Console::Yes },
         { "sentiment",   ollamaSentimentCommandTable },
         { "personality", ollamaPersonalityCommandTable }
     };
@@ -60,7 +69,8 @@ bool OllamaChatConfigCommand::HandleOllamaReloadCommand(ChatHandler* handler)
     }
 
     LoadBotPersonalityList();
-    LoadBotConversationHistoryFromDB();
+    // History is read back per pair on demand
+    UnloadBotConversationHistory();
     InitializeSentimentTracking();
     handler->SendSysMessage("OllamaChat: Configuration reloaded from conf!");
     return true;
@@ -76,28 +86,24 @@ bool OllamaChatConfigCommand::HandleOllamaSentimentViewCommand(ChatHandler* hand
 
     if (!botName && !playerName)
     {
-        // Show all sentiment data
-        std::lock_guard<std::mutex> lock(g_SentimentMutex);
-        if (g_BotPlayerSentiments.empty())
+        // Show all sentiment data held in memory; other pairs are only in the database
+        std::vector<BotPlayerSentiment> sentiments = GetResidentBotPlayerSentiments(0, 0);
+        if (sentiments.empty())
         {
-            handler->SendSysMessage("OllamaChat: No sentiment data found.");
+            handler->SendSysMessage("OllamaChat: No sentiment data in memory.");
             return true;
         }
 
-        handler->SendSysMessage("OllamaChat: All sentiment data:");
-        for (const auto& [botGuid, playerMap] : g_BotPlayerSentiments)
+        handler->SendSysMessage("OllamaChat: All sentiment data in memory:");
+        for (const BotPlayerSentiment& sentiment : sentiments)
         {
-            Player* bot = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-            std::string botNameStr = bot ? bot->GetName() : std::to_string(botGuid);
-            
-            for (const auto& [playerGuid, sentiment] : playerMap)
-            {
-                Player* player = ObjectAccessor::FindPlayer(ObjectGuid(playerGuid));
-                std::string playerNameStr = player ? player->GetName() : std::to_string(playerGuid);
-                
-                handler->SendSysMessage(fmt::format("  Bot '{}' -> Player '{}': {:.3f}", 
-                                        botNameStr, playerNameStr, sentiment));
-            }
+            Player* bot = ObjectAccessor::FindPlayer(ObjectGuid(sentiment.botGuid));
+            std::string botNameStr = bot ? bot->GetName() : std::to_string(sentiment.botGuid);
+            Player* player = ObjectAccessor::FindPlayer(ObjectGuid(sentiment.playerGuid));
+            std::string playerNameStr = player ? player->GetName() : std::to_string(sentiment.playerGuid);
+
+            handler->SendSysMessage(fmt::format("  Bot '{}' -> Player '{}': {:.3f}", 
+                                    botNameStr, playerNameStr, sentiment.value));
         }
         return true;
     }
@@ -134,55 +140,45 @@ bool OllamaChatConfigCommand::HandleOllamaSentimentViewCommand(ChatHandler* hand
     // Show sentiment for specific bot-player pair or all pairs involving a specific bot/player
     if (targetBot && targetPlayer)
     {
-        float sentiment = GetBotPlayerSentiment(targetBot->GetGUID().GetRawValue(), targetPlayer->GetGUID().GetRawValue());
+        // Reads the pair from the database if it is not in memory; one round trip is fine for a GM command
+        float sentiment = LoadBotPlayerSentiment(targetBot->GetGUID().GetRawValue(), targetPlayer->GetGUID().GetRawValue());
         handler->SendSysMessage(fmt::format("OllamaChat: Bot '{}' -> Player '{}': {:.3f}", 
                                 targetBot->GetName(), targetPlayer->GetName(), sentiment));
     }
     else if (targetBot)
     {
         // Show all sentiments for this bot
-        uint64_t botGuid = targetBot->GetGUID().GetRawValue();
-        std::lock_guard<std::mutex> lock(g_SentimentMutex);
-        
-        auto botIt = g_BotPlayerSentiments.find(botGuid);
-        if (botIt == g_BotPlayerSentiments.end() || botIt->second.empty())
+        std::vector<BotPlayerSentiment> sentiments = GetResidentBotPlayerSentiments(targetBot->GetGUID().GetRawValue(), 0);
+        if (sentiments.empty())
         {
-            handler->SendSysMessage(fmt::format("OllamaChat: No sentiment data found for bot '{}'.", targetBot->GetName()));
+            handler->SendSysMessage(fmt::format("OllamaChat: No sentiment data in memory for bot '{}'.", targetBot->GetName()));
             return true;
         }
 
-        handler->SendSysMessage(fmt::format("OllamaChat: Sentiment data for bot '{}':", targetBot->GetName()));
-        for (const auto& [playerGuid, sentiment] : botIt->second)
+        handler->SendSysMessage(fmt::format("OllamaChat: Sentiment data in memory for bot '{}':", targetBot->GetName()));
+        for (const BotPlayerSentiment& sentiment : sentiments)
         {
-            Player* player = ObjectAccessor::FindPlayer(ObjectGuid(playerGuid));
-            std::string playerNameStr = player ? player->GetName() : std::to_string(playerGuid);
-            handler->SendSysMessage(fmt::format("  -> Player '{}': {:.3f}", playerNameStr, sentiment));
+            Player* player = ObjectAccessor::FindPlayer(ObjectGuid(sentiment.playerGuid));
+            std::string playerNameStr = player ? player->GetName() : std::to_string(sentiment.playerGuid);
+            handler->SendSysMessage(fmt::format("  -> Player '{}': {:.3f}", playerNameStr, sentiment.value));
         }
     }
     else if (targetPlayer)
     {
         // Show all sentiments involving this player
-        uint64_t playerGuid = targetPlayer->GetGUID().GetRawValue();
-        std::lock_guard<std::mutex> lock(g_SentimentMutex);
-        
-        bool found = false;
-        handler->SendSysMessage(fmt::format("OllamaChat: Sentiment data involving player '{}':", targetPlayer->GetName()));
-        
-        for (const auto& [botGuid, playerMap] : g_BotPlayerSentiments)
+        std::vector<BotPlayerSentiment> sentiments = GetResidentBotPlayerSentiments(0, targetPlayer->GetGUID().GetRawValue());
+        if (sentiments.empty())
         {
-            auto playerIt = playerMap.find(playerGuid);
-            if (playerIt != playerMap.end())
-            {
-                Player* bot = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                std::string botNameStr = bot ? bot->GetName() : std::to_string(botGuid);
-                handler->SendSysMessage(fmt::format("  Bot '{}' -> {:.3f}", botNameStr, playerIt->second));
-                found = true;
-            }
+            handler->SendSysMessage(fmt::format("OllamaChat: No sentiment data in memory involving player '{}'.", targetPlayer->GetName()));
+            return true;
         }
-        
-        if (!found)
+
+        handler->SendSysMessage(fmt::format("OllamaChat: Sentiment data in memory involving player '{}':", targetPlayer->GetName()));
+        for (const BotPlayerSentiment& sentiment : sentiments)
         {
-            handler->SendSysMessage(fmt::format("OllamaChat: No sentiment data found involving player '{}'.", targetPlayer->GetName()));
+            Player* bot = ObjectAccessor::FindPlayer(ObjectGuid(sentiment.botGuid));
+            std::string botNameStr = bot ? bot->GetName() : std::to_string(sentiment.botGuid);
+            handler->SendSysMessage(fmt::format("  Bot '{}' -> {:.3f}", botNameStr, sentiment.value));
         }
     }
 
@@ -238,15 +234,9 @@ bool OllamaChatConfigCommand::HandleOllamaSentimentResetCommand(ChatHandler* han
 
     if (!botName && !playerName)
     {
-        // Reset all sentiment data
-        std::lock_guard<std::mutex> lock(g_SentimentMutex);
-        uint32_t count = 0;
-        for (const auto& [botGuid, playerMap] : g_BotPlayerSentiments)
-        {
-            count += playerMap.size();
-        }
-        g_BotPlayerSentiments.clear();
-        handler->SendSysMessage(fmt::format("OllamaChat: Reset all sentiment data ({} records).", count));
+        // Reset all sentiment data, in memory and in the database
+        uint32_t count = ResetBotPlayerSentiments(0, 0);
+        handler->SendSysMessage(fmt::format("OllamaChat: Reset all sentiment data ({} records in memory).", count));
         return true;
     }
 
@@ -288,40 +278,15 @@ bool OllamaChatConfigCommand::HandleOllamaSentimentResetCommand(ChatHandler* han
     else if (targetBot)
     {
         // Reset all sentiments for this bot
-        uint64_t botGuid = targetBot->GetGUID().GetRawValue();
-        std::lock_guard<std::mutex> lock(g_SentimentMutex);
-        
-        auto botIt = g_BotPlayerSentiments.find(botGuid);
-        if (botIt != g_BotPlayerSentiments.end())
-        {
-            uint32_t count = botIt->second.size();
-            g_BotPlayerSentiments.erase(botIt);
-            handler->SendSysMessage(fmt::format("OllamaChat: Reset all sentiment data for bot '{}' ({} records).", 
-                                    targetBot->GetName(), count));
-        }
-        else
-        {
-            handler->SendSysMessage(fmt::format("OllamaChat: No sentiment data found for bot '{}'.", targetBot->GetName()));
-        }
+        uint32_t count = ResetBotPlayerSentiments(targetBot->GetGUID().GetRawValue(), 0);
+        handler->SendSysMessage(fmt::format("OllamaChat: Reset all sentiment data for bot '{}' ({} records in memory).", 
+                                targetBot->GetName(), count));
     }
     else if (targetPlayer)
     {
         // Reset all sentiments involving this player
-        uint64_t playerGuid = targetPlayer->GetGUID().GetRawValue();
-        std::lock_guard<std::mutex> lock(g_SentimentMutex);
-        
-        uint32_t count = 0;
-        for (auto& [botGuid, playerMap] : g_BotPlayerSentiments)
-        {
-            auto playerIt = playerMap.find(playerGuid);
-            if (playerIt != playerMap.end())
-            {
-                playerMap.erase(playerIt);
-                count++;
-            }
-        }
-        
-        handler->SendSysMessage(fmt::format("OllamaChat: Reset all sentiment data involving player '{}' ({} records).", 
+        uint32_t count = ResetBotPlayerSentiments(0, targetPlayer->GetGUID().GetRawValue());
+        handler->SendSysMessage(fmt::format("OllamaChat: Reset all sentiment data involving player '{}' ({} records in memory).", 
                                 targetPlayer->GetName(), count));
     }
 
@@ -416,3 +381,79 @@ bool OllamaChatConfigCommand::HandleOllamaPersonalityListCommand(ChatHandler* ha
     
     return true;
 }
+
+bool OllamaChatConfigCommand::HandleOllamaStatsCommand(ChatHandler* handler)
+{
+    LLMAdmissionStats stats = GetLLMAdmissionStats();
+
+    handler->SendSysMessage(fmt::format("OllamaChat: Admission control is {}.", g_EnableAdmissionControl ? "enabled" : "disabled"));
+    for (int source = 0; source < LLM_SOURCE_COUNT; ++source)
+    {
+        handler->SendSysMessage(fmt::format("  {}: admitted {}, rejected {} (source budget {}, global budget {})",
+                                LLMRequestSourceStr[source], stats.admitted[source],
+                                stats.rejectedSource[source] + stats.rejectedGlobal[source],
+                                stats.rejectedSource[source], stats.rejectedGlobal[source]));
+    }
+
+    for (int kind = 0; kind < DB_SAVE_KIND_COUNT; ++kind)
+    {
+        DatabaseSaveStats saveStats = GetDatabaseSaveStats(DatabaseSaveKind(kind));
+        if (!saveStats.saves)
+            continue;
+        handler->SendSysMessage(fmt::format("  {} saves: {}, rows {}, statements {}, avg {} us (last: {} rows, {} us)",
+                                DatabaseSaveKindStr[kind], saveStats.saves, saveStats.rows, saveStats.statements,
+                                saveStats.totalMicros / saveStats.saves, saveStats.lastRows, saveStats.lastMicros));
+    }
+
+    if (IsPersistenceJournalRunning())
+    {
+        PersistenceJournalStats journalStats = GetPersistenceJournalStats();
+        handler->SendSysMessage(fmt::format("  Journal: {} records ({} KiB) since startup, {} queued, {} segments on disk, {} drains (last {} s ago), {} replayed at startup",
+                                journalStats.records, journalStats.bytes / 1024, journalStats.queued, journalStats.segments,
+                                journalStats.drains, journalStats.lastDrain ? time(nullptr) - journalStats.lastDrain : 0,
+                                journalStats.replayedRecords));
+    }
+
+    handler->SendSysMessage(fmt::format("  History pairs in memory: {} (limit {})",
+                            GetResidentHistoryPairCount(), g_MaxResidentHistoryPairs));
+
+    SentimentCacheStats sentimentStats = GetSentimentCacheStats();
+    handler->SendSysMessage(fmt::format("  Sentiment pairs in memory: {} (limit {}), {} unsaved, {} loading",
+                            sentimentStats.resident, g_MaxResidentSentimentPairs, sentimentStats.pendingWrites,
+                            sentimentStats.loading));
+
+    RelationshipTableStats tableStats = GetRelationshipTableStats();
+    size_t tablePairs = tableStats.pairs ? tableStats.pairs : 1;
+    handler->SendSysMessage(fmt::format("  Relationship table: {} pairs in {} shards, {} KiB table ({} bytes/pair), avg probe length {:.2f}",
+                            tableStats.pairs, RELATIONSHIP_SHARD_COUNT, tableStats.tableBytes / 1024, tableStats.tableBytes / tablePairs,
+                            tableStats.averageProbeLength));
+    handler->SendSysMessage(fmt::format("  History storage: {} KiB rings and slabs, {} KiB of text chunks in use",
+                            tableStats.historyBytes / 1024, tableStats.historyTextBytes / 1024));
+
+    if (!g_LockTimingEnabled)
+        handler->SendSysMessage("  Lock timing: off (OllamaChat.EnableLockTiming)");
+    for (int lock = 0; g_LockTimingEnabled && lock < TRACKED_LOCK_COUNT; ++lock)
+    {
+        handler->SendSysMessage(fmt::format("  {} lock: {}; waits: {}", TrackedLockStr[lock],
+                                GetLockHoldHistogram(TrackedLock(lock)).Describe(),
+                                GetLockWaitHistogram(TrackedLock(lock)).Describe("waits")));
+    }
+
+    if (g_OllamaApiBackend == OLLAMA_BACKEND_CONTEXT)
+    {
+        ConversationContextStats contextStats = GetConversationContextStats();
+        handler->SendSysMessage(fmt::format("OllamaChat: {} stored conversation contexts, {} tokens (limit {} contexts, {} tokens each)",
+                                contextStats.contexts, contextStats.tokens, g_MaxStoredContexts, g_MaxContextTokens));
+    }
+
+    if (g_LogPromptEvalStats)
+    {
+        OllamaPromptEvalStats evalStats = GetOllamaPromptEvalStats();
+        uint64_t responses = evalStats.responses ? evalStats.responses : 1;
+        handler->SendSysMessage(fmt::format("OllamaChat: {} responses, avg prompt_eval_count {}, avg prompt_eval_duration {:.1f} ms, avg eval_count {}, avg eval_duration {:.1f} ms",
+                                evalStats.responses, evalStats.promptEvalCount / responses, evalStats.promptEvalDurationNs / 1e6 / responses,
+                                evalStats.evalCount / responses, evalStats.evalDurationNs / 1e6 / responses));
+    }
+
+    return true;
+}
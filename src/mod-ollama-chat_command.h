@@ -17,6 +17,7 @@ public:
     static bool HandleOllamaPersonalityGetCommand(ChatHandler* handler, std::string botName);
     static bool HandleOllamaPersonalitySetCommand(ChatHandler* handler, std::string botName, std::string personality);
     static bool HandleOllamaPersonalityListCommand(ChatHandler* handler);
+    static bool HandleOllamaStatsCommand(ChatHandler* handler);
 };
 
 #endif // MOD_OLLAMA_CHAT_COMMAND_H
@@ -1,12 +1,18 @@
 #include "mod-ollama-chat_config.h"
 #include "mod-ollama-chat_sentiment.h"
 #include "mod-ollama-chat_rag.h"
+#include "mod-ollama-chat_blacklist.h"
+#include "mod-ollama-chat_admission.h"
+#include "mod-ollama-chat_journal.h"
+#include "mod-ollama-chat_lockstats.h"
+#include "mod-ollama-chat_personality.h"
 #include "Config.h"
 #include "Log.h"
 #include "mod-ollama-chat_api.h"
 #include <fmt/core.h>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
 
 
 // --------------------------------------------
@@ -25,6 +31,8 @@ uint32_t   g_BotReplyChance    = 10;
 uint32_t   g_MaxBotsToPick     = 2;
 uint32_t   g_RandomChatterBotCommentChance   = 5;
 uint32_t   g_RandomChatterMaxBotsPerPlayer   = 2;
+uint32_t   g_RandomChatterMaxBotsPerTick     = 5;
+uint32_t   g_RandomChatterTickBudgetUs       = 2000;
 uint32_t   g_EventChatterBotCommentChance    = 15;
 uint32_t   g_EventChatterBotSelfCommentChance = 5;
 uint32_t   g_EventChatterMaxBotsPerPlayer    = 2;
@@ -43,12 +51,30 @@ uint32_t    g_OllamaNumThreads = 0;
 std::string g_OllamaStop = "";
 std::string g_OllamaSystemPrompt = "";
 std::string g_OllamaSeed = "";
+bool        g_LogPromptEvalStats = false;
+OllamaApiBackend g_OllamaApiBackend = OLLAMA_BACKEND_GENERATE;
+std::string g_OllamaChatUrl = "http://localhost:11434/api/chat";
+uint32_t    g_MaxStoredContexts = 500;
+uint32_t    g_MaxContextTokens = 4096;
 
 // --------------------------------------------
 // Concurrency/Queueing
 // --------------------------------------------
 uint32_t    g_MaxConcurrentQueries = 0;
 
+// --------------------------------------------
+// LLM Request Admission Control
+// --------------------------------------------
+bool        g_EnableAdmissionControl  = false;
+float       g_ChatRequestsPerSecond   = 2.0f;
+uint32_t    g_ChatRequestBurst        = 6;
+float       g_EventRequestsPerSecond  = 1.0f;
+uint32_t    g_EventRequestBurst       = 3;
+float       g_RandomRequestsPerSecond = 0.5f;
+uint32_t    g_RandomRequestBurst      = 2;
+float       g_GlobalRequestsPerSecond = 3.0f;
+uint32_t    g_GlobalRequestBurst      = 8;
+
 // --------------------------------------------
 // Feature Toggles & Core Settings
 // --------------------------------------------
@@ -76,6 +102,14 @@ uint32_t    g_MaxRandomInterval               = 180;
 // --------------------------------------------
 uint32_t    g_MaxConversationHistory          = 5;
 uint32_t    g_ConversationHistorySaveInterval = 10;
+uint32_t    g_DatabaseBatchSize               = 500;
+uint32_t    g_MaxResidentHistoryPairs         = 10000;
+uint32_t    g_ChatHistoryMaxMessageLength     = 0;
+uint32_t    g_ChatHistoryMaxReplyLength       = 0;
+bool        g_EnablePersistenceJournal        = false;
+std::string g_PersistenceJournalPath          = "mod_ollama_chat.journal";
+uint32_t    g_PersistenceDrainInterval        = 10;
+bool        g_PersistenceJournalSync          = false;
 
 // --------------------------------------------
 // Prompt Templates
@@ -84,10 +118,29 @@ std::string g_RandomChatterPromptTemplate;
 std::string g_EventChatterPromptTemplate;
 std::string g_ChatPromptTemplate;
 std::string g_ChatExtraInfoTemplate;
+std::string g_ChatPersonaTemplate;
+
+std::vector<ChatPromptSection> g_ChatPromptSectionOrder = {
+    CHAT_PROMPT_SECTION_PERSONA, CHAT_PROMPT_SECTION_PROMPT, CHAT_PROMPT_SECTION_RAG, CHAT_PROMPT_SECTION_SNAPSHOT
+};
+bool        g_ChatPersonaInSystem = true;
+
+// Current template set. Readers copy the pointer under the mutex and render without
+// holding it; a reload swaps in a new set and the old one lives until its last render ends.
+static std::shared_ptr<const PromptTemplates> s_PromptTemplates = std::make_shared<PromptTemplates>();
+static std::mutex s_PromptTemplatesMutex;
+
+std::shared_ptr<const PromptTemplates> GetPromptTemplates()
+{
+    std::lock_guard<std::mutex> lock(s_PromptTemplatesMutex);
+    return s_PromptTemplates;
+}
 
 // --------------------------------------------
 // Personality and Prompt Data
 // --------------------------------------------
+std::shared_mutex g_BotPersonalityMutex;
+bool g_BotPersonalityTableExists = false;
 std::unordered_map<uint64_t, std::string> g_BotPersonalityList;
 std::unordered_map<std::string, std::string> g_PersonalityPrompts;
 std::vector<std::string> g_PersonalityKeys;
@@ -107,12 +160,19 @@ std::string g_ChatHistoryFooterTemplate;
 // --------------------------------------------
 bool        g_EnableChatBotSnapshotTemplate  = false;
 std::string g_ChatBotSnapshotTemplate;
+bool        g_EnableSnapshotCache            = true;
+uint32_t    g_SnapshotCombatTTLMs            = 0;
+uint32_t    g_SnapshotGroupTTLMs             = 2000;
+uint32_t    g_SnapshotSpellsTTLMs            = 5000;
+uint32_t    g_SnapshotQuestsTTLMs            = 30000;
+uint32_t    g_SnapshotLosTTLMs               = 5000;
+uint32_t    g_SnapshotPlayersTTLMs           = 3000;
+uint32_t    g_SnapshotRefreshPerTick         = 4;
+uint32_t    g_SnapshotMaxVisibleObjects      = 20;
 
 // --------------------------------------------
-// Conversation History Store and Mutex
+// Conversation History Save Time
 // --------------------------------------------
-std::unordered_map<uint64_t, std::unordered_map<uint64_t, std::deque<std::pair<std::string, std::string>>>> g_BotConversationHistory;
-std::mutex g_ConversationHistoryMutex;
 time_t g_LastHistorySaveTime = 0;
 
 // --------------------------------------------
@@ -125,9 +185,8 @@ uint32_t    g_SentimentSaveInterval = 10;                // How often to save se
 std::string g_SentimentAnalysisPrompt = "Analyze the sentiment of this message: \"{message}\". Respond only with: POSITIVE, NEGATIVE, or NEUTRAL.";
 std::string g_SentimentPromptTemplate = "Your relationship sentiment with {player_name} is {sentiment_value} (0.0=hostile, 0.5=neutral, 1.0=friendly). Use this to guide your tone and response.";
 
-// In-memory sentiment storage and mutex
-std::unordered_map<uint64_t, std::unordered_map<uint64_t, float>> g_BotPlayerSentiments;
-std::mutex g_SentimentMutex;
+uint32_t    g_MaxResidentSentimentPairs = 10000;
+
 time_t g_LastSentimentSaveTime = 0;
 
 // --------------------------------------------
@@ -138,6 +197,7 @@ std::string g_RAGDataPath = "rag/";
 uint32_t    g_RAGMaxRetrievedItems = 3;
 float       g_RAGSimilarityThreshold = 0.3f;
 std::string g_RAGPromptTemplate;
+bool        g_RAGAppendToPrompt = true;
 
 class OllamaRAGSystem;
 OllamaRAGSystem* g_RAGSystem = nullptr;
@@ -145,10 +205,11 @@ OllamaRAGSystem* g_RAGSystem = nullptr;
 // --------------------------------------------
 // Blacklist: Prefixes for Commands (not chat)
 // --------------------------------------------
-std::vector<std::string> g_BlacklistCommands = {
+static const std::vector<std::string> s_DefaultBlacklistCommands = {
     ".playerbots",
     "playerbot",
 };
+std::vector<std::string> g_BlacklistCommands = s_DefaultBlacklistCommands;
 
 // --------------------------------------------
 // Environment/Contextual Random Chatter Templates
@@ -165,6 +226,7 @@ std::vector<std::string> g_EnvCommentQuestgiver;
 std::vector<std::string> g_EnvCommentBagSlots;
 std::vector<std::string> g_EnvCommentDungeon;
 std::vector<std::string> g_EnvCommentUnfinishedQuest;
+std::unordered_map<std::string, uint32_t> g_EnvCommentWeights;
 
 // --------------------------------------------
 // Guild-Specific Random Chatter Templates
@@ -192,65 +254,38 @@ uint32_t    g_GuildChatterBotCommentChance          = 25;
 uint32_t    g_GuildChatterMaxBotsPerEvent           = 2;
 
 // --------------------------------------------
-// Guild-Specific Event Chatter Templates
-// --------------------------------------------
-std::string g_GuildEventTypeLevelUp = "";
-std::string g_GuildEventTypeDungeonComplete = "";
-std::string g_GuildEventTypeEpicGear = "";
-std::string g_GuildEventTypeRareGear = "";
-std::string g_GuildEventTypeGuildJoin = "";
-std::string g_GuildEventTypeGuildLeave = "";
-std::string g_GuildEventTypeGuildPromotion = "";
-std::string g_GuildEventTypeGuildDemotion = "";
-std::string g_GuildEventTypeGuildLogin = "";
-std::string g_GuildEventTypeGuildAchievement = "";
-
-// --------------------------------------------
-// Event Chatter Templates
-// --------------------------------------------
-std::string g_EventTypeDefeated;           // "defeated"
-std::string g_EventTypeDefeatedPlayer;     // "defeated player"
-std::string g_EventTypePetDefeated;        // "pet defeated"
-std::string g_EventTypeGotItem;            // "got item"
-std::string g_EventTypeDied;               // "died"
-std::string g_EventTypeCompletedQuest;     // "completed quest"
-std::string g_EventTypeLearnedSpell;       // "learned spell"
-std::string g_EventTypeRequestedDuel;      // "requested to duel"
-std::string g_EventTypeStartedDueling;     // "started dueling"
-std::string g_EventTypeWonDuel;            // "won duel against"
-std::string g_EventTypeLeveledUp;          // "leveled up"
-std::string g_EventTypeAchievement;        // "earned achievement"
-std::string g_EventTypeUsedObject;         // "used object"
-
-// Chance variables for normal events
-int g_EventTypeDefeated_Chance = 0;
-int g_EventTypeDefeatedPlayer_Chance = 0;
-int g_EventTypePetDefeated_Chance = 0;
-int g_EventTypeGotItem_Chance = 0;
-int g_EventTypeDied_Chance = 0;
-int g_EventTypeCompletedQuest_Chance = 0;
-int g_EventTypeLearnedSpell_Chance = 0;
-int g_EventTypeRequestedDuel_Chance = 0;
-int g_EventTypeStartedDueling_Chance = 0;
-int g_EventTypeWonDuel_Chance = 0;
-int g_EventTypeLeveledUp_Chance = 0;
-int g_EventTypeAchievement_Chance = 0;
-int g_EventTypeUsedObject_Chance = 0;
-
-// Chance variables for guild events
-int g_GuildEventTypeEpicGear_Chance = 0;
-int g_GuildEventTypeRareGear_Chance = 0;
-int g_GuildEventTypeGuildJoin_Chance = 0;
-int g_GuildEventTypeGuildLogin_Chance = 0;
-int g_GuildEventTypeGuildLeave_Chance = 0;
-int g_GuildEventTypeGuildPromotion_Chance = 0;
-int g_GuildEventTypeGuildDemotion_Chance = 0;
-int g_GuildEventTypeGuildAchievement_Chance = 0;
-int g_GuildEventTypeLevelUp_Chance = 0;
-int g_GuildEventTypeDungeonComplete_Chance = 0;
+// Event Chatter: Event Type Table (indexed by OllamaEventType)
+// --------------------------------------------
+EventTypeConfig g_EventTypes[EVENT_TYPE_COUNT] =
+{
+    { "EventTypeDefeated",              false },
+    { "EventTypeDefeatedPlayer",        false },
+    { "EventTypePetDefeated",           false },
+    { "EventTypeGotItem",               false },
+    { "EventTypeDied",                  false },
+    { "EventTypeCompletedQuest",        false },
+    { "EventTypeLearnedSpell",          false },
+    { "EventTypeRequestedDuel",         false },
+    { "EventTypeStartedDueling",        false },
+    { "EventTypeWonDuel",               false },
+    { "EventTypeLeveledUp",             false },
+    { "EventTypeAchievement",           false },
+    { "EventTypeUsedObject",            false },
+    { "GuildEventTypeLevelUp",          true  },
+    { "GuildEventTypeDungeonComplete",  true  },
+    { "GuildEventTypeEpicGear",         true  },
+    { "GuildEventTypeRareGear",         true  },
+    { "GuildEventTypeGuildJoin",        true  },
+    { "GuildEventTypeGuildLeave",       true  },
+    { "GuildEventTypeGuildPromotion",   true  },
+    { "GuildEventTypeGuildDemotion",    true  },
+    { "GuildEventTypeGuildLogin",       true  },
+    { "GuildEventTypeGuildAchievement", true  },
+};
 
 // Event Cooldown
 uint32_t g_EventCooldownTime = 10;
+uint32_t g_EventCoalesceWindowMs = 3000;
 
 // --------------------------------------------
 // Party Restriction Settings
@@ -274,14 +309,23 @@ static std::vector<std::string> SplitString(const std::string& str, char delim)
     return tokens;
 }
 
+// Let's make sure our user has sourced the required sql file to add the new table.
+// Checked once at startup; the table is not created while the server runs.
+void CheckBotPersonalityTable()
+{
+    QueryResult tableExists = CharacterDatabase.Query("SELECT 1 FROM information_schema.tables WHERE table_schema = DATABASE() AND table_name = 'mod_ollama_chat_personality' LIMIT 1");
+    g_BotPersonalityTableExists = bool(tableExists);
+    if (!g_BotPersonalityTableExists)
+    {
+        LOG_ERROR("server.loading", "[Ollama Chat] Please source the required database table first");
+    }
+}
+
 // Load Bot Personalities from Database
 void LoadBotPersonalityList()
 {    
-    // Let's make sure our user has sourced the required sql file to add the new table
-    QueryResult tableExists = CharacterDatabase.Query("SELECT * FROM information_schema.tables WHERE table_schema = 'acore_characters' AND table_name = 'mod_ollama_chat_personality' LIMIT 1");
-    if (!tableExists)
+    if (!g_BotPersonalityTableExists)
     {
-        LOG_ERROR("server.loading", "[Ollama Chat] Please source the required database table first");
         return;
     }
 
@@ -301,12 +345,17 @@ void LoadBotPersonalityList()
         LOG_INFO("server.loading", "[Ollama Chat] Fetching Bot Personality List into array");
     }
 
+    // Read before taking the lock, so replies are not held up by the query
+    std::vector<std::pair<uint64_t, std::string>> stored;
+    stored.reserve(result->GetRowCount());
     do
     {
         uint64_t personalityBotGUID = result->Fetch()[0].Get<uint64_t>();
         std::string personalityKey = result->Fetch()[1].Get<std::string>();
-        g_BotPersonalityList[personalityBotGUID] = personalityKey;
+        stored.emplace_back(personalityBotGUID, personalityKey);
     } while (result->NextRow());
+
+    SetStoredBotPersonalities(stored);
 }
 
 std::string GetMultiLineConfigValue(const std::string& configFilePath, const std::string& key)
@@ -347,6 +396,50 @@ std::string GetMultiLineConfigValue(const std::string& configFilePath, const std
     return value;
 }
 
+static void CompilePromptTemplate(CompiledPromptTemplate& compiled, const std::string& source, const std::string& key,
+                                  std::initializer_list<PromptVar> allowed)
+{
+    std::string error;
+    if (!compiled.Compile(source, allowed, &error))
+        LOG_ERROR("server.loading", "[Ollama Chat] {} is invalid and will not be used: {}", key, error);
+}
+
+// Parses OllamaChat.ChatPromptSectionOrder. Unknown names are reported and skipped;
+// sections left out are not added to the prompt.
+static std::vector<ChatPromptSection> ParseChatPromptSectionOrder(const std::string& value)
+{
+    static const char* sectionNames[CHAT_PROMPT_SECTION_COUNT] = { "persona", "prompt", "rag", "snapshot" };
+
+    std::vector<ChatPromptSection> order;
+    std::stringstream ss(value);
+    std::string name;
+    while (std::getline(ss, name, ','))
+    {
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (name.empty())
+            continue;
+
+        int section = 0;
+        while (section < CHAT_PROMPT_SECTION_COUNT && name != sectionNames[section])
+            ++section;
+        if (section == CHAT_PROMPT_SECTION_COUNT)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] OllamaChat.ChatPromptSectionOrder: unknown section '{}' ignored", name);
+            continue;
+        }
+        if (std::find(order.begin(), order.end(), ChatPromptSection(section)) == order.end())
+            order.push_back(ChatPromptSection(section));
+    }
+
+    if (std::find(order.begin(), order.end(), CHAT_PROMPT_SECTION_PROMPT) == order.end())
+    {
+        LOG_ERROR("server.loading", "[Ollama Chat] OllamaChat.ChatPromptSectionOrder has no 'prompt' section, using the default order");
+        order = { CHAT_PROMPT_SECTION_PERSONA, CHAT_PROMPT_SECTION_PROMPT, CHAT_PROMPT_SECTION_RAG, CHAT_PROMPT_SECTION_SNAPSHOT };
+    }
+    return order;
+}
+
 void LoadOllamaChatConfig()
 {
     g_SayDistance                     = sConfigMgr->GetOption<float>("OllamaChat.SayDistance", 30.0f);
@@ -365,9 +458,45 @@ void LoadOllamaChatConfig()
     g_OllamaStop                      = sConfigMgr->GetOption<std::string>("OllamaChat.Stop", "");
     g_OllamaSystemPrompt              = sConfigMgr->GetOption<std::string>("OllamaChat.SystemPrompt", "");
     g_OllamaSeed                      = sConfigMgr->GetOption<std::string>("OllamaChat.Seed", "");
+    g_LogPromptEvalStats              = sConfigMgr->GetOption<bool>("OllamaChat.LogPromptEvalStats", false);
+
+    std::string apiBackend            = sConfigMgr->GetOption<std::string>("OllamaChat.ApiBackend", "generate");
+    if (apiBackend == "chat")
+        g_OllamaApiBackend = OLLAMA_BACKEND_CHAT;
+    else if (apiBackend == "context")
+        g_OllamaApiBackend = OLLAMA_BACKEND_CONTEXT;
+    else
+    {
+        if (apiBackend != "generate")
+            LOG_ERROR("server.loading", "[Ollama Chat] Unknown OllamaChat.ApiBackend '{}', using generate", apiBackend);
+        g_OllamaApiBackend = OLLAMA_BACKEND_GENERATE;
+    }
+
+    // Defaults to the /api/chat endpoint on the same server as OllamaChat.Url
+    g_OllamaChatUrl                   = sConfigMgr->GetOption<std::string>("OllamaChat.ChatUrl", "");
+    if (g_OllamaChatUrl.empty())
+    {
+        g_OllamaChatUrl = g_OllamaUrl;
+        size_t apiPos = g_OllamaChatUrl.rfind("/api/");
+        if (apiPos != std::string::npos)
+            g_OllamaChatUrl.erase(apiPos);
+        g_OllamaChatUrl += "/api/chat";
+    }
+    g_MaxStoredContexts               = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxStoredContexts", 500);
+    g_MaxContextTokens                = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxContextTokens", 4096);
 
     g_MaxConcurrentQueries            = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxConcurrentQueries", 0);
 
+    g_EnableAdmissionControl          = sConfigMgr->GetOption<bool>("OllamaChat.EnableAdmissionControl", false);
+    g_ChatRequestsPerSecond           = sConfigMgr->GetOption<float>("OllamaChat.ChatRequestsPerSecond", 2.0f);
+    g_ChatRequestBurst                = sConfigMgr->GetOption<uint32_t>("OllamaChat.ChatRequestBurst", 6);
+    g_EventRequestsPerSecond          = sConfigMgr->GetOption<float>("OllamaChat.EventRequestsPerSecond", 1.0f);
+    g_EventRequestBurst               = sConfigMgr->GetOption<uint32_t>("OllamaChat.EventRequestBurst", 3);
+    g_RandomRequestsPerSecond         = sConfigMgr->GetOption<float>("OllamaChat.RandomRequestsPerSecond", 0.5f);
+    g_RandomRequestBurst              = sConfigMgr->GetOption<uint32_t>("OllamaChat.RandomRequestBurst", 2);
+    g_GlobalRequestsPerSecond         = sConfigMgr->GetOption<float>("OllamaChat.GlobalRequestsPerSecond", 3.0f);
+    g_GlobalRequestBurst              = sConfigMgr->GetOption<uint32_t>("OllamaChat.GlobalRequestBurst", 8);
+
     g_Enable                          = sConfigMgr->GetOption<bool>("OllamaChat.Enable", true);
     g_DisableRepliesInCombat          = sConfigMgr->GetOption<bool>("OllamaChat.DisableRepliesInCombat", true);
     g_EnableRandomChatter             = sConfigMgr->GetOption<bool>("OllamaChat.EnableRandomChatter", true);
@@ -381,6 +510,8 @@ void LoadOllamaChatConfig()
     g_RandomChatterRealPlayerDistance = sConfigMgr->GetOption<float>("OllamaChat.RandomChatterRealPlayerDistance", 40.0f);
     g_RandomChatterBotCommentChance   = sConfigMgr->GetOption<uint32_t>("OllamaChat.RandomChatterBotCommentChance", 25);
     g_RandomChatterMaxBotsPerPlayer   = sConfigMgr->GetOption<uint32_t>("OllamaChat.RandomChatterMaxBotsPerPlayer", 2);
+    g_RandomChatterMaxBotsPerTick     = sConfigMgr->GetOption<uint32_t>("OllamaChat.RandomChatterMaxBotsPerTick", 5);
+    g_RandomChatterTickBudgetUs       = sConfigMgr->GetOption<uint32_t>("OllamaChat.RandomChatterTickBudgetUs", 2000);
 
     g_EnableGuildRandomAmbientChatter = sConfigMgr->GetOption<bool>("OllamaChat.EnableGuildRandomAmbientChatter", true);
     g_GuildRandomChatterChance        = sConfigMgr->GetOption<uint32_t>("OllamaChat.GuildRandomChatterChance", 10);
@@ -400,10 +531,24 @@ void LoadOllamaChatConfig()
     
     g_ChatExtraInfoTemplate           = sConfigMgr->GetOption<std::string>("OllamaChat.ChatExtraInfoTemplate", "");
 
+    g_ChatPersonaTemplate             = sConfigMgr->GetOption<std::string>("OllamaChat.ChatPersonaTemplate", "");
+    g_ChatPersonaInSystem             = sConfigMgr->GetOption<std::string>("OllamaChat.ChatPersonaPlacement", "system") != "prompt";
+    g_ChatPromptSectionOrder          = ParseChatPromptSectionOrder(
+        sConfigMgr->GetOption<std::string>("OllamaChat.ChatPromptSectionOrder", "persona,prompt,rag,snapshot"));
+
     g_DefaultPersonalityPrompt        = sConfigMgr->GetOption<std::string>("OllamaChat.DefaultPersonalityPrompt", "");
 
     g_MaxConversationHistory          = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxConversationHistory", 5);
     g_ConversationHistorySaveInterval = sConfigMgr->GetOption<uint32_t>("OllamaChat.ConversationHistorySaveInterval", 10);
+    g_DatabaseBatchSize               = sConfigMgr->GetOption<uint32_t>("OllamaChat.DatabaseBatchSize", 500);
+    g_LockTimingEnabled               = sConfigMgr->GetOption<bool>("OllamaChat.EnableLockTiming", false);
+    g_MaxResidentHistoryPairs         = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxResidentHistoryPairs", 10000);
+    g_ChatHistoryMaxMessageLength     = sConfigMgr->GetOption<uint32_t>("OllamaChat.ChatHistoryMaxMessageLength", 0);
+    g_ChatHistoryMaxReplyLength       = sConfigMgr->GetOption<uint32_t>("OllamaChat.ChatHistoryMaxReplyLength", 0);
+    g_EnablePersistenceJournal        = sConfigMgr->GetOption<bool>("OllamaChat.EnablePersistenceJournal", false);
+    g_PersistenceJournalPath          = sConfigMgr->GetOption<std::string>("OllamaChat.PersistenceJournalPath", "mod_ollama_chat.journal");
+    g_PersistenceDrainInterval        = sConfigMgr->GetOption<uint32_t>("OllamaChat.PersistenceDrainInterval", 10);
+    g_PersistenceJournalSync          = sConfigMgr->GetOption<bool>("OllamaChat.PersistenceJournalSync", false);
 
     g_ChatHistoryHeaderTemplate       = sConfigMgr->GetOption<std::string>("OllamaChat.ChatHistoryHeaderTemplate", "");
     g_ChatHistoryLineTemplate         = sConfigMgr->GetOption<std::string>("OllamaChat.ChatHistoryLineTemplate", "");
@@ -411,6 +556,15 @@ void LoadOllamaChatConfig()
 
     g_EnableChatBotSnapshotTemplate   = sConfigMgr->GetOption<bool>("OllamaChat.EnableChatBotSnapshotTemplate", false);
     g_ChatBotSnapshotTemplate         = sConfigMgr->GetOption<std::string>("OllamaChat.ChatBotSnapshotTemplate", "");
+    g_EnableSnapshotCache             = sConfigMgr->GetOption<bool>("OllamaChat.EnableSnapshotCache", true);
+    g_SnapshotCombatTTLMs             = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotCombatTTLMs", 0);
+    g_SnapshotGroupTTLMs              = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotGroupTTLMs", 2000);
+    g_SnapshotSpellsTTLMs             = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotSpellsTTLMs", 5000);
+    g_SnapshotQuestsTTLMs             = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotQuestsTTLMs", 30000);
+    g_SnapshotLosTTLMs                = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotLosTTLMs", 5000);
+    g_SnapshotPlayersTTLMs            = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotPlayersTTLMs", 3000);
+    g_SnapshotRefreshPerTick          = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotRefreshPerTick", 4);
+    g_SnapshotMaxVisibleObjects       = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotMaxVisibleObjects", 20);
 
     g_EnableChatHistory               = sConfigMgr->GetOption<bool>("OllamaChat.EnableChatHistory", true);
 
@@ -421,6 +575,7 @@ void LoadOllamaChatConfig()
     g_SentimentSaveInterval           = sConfigMgr->GetOption<uint32_t>("OllamaChat.SentimentSaveInterval", 10);
     g_SentimentAnalysisPrompt         = sConfigMgr->GetOption<std::string>("OllamaChat.SentimentAnalysisPrompt", "Analyze the sentiment of this message: \"{message}\". Respond only with: POSITIVE, NEGATIVE, or NEUTRAL.");
     g_SentimentPromptTemplate         = sConfigMgr->GetOption<std::string>("OllamaChat.SentimentPromptTemplate", "Your relationship sentiment with {player_name} is {sentiment_value} (0.0=hostile, 0.5=neutral, 1.0=friendly). Use this to guide your tone and response.");
+    g_MaxResidentSentimentPairs       = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxResidentSentimentPairs", 10000);
 
     // RAG (Retrieval-Augmented Generation) System
     g_EnableRAG                       = sConfigMgr->GetOption<bool>("OllamaChat.EnableRAG", false);
@@ -428,25 +583,13 @@ void LoadOllamaChatConfig()
     g_RAGMaxRetrievedItems            = sConfigMgr->GetOption<uint32_t>("OllamaChat.RAGMaxRetrievedItems", 3);
     g_RAGSimilarityThreshold          = sConfigMgr->GetOption<float>("OllamaChat.RAGSimilarityThreshold", 0.3f);
     g_RAGPromptTemplate               = sConfigMgr->GetOption<std::string>("OllamaChat.RAGPromptTemplate", "RELEVANT INFORMATION:\n{rag_info}\nUse this information to provide accurate and detailed responses when applicable.");
+    g_RAGAppendToPrompt               = sConfigMgr->GetOption<bool>("OllamaChat.RAGAppendToPrompt", true);
 
     g_ThinkModeEnableForModule        = sConfigMgr->GetOption<bool>("OllamaChat.ThinkModeEnableForModule", false);
 
-    g_EventTypeDefeated           = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeDefeated", "");
-    g_EventTypeDefeatedPlayer     = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeDefeatedPlayer", "");
-    g_EventTypePetDefeated        = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypePetDefeated", "");
-    g_EventTypeGotItem            = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeGotItem", "");
-    g_EventTypeDied               = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeDied", "");
-    g_EventTypeCompletedQuest     = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeCompletedQuest", "");
-    g_EventTypeLearnedSpell       = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeLearnedSpell", "");
-    g_EventTypeRequestedDuel      = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeRequestedDuel", "");
-    g_EventTypeStartedDueling     = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeStartedDueling", "");
-    g_EventTypeWonDuel            = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeWonDuel", "");
-    g_EventTypeLeveledUp          = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeLeveledUp", "");
-    g_EventTypeAchievement        = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeAchievement", "");
-    g_EventTypeUsedObject         = sConfigMgr->GetOption<std::string>("OllamaChat.EventTypeUsedObject", "");
-
-
-    // Load extra blacklist commands from config (comma-separated list)
+    // Load extra blacklist commands from config (comma-separated list).
+    // Start from the defaults so a reload does not append the same prefixes again.
+    g_BlacklistCommands = s_DefaultBlacklistCommands;
     std::string extraBlacklist = sConfigMgr->GetOption<std::string>("OllamaChat.BlacklistCommands", "");
     if (!extraBlacklist.empty())
     {
@@ -456,10 +599,13 @@ void LoadOllamaChatConfig()
             g_BlacklistCommands.push_back(cmd);
         }
     }
+    // Compile the prefixes into a trie and swap it in for ProcessChat
+    RebuildBlacklistTrie(g_BlacklistCommands);
 
     LoadPersonalityTemplatesFromDB();
 
     g_queryManager.setMaxConcurrentQueries(g_MaxConcurrentQueries);
+    ConfigureLLMAdmission();
 
     // Loads the environment random chatter message templates for each type.
     // Each config option is a pipe-separated list of string templates,
@@ -496,6 +642,26 @@ void LoadOllamaChatConfig()
     g_EnvCommentDungeon         = LoadEnvCommentVector("OllamaChat.EnvCommentDungeon", { "" });
     g_EnvCommentUnfinishedQuest = LoadEnvCommentVector("OllamaChat.EnvCommentUnfinishedQuest", { "" });
 
+    // Category weights, e.g. "creature=1,spell=2,guild=0". Unlisted categories keep their default weight.
+    g_EnvCommentWeights.clear();
+    for (const std::string& pair : SplitString(sConfigMgr->GetOption<std::string>("OllamaChat.EnvCommentWeights", ""), ','))
+    {
+        size_t eq = pair.find('=');
+        if (eq == std::string::npos)
+            continue;
+        std::string name = pair.substr(0, eq);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        try
+        {
+            g_EnvCommentWeights[name] = static_cast<uint32_t>(std::stoul(pair.substr(eq + 1)));
+        }
+        catch (const std::exception&)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] Invalid weight in OllamaChat.EnvCommentWeights: '{}'", pair);
+        }
+    }
+
     // Guild-specific random chatter templates
     g_GuildEnvCommentGuildMember = LoadEnvCommentVector("OllamaChat.GuildEnvCommentGuildMember", { "" });
     g_GuildEnvCommentGuildRank = LoadEnvCommentVector("OllamaChat.GuildEnvCommentGuildRank", { "" });
@@ -515,47 +681,64 @@ void LoadOllamaChatConfig()
     g_GuildChatterBotCommentChance = sConfigMgr->GetOption<uint32_t>("OllamaChat.GuildChatterBotCommentChance", 25);
     g_GuildChatterMaxBotsPerEvent = sConfigMgr->GetOption<uint32_t>("OllamaChat.GuildChatterMaxBotsPerEvent", 2);
 
-    // Guild-specific event templates
-    g_GuildEventTypeLevelUp = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeLevelUp", "");
-    g_GuildEventTypeDungeonComplete = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeDungeonComplete", "");
-    g_GuildEventTypeEpicGear = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeEpicGear", "");
-    g_GuildEventTypeRareGear = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeRareGear", "");
-    g_GuildEventTypeGuildJoin = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeGuildJoin", "");
-    g_GuildEventTypeGuildLogin = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeGuildLogin", "");
-    g_GuildEventTypeGuildLeave = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeGuildLeave", "");
-    g_GuildEventTypeGuildPromotion = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeGuildPromotion", "");
-    g_GuildEventTypeGuildDemotion = sConfigMgr->GetOption<std::string>("OllamaChat.GuildEventTypeGuildDemotion", "");
-
-    // Load chance variables for normal events
-    g_EventTypeDefeated_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeDefeated_Chance", 0);
-    g_EventTypeDefeatedPlayer_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeDefeatedPlayer_Chance", 0);
-    g_EventTypePetDefeated_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypePetDefeated_Chance", 0);
-    g_EventTypeGotItem_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeGotItem_Chance", 0);
-    g_EventTypeDied_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeDied_Chance", 0);
-    g_EventTypeCompletedQuest_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeCompletedQuest_Chance", 0);
-    g_EventTypeLearnedSpell_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeLearnedSpell_Chance", 0);
-    g_EventTypeRequestedDuel_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeRequestedDuel_Chance", 0);
-    g_EventTypeStartedDueling_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeStartedDueling_Chance", 0);
-    g_EventTypeWonDuel_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeWonDuel_Chance", 0);
-    g_EventTypeLeveledUp_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeLeveledUp_Chance", 0);
-    g_EventTypeAchievement_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeAchievement_Chance", 0);
-    g_EventTypeUsedObject_Chance = sConfigMgr->GetOption<int>("OllamaChat.EventTypeUsedObject_Chance", 0);
-
-    // Load chance variables for guild events
-    g_GuildEventTypeEpicGear_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeEpicGear_Chance", 0);
-    g_GuildEventTypeRareGear_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeRareGear_Chance", 0);
-    g_GuildEventTypeGuildJoin_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeGuildJoin_Chance", 0);
-    g_GuildEventTypeGuildLogin_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeGuildLogin_Chance", 0);
-    g_GuildEventTypeGuildLeave_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeGuildLeave_Chance", 0);
-    g_GuildEventTypeGuildPromotion_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeGuildPromotion_Chance", 0);
-    g_GuildEventTypeGuildDemotion_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeGuildDemotion_Chance", 0);
-    g_GuildEventTypeGuildAchievement_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeGuildAchievement_Chance", 0);
-    g_GuildEventTypeLevelUp_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeLevelUp_Chance", 0);
-    g_GuildEventTypeDungeonComplete_Chance = sConfigMgr->GetOption<int>("OllamaChat.GuildEventTypeDungeonComplete_Chance", 0);
-
-
     // Cooldown time for events
     g_EventCooldownTime = sConfigMgr->GetOption<uint32_t>("OllamaChat.EventCooldownTime", 10);
+    g_EventCoalesceWindowMs = sConfigMgr->GetOption<uint32_t>("OllamaChat.EventCoalesceWindowMs", 3000);
+
+    // Compiled into a new set, published once every template is built
+    auto templates = std::make_shared<PromptTemplates>();
+
+    // Event type table: text, chance and optional per-type cooldown/prompt template
+    // (the optional keys are usually absent, so don't log them as missing)
+    for (size_t type = 0; type < EVENT_TYPE_COUNT; ++type)
+    {
+        EventTypeConfig& eventType = g_EventTypes[type];
+        std::string key = std::string("OllamaChat.") + eventType.configName;
+        eventType.text           = sConfigMgr->GetOption<std::string>(key, "");
+        eventType.chance         = sConfigMgr->GetOption<int>(key + "_Chance", 0);
+        eventType.cooldown       = sConfigMgr->GetOption<uint32_t>(key + "_Cooldown", g_EventCooldownTime, false);
+        CompilePromptTemplate(templates->events[type],
+            sConfigMgr->GetOption<std::string>(key + "_PromptTemplate", g_EventChatterPromptTemplate, false),
+            key + "_PromptTemplate",
+            { PROMPT_VAR_BOT_NAME, PROMPT_VAR_BOT_LEVEL, PROMPT_VAR_BOT_CLASS, PROMPT_VAR_BOT_RACE, PROMPT_VAR_BOT_GENDER,
+              PROMPT_VAR_BOT_ROLE, PROMPT_VAR_BOT_FACTION, PROMPT_VAR_BOT_AREA, PROMPT_VAR_BOT_ZONE, PROMPT_VAR_BOT_MAP,
+              PROMPT_VAR_BOT_PERSONALITY, PROMPT_VAR_BOT_PERSONALITY_NAME, PROMPT_VAR_EVENT_TYPE, PROMPT_VAR_EVENT_DETAIL,
+              PROMPT_VAR_ACTOR_NAME, PROMPT_VAR_SENTIMENT_INFO });
+    }
+
+    // Prompt templates are parsed once here; placeholders outside each template's set are rejected
+    CompilePromptTemplate(templates->randomChatter, g_RandomChatterPromptTemplate, "OllamaChat.RandomChatterPromptTemplate",
+        { PROMPT_VAR_BOT_NAME, PROMPT_VAR_BOT_LEVEL, PROMPT_VAR_BOT_CLASS, PROMPT_VAR_BOT_RACE, PROMPT_VAR_BOT_GENDER,
+          PROMPT_VAR_BOT_ROLE, PROMPT_VAR_BOT_FACTION, PROMPT_VAR_BOT_AREA, PROMPT_VAR_BOT_ZONE, PROMPT_VAR_BOT_MAP,
+          PROMPT_VAR_BOT_PERSONALITY, PROMPT_VAR_BOT_PERSONALITY_NAME, PROMPT_VAR_ENVIRONMENT_INFO });
+    CompilePromptTemplate(templates->chat, g_ChatPromptTemplate, "OllamaChat.ChatPromptTemplate",
+        { PROMPT_VAR_BOT_NAME, PROMPT_VAR_BOT_LEVEL, PROMPT_VAR_BOT_CLASS, PROMPT_VAR_BOT_PERSONALITY,
+          PROMPT_VAR_BOT_PERSONALITY_NAME, PROMPT_VAR_PLAYER_LEVEL, PROMPT_VAR_PLAYER_CLASS, PROMPT_VAR_PLAYER_NAME,
+          PROMPT_VAR_PLAYER_MESSAGE, PROMPT_VAR_EXTRA_INFO, PROMPT_VAR_CHAT_HISTORY, PROMPT_VAR_SENTIMENT_INFO,
+          PROMPT_VAR_RAG_INFO });
+    CompilePromptTemplate(templates->chatPersona, g_ChatPersonaTemplate, "OllamaChat.ChatPersonaTemplate",
+        { PROMPT_VAR_BOT_NAME, PROMPT_VAR_BOT_LEVEL, PROMPT_VAR_BOT_CLASS, PROMPT_VAR_BOT_RACE, PROMPT_VAR_BOT_GENDER,
+          PROMPT_VAR_BOT_ROLE, PROMPT_VAR_BOT_FACTION, PROMPT_VAR_BOT_GUILD, PROMPT_VAR_BOT_PERSONALITY,
+          PROMPT_VAR_BOT_PERSONALITY_NAME });
+    CompilePromptTemplate(templates->chatExtraInfo, g_ChatExtraInfoTemplate, "OllamaChat.ChatExtraInfoTemplate",
+        { PROMPT_VAR_BOT_RACE, PROMPT_VAR_BOT_GENDER, PROMPT_VAR_BOT_ROLE, PROMPT_VAR_BOT_FACTION, PROMPT_VAR_BOT_GUILD,
+          PROMPT_VAR_BOT_GROUP_STATUS, PROMPT_VAR_BOT_GOLD, PROMPT_VAR_PLAYER_RACE, PROMPT_VAR_PLAYER_GENDER,
+          PROMPT_VAR_PLAYER_ROLE, PROMPT_VAR_PLAYER_FACTION, PROMPT_VAR_PLAYER_GUILD, PROMPT_VAR_PLAYER_GROUP_STATUS,
+          PROMPT_VAR_PLAYER_GOLD, PROMPT_VAR_PLAYER_DISTANCE, PROMPT_VAR_BOT_AREA, PROMPT_VAR_BOT_ZONE, PROMPT_VAR_BOT_MAP });
+    CompilePromptTemplate(templates->chatHistoryHeader, g_ChatHistoryHeaderTemplate, "OllamaChat.ChatHistoryHeaderTemplate",
+        { PROMPT_VAR_PLAYER_NAME });
+    CompilePromptTemplate(templates->chatHistoryLine, g_ChatHistoryLineTemplate, "OllamaChat.ChatHistoryLineTemplate",
+        { PROMPT_VAR_PLAYER_NAME, PROMPT_VAR_PLAYER_MESSAGE, PROMPT_VAR_BOT_REPLY });
+    CompilePromptTemplate(templates->chatHistoryFooter, g_ChatHistoryFooterTemplate, "OllamaChat.ChatHistoryFooterTemplate",
+        { PROMPT_VAR_PLAYER_NAME, PROMPT_VAR_PLAYER_MESSAGE });
+    CompilePromptTemplate(templates->chatBotSnapshot, g_ChatBotSnapshotTemplate, "OllamaChat.ChatBotSnapshotTemplate",
+        { PROMPT_VAR_COMBAT, PROMPT_VAR_GROUP, PROMPT_VAR_SPELLS, PROMPT_VAR_QUESTS, PROMPT_VAR_LOS, PROMPT_VAR_PLAYERS });
+    CompilePromptTemplate(templates->ragPrompt, g_RAGPromptTemplate, "OllamaChat.RAGPromptTemplate",
+        { PROMPT_VAR_RAG_INFO });
+    {
+        std::lock_guard<std::mutex> lock(s_PromptTemplatesMutex);
+        s_PromptTemplates = std::move(templates);
+    }
 
     // Party restriction settings
     g_RestrictBotsToPartyMembers = sConfigMgr->GetOption<bool>("OllamaChat.RestrictBotsToPartyMembers", false);
@@ -574,76 +757,64 @@ void LoadOllamaChatConfig()
 
 void LoadPersonalityTemplatesFromDB()
 {
-    g_PersonalityPrompts.clear();
-    g_PersonalityKeys.clear();
-    g_PersonalityKeysRandomOnly.clear();
+    // Built aside and swapped in, so replies never see a half-loaded set
+    std::unordered_map<std::string, std::string> personalityPrompts;
+    std::vector<std::string> personalityKeys;
+    std::vector<std::string> personalityKeysRandomOnly;
 
     QueryResult result = CharacterDatabase.Query("SELECT `key`, `prompt`, `manual_only` FROM `mod_ollama_chat_personality_templates`");
     if (!result)
     {
         LOG_ERROR("server.loading", "[Ollama Chat] No personality templates found in the database!");
-        return;
     }
-
-    do
+    else
     {
-        std::string key = (*result)[0].Get<std::string>();
-        std::string prompt = (*result)[1].Get<std::string>();
-        bool manualOnly = (*result)[2].Get<bool>();
-        
-        g_PersonalityPrompts[key] = prompt;
-        g_PersonalityKeys.push_back(key);
-        
-        // Only add to random pool if not manual_only
-        if (!manualOnly)
-        {
-            g_PersonalityKeysRandomOnly.push_back(key);
-        }
-    } while (result->NextRow());
-
-    LOG_INFO("server.loading", "[Ollama Chat] Cached {} personalities ({} available for random assignment).", 
-             g_PersonalityKeys.size(), g_PersonalityKeysRandomOnly.size());
-}
-
-void LoadBotConversationHistoryFromDB()
-{
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT bot_guid, player_guid, player_message, bot_reply FROM mod_ollama_chat_history ORDER BY timestamp ASC"
-    );
-    if (!result)
-        return;
-
-    std::lock_guard<std::mutex> lock(g_ConversationHistoryMutex);
-    g_BotConversationHistory.clear();
-
-    do {
-        uint64_t botGuid = (*result)[0].Get<uint64_t>();
-        uint64_t playerGuid = (*result)[1].Get<uint64_t>();
-        std::string playerMsg = (*result)[2].Get<std::string>();
-        std::string botReply = (*result)[3].Get<std::string>();
-
-        auto& playerHistory = g_BotConversationHistory[botGuid][playerGuid];
-        playerHistory.push_back({ playerMsg, botReply });
-        while (playerHistory.size() > g_MaxConversationHistory)
+        do
         {
-            playerHistory.pop_front();
-        }
+            std::string key = (*result)[0].Get<std::string>();
+            std::string prompt = (*result)[1].Get<std::string>();
+            bool manualOnly = (*result)[2].Get<bool>();
+            
+            personalityPrompts[key] = prompt;
+            personalityKeys.push_back(key);
+            
+            // Only add to random pool if not manual_only
+            if (!manualOnly)
+            {
+                personalityKeysRandomOnly.push_back(key);
+            }
+        } while (result->NextRow());
+    }
 
-    } while (result->NextRow());
+    size_t personalityCount = personalityKeys.size();
+    size_t randomCount = personalityKeysRandomOnly.size();
+    {
+        std::unique_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
+        g_PersonalityPrompts.swap(personalityPrompts);
+        g_PersonalityKeys.swap(personalityKeys);
+        g_PersonalityKeysRandomOnly.swap(personalityKeysRandomOnly);
+    }
 
+    if (result)
+    {
+        LOG_INFO("server.loading", "[Ollama Chat] Cached {} personalities ({} available for random assignment).", 
+                 personalityCount, randomCount);
+    }
 }
 
-
 // Definition of the configuration WorldScript.
 OllamaChatConfigWorldScript::OllamaChatConfigWorldScript() : WorldScript("OllamaChatConfigWorldScript") { }
 
 void OllamaChatConfigWorldScript::OnStartup()
 {
     LoadOllamaChatConfig();
+    CheckBotPersonalityTable();
     LoadBotPersonalityList();
-    LoadBotConversationHistoryFromDB();
     InitializeSentimentTracking();
 
+    // Replays changes a crash left in the journal before anything new is queued
+    StartPersistenceJournal();
+
     // Initialize RAG system if enabled
     if (g_EnableRAG) {
         if (g_RAGSystem) {
@@ -662,6 +833,10 @@ void OllamaChatConfigWorldScript::OnStartup()
 
 void OllamaChatConfigWorldScript::OnShutdown()
 {
+    // Commits the changes still queued in memory, after any save still running
+    StopPersistenceJournal();
+    FlushBotPersonalitiesToDB();
+
     // Clean up RAG system
     if (g_RAGSystem) {
         delete g_RAGSystem;
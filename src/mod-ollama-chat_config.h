@@ -5,10 +5,13 @@
 #include <cstdint>
 #include <vector>
 #include <deque>
+#include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
 #include <ctime>
 #include "ScriptMgr.h"  // Ensure WorldScript is defined
+#include "mod-ollama-chat_template.h"
 
 // --------------------------------------------
 // Distance/Range Configuration
@@ -26,6 +29,8 @@ extern uint32_t   g_BotReplyChance;
 extern uint32_t   g_MaxBotsToPick;
 extern uint32_t   g_RandomChatterBotCommentChance;
 extern uint32_t   g_RandomChatterMaxBotsPerPlayer;
+extern uint32_t   g_RandomChatterMaxBotsPerTick;
+extern uint32_t   g_RandomChatterTickBudgetUs;
 extern uint32_t   g_EventChatterBotCommentChance;
 extern uint32_t   g_EventChatterBotSelfCommentChance;
 extern uint32_t   g_EventChatterMaxBotsPerPlayer;
@@ -44,12 +49,39 @@ extern uint32_t    g_OllamaNumThreads;
 extern std::string g_OllamaStop;
 extern std::string g_OllamaSystemPrompt;
 extern std::string g_OllamaSeed;
+extern bool        g_LogPromptEvalStats;                 // Log prompt_eval_count/prompt_eval_duration per response
+
+// How conversation history reaches the model (OllamaChat.ApiBackend)
+enum OllamaApiBackend : uint8_t
+{
+    OLLAMA_BACKEND_GENERATE = 0,  // /api/generate, history rendered into every prompt
+    OLLAMA_BACKEND_CHAT,          // /api/chat, history sent as messages
+    OLLAMA_BACKEND_CONTEXT        // /api/generate, returned context kept per bot/player pair
+};
+
+extern OllamaApiBackend g_OllamaApiBackend;
+extern std::string g_OllamaChatUrl;
+extern uint32_t    g_MaxStoredContexts;
+extern uint32_t    g_MaxContextTokens;
 
 // --------------------------------------------
 // Concurrency/Queueing
 // --------------------------------------------
 extern uint32_t    g_MaxConcurrentQueries;
 
+// --------------------------------------------
+// LLM Request Admission Control (token buckets, 0 rate = unlimited)
+// --------------------------------------------
+extern bool        g_EnableAdmissionControl;
+extern float       g_ChatRequestsPerSecond;
+extern uint32_t    g_ChatRequestBurst;
+extern float       g_EventRequestsPerSecond;
+extern uint32_t    g_EventRequestBurst;
+extern float       g_RandomRequestsPerSecond;
+extern uint32_t    g_RandomRequestBurst;
+extern float       g_GlobalRequestsPerSecond;
+extern uint32_t    g_GlobalRequestBurst;
+
 // --------------------------------------------
 // Feature Toggles & Core Settings
 // --------------------------------------------
@@ -72,6 +104,14 @@ extern uint32_t    g_MaxRandomInterval;
 // --------------------------------------------
 extern uint32_t    g_MaxConversationHistory;
 extern uint32_t    g_ConversationHistorySaveInterval;
+extern uint32_t    g_DatabaseBatchSize;                  // Rows per multi-row statement in history/sentiment saves
+extern uint32_t    g_MaxResidentHistoryPairs;            // Bot/player histories kept in memory, 0 = unlimited
+extern uint32_t    g_ChatHistoryMaxMessageLength;        // Bytes of each player message kept in memory, 0 = up to 16 KiB
+extern uint32_t    g_ChatHistoryMaxReplyLength;          // Bytes of each bot reply kept in memory, 0 = up to 16 KiB
+extern bool        g_EnablePersistenceJournal;           // Journal history/sentiment changes and drain them from a persistence thread
+extern std::string g_PersistenceJournalPath;             // Journal segments are this path plus a sequence number
+extern uint32_t    g_PersistenceDrainInterval;           // Seconds between drains of the journaled changes to the database
+extern bool        g_PersistenceJournalSync;             // fsync each journal write, not just flush it to the OS
 
 // --------------------------------------------
 // Prompt Templates
@@ -80,10 +120,30 @@ extern std::string g_RandomChatterPromptTemplate;
 extern std::string g_EventChatterPromptTemplate;
 extern std::string g_ChatPromptTemplate;
 extern std::string g_ChatExtraInfoTemplate;
+extern std::string g_ChatPersonaTemplate;
+
+// Sections a chat prompt is assembled from, in OllamaChat.ChatPromptSectionOrder order.
+// The persona section is per-bot and stable, so it belongs at the front (or in the
+// system field); volatile sections go last so they don't invalidate the cached prefix.
+enum ChatPromptSection : uint8_t
+{
+    CHAT_PROMPT_SECTION_PERSONA = 0,
+    CHAT_PROMPT_SECTION_PROMPT,
+    CHAT_PROMPT_SECTION_RAG,
+    CHAT_PROMPT_SECTION_SNAPSHOT,
+    CHAT_PROMPT_SECTION_COUNT
+};
+
+extern std::vector<ChatPromptSection> g_ChatPromptSectionOrder;
+extern bool        g_ChatPersonaInSystem;                // OllamaChat.ChatPersonaPlacement = system
+
 
 // --------------------------------------------
 // Personality and Prompt Data
 // --------------------------------------------
+// Guards the assignments and the personality templates below; replies read them on worker threads
+extern std::shared_mutex g_BotPersonalityMutex;
+extern bool g_BotPersonalityTableExists;                // mod_ollama_chat_personality was found at startup
 extern std::unordered_map<uint64_t, std::string> g_BotPersonalityList;
 extern std::unordered_map<std::string, std::string> g_PersonalityPrompts;
 extern std::vector<std::string> g_PersonalityKeys;
@@ -103,12 +163,20 @@ extern std::string g_ChatHistoryFooterTemplate;
 // --------------------------------------------
 extern bool        g_EnableChatBotSnapshotTemplate;
 extern std::string g_ChatBotSnapshotTemplate;
+extern bool        g_EnableSnapshotCache;
+extern uint32_t    g_SnapshotCombatTTLMs;
+extern uint32_t    g_SnapshotGroupTTLMs;
+extern uint32_t    g_SnapshotSpellsTTLMs;
+extern uint32_t    g_SnapshotQuestsTTLMs;
+extern uint32_t    g_SnapshotLosTTLMs;
+extern uint32_t    g_SnapshotPlayersTTLMs;
+extern uint32_t    g_SnapshotRefreshPerTick;
+extern uint32_t    g_SnapshotMaxVisibleObjects;
 
 // --------------------------------------------
-// Conversation History Store and Mutex
+// Conversation History Save Time
 // --------------------------------------------
-extern std::unordered_map<uint64_t, std::unordered_map<uint64_t, std::deque<std::pair<std::string, std::string>>>> g_BotConversationHistory;
-extern std::mutex   g_ConversationHistoryMutex;
+// The turns and their save queue are kept in the relationship table (mod-ollama-chat_relationship.h)
 extern time_t       g_LastHistorySaveTime;
 
 // --------------------------------------------
@@ -137,6 +205,9 @@ extern std::vector<std::string> g_EnvCommentBagSlots;
 extern std::vector<std::string> g_EnvCommentDungeon;
 extern std::vector<std::string> g_EnvCommentUnfinishedQuest;
 
+// Category name -> weight for picking which environment comment to generate
+extern std::unordered_map<std::string, uint32_t> g_EnvCommentWeights;
+
 // --------------------------------------------
 // Guild-Specific Random Chatter Templates
 // --------------------------------------------
@@ -162,46 +233,6 @@ extern uint32_t    g_GuildRandomChatterChance;
 extern uint32_t    g_GuildChatterBotCommentChance;
 extern uint32_t    g_GuildChatterMaxBotsPerEvent;
 
-// --------------------------------------------
-// Guild-Specific Event Chatter Templates
-// --------------------------------------------
-extern std::string g_GuildEventTypeLevelUp;
-extern std::string g_GuildEventTypeDungeonComplete;
-extern std::string g_GuildEventTypeEpicGear;
-extern std::string g_GuildEventTypeRareGear;
-extern std::string g_GuildEventTypeGuildJoin;
-extern std::string g_GuildEventTypeGuildLeave;
-extern std::string g_GuildEventTypeGuildPromotion;
-extern std::string g_GuildEventTypeGuildDemotion;
-extern std::string g_GuildEventTypeGuildLogin;
-extern std::string g_GuildEventTypeGuildAchievement;
-
-// Chance variables for normal events
-extern int g_EventTypeDefeated_Chance;
-extern int g_EventTypeDefeatedPlayer_Chance;
-extern int g_EventTypePetDefeated_Chance;
-extern int g_EventTypeGotItem_Chance;
-extern int g_EventTypeDied_Chance;
-extern int g_EventTypeCompletedQuest_Chance;
-extern int g_EventTypeLearnedSpell_Chance;
-extern int g_EventTypeRequestedDuel_Chance;
-extern int g_EventTypeStartedDueling_Chance;
-extern int g_EventTypeWonDuel_Chance;
-extern int g_EventTypeLeveledUp_Chance;
-extern int g_EventTypeAchievement_Chance;
-extern int g_EventTypeUsedObject_Chance;
-
-// Chance variables for guild events
-extern int g_GuildEventTypeEpicGear_Chance;
-extern int g_GuildEventTypeRareGear_Chance;
-extern int g_GuildEventTypeGuildJoin_Chance;
-extern int g_GuildEventTypeGuildLogin_Chance;
-extern int g_GuildEventTypeGuildLeave_Chance;
-extern int g_GuildEventTypeGuildPromotion_Chance;
-extern int g_GuildEventTypeGuildDemotion_Chance;
-extern int g_GuildEventTypeGuildAchievement_Chance;
-extern int g_GuildEventTypeLevelUp_Chance;
-extern int g_GuildEventTypeDungeonComplete_Chance;
 
 // --------------------------------------------
 // Bot-Player Sentiment Tracking System
@@ -213,9 +244,8 @@ extern uint32_t    g_SentimentSaveInterval;              // How often to save se
 extern std::string g_SentimentAnalysisPrompt;            // Prompt template for sentiment analysis
 extern std::string g_SentimentPromptTemplate;            // Template for including sentiment in bot prompts
 
-// In-memory sentiment storage and mutex
-extern std::unordered_map<uint64_t, std::unordered_map<uint64_t, float>> g_BotPlayerSentiments;
-extern std::mutex g_SentimentMutex;
+extern uint32_t    g_MaxResidentSentimentPairs;          // Sentiment values kept in memory before the least recently used are dropped
+
 extern time_t g_LastSentimentSaveTime;
 
 // --------------------------------------------
@@ -226,32 +256,84 @@ extern std::string g_RAGDataPath;                        // Path to RAG data fil
 extern uint32_t    g_RAGMaxRetrievedItems;               // Max items to retrieve
 extern float       g_RAGSimilarityThreshold;             // Similarity threshold for retrieval
 extern std::string g_RAGPromptTemplate;                  // Template for RAG info in prompts
+extern bool        g_RAGAppendToPrompt;                  // Append RAG info when the chat template has no {rag_info}
 
 class OllamaRAGSystem;
 extern OllamaRAGSystem* g_RAGSystem;                     // Global RAG system instance
 
 // --------------------------------------------
-// Event Chatter: Event Type Strings
-// These control the event type string sent to eventChatter for world event prompts.
-// Values are loaded from conf (see mod_ollama_chat.conf.dist)
-// --------------------------------------------
-extern std::string g_EventTypeDefeated;           // "defeated"
-extern std::string g_EventTypeDefeatedPlayer;     // "defeated player"
-extern std::string g_EventTypePetDefeated;        // "pet defeated"
-extern std::string g_EventTypeGotItem;            // "got item"
-extern std::string g_EventTypeDied;               // "died"
-extern std::string g_EventTypeCompletedQuest;     // "completed quest"
-extern std::string g_EventTypeLearnedSpell;       // "learned spell"
-extern std::string g_EventTypeRequestedDuel;      // "requested to duel"
-extern std::string g_EventTypeStartedDueling;     // "started dueling"
-extern std::string g_EventTypeWonDuel;            // "won duel against"
-extern std::string g_EventTypeLeveledUp;          // "leveled up"
-extern std::string g_EventTypeAchievement;        // "earned achievement"
-extern std::string g_EventTypeUsedObject;         // "used object"
+// Event Chatter: Event Types
+// Hooks pass an OllamaEventType; everything else about the event comes from
+// g_EventTypes, which is loaded from conf (see mod_ollama_chat.conf.dist).
+// --------------------------------------------
+enum OllamaEventType
+{
+    EVENT_TYPE_DEFEATED                = 0,
+    EVENT_TYPE_DEFEATED_PLAYER         = 1,
+    EVENT_TYPE_PET_DEFEATED            = 2,
+    EVENT_TYPE_GOT_ITEM                = 3,
+    EVENT_TYPE_DIED                    = 4,
+    EVENT_TYPE_COMPLETED_QUEST         = 5,
+    EVENT_TYPE_LEARNED_SPELL           = 6,
+    EVENT_TYPE_REQUESTED_DUEL          = 7,
+    EVENT_TYPE_STARTED_DUELING         = 8,
+    EVENT_TYPE_WON_DUEL                = 9,
+    EVENT_TYPE_LEVELED_UP              = 10,
+    EVENT_TYPE_ACHIEVEMENT             = 11,
+    EVENT_TYPE_USED_OBJECT             = 12,
+    GUILD_EVENT_TYPE_LEVEL_UP          = 13,
+    GUILD_EVENT_TYPE_DUNGEON_COMPLETE  = 14,
+    GUILD_EVENT_TYPE_EPIC_GEAR         = 15,
+    GUILD_EVENT_TYPE_RARE_GEAR         = 16,
+    GUILD_EVENT_TYPE_GUILD_JOIN        = 17,
+    GUILD_EVENT_TYPE_GUILD_LEAVE       = 18,
+    GUILD_EVENT_TYPE_GUILD_PROMOTION   = 19,
+    GUILD_EVENT_TYPE_GUILD_DEMOTION    = 20,
+    GUILD_EVENT_TYPE_GUILD_LOGIN       = 21,
+    GUILD_EVENT_TYPE_GUILD_ACHIEVEMENT = 22,
+    EVENT_TYPE_COUNT
+};
+
+struct EventTypeConfig
+{
+    const char* configName;       // Conf key suffix, e.g. "EventTypeDefeated"
+    bool        isGuild;          // Routed to guild chat when a real guild member is online
+    std::string text;             // Event type string used in prompts ("defeated")
+    int         chance;           // <Key>_Chance
+    uint32_t    cooldown;         // <Key>_Cooldown, defaults to OllamaChat.EventCooldownTime
+};
+
+extern EventTypeConfig g_EventTypes[EVENT_TYPE_COUNT];
+
+// Compiled forms of the prompt templates, rebuilt on every config load.
+// A template that fails to compile is logged and left empty.
+struct PromptTemplates
+{
+    CompiledPromptTemplate randomChatter;
+    CompiledPromptTemplate chat;
+    CompiledPromptTemplate chatExtraInfo;
+    CompiledPromptTemplate chatPersona;
+    CompiledPromptTemplate chatHistoryHeader;
+    CompiledPromptTemplate chatHistoryLine;
+    CompiledPromptTemplate chatHistoryFooter;
+    CompiledPromptTemplate chatBotSnapshot;
+    CompiledPromptTemplate ragPrompt;
+    CompiledPromptTemplate events[EVENT_TYPE_COUNT];   // <Key>_PromptTemplate, defaults to OllamaChat.EventChatterPromptTemplate
+};
+
+/**
+ * The templates of the current config. A reload publishes a new set instead of changing
+ * this one, so a render keeps the set it took even if the config is reloaded meanwhile.
+ * Take it once per render and use it throughout.
+ */
+std::shared_ptr<const PromptTemplates> GetPromptTemplates();
 
 // Event Cooldown
 extern uint32_t g_EventCooldownTime;
 
+// Event coalescing window for repeated kill/loot events (milliseconds, 0 = disabled)
+extern uint32_t g_EventCoalesceWindowMs;
+
 // --------------------------------------------
 // Party Restriction Settings
 // --------------------------------------------
@@ -261,8 +343,8 @@ extern bool g_RestrictBotsToPartyMembers;
 // Loader Functions
 // --------------------------------------------
 void LoadOllamaChatConfig();
+void CheckBotPersonalityTable();
 void LoadBotPersonalityList();
-void LoadBotConversationHistoryFromDB();
 void LoadPersonalityTemplatesFromDB();
 
 // --------------------------------------------
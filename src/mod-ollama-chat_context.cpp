@@ -0,0 +1,81 @@
+#include "mod-ollama-chat_context.h"
+#include "mod-ollama-chat_config.h"
+#include "Log.h"
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+
+using ConversationKey = std::pair<uint64_t, uint64_t>;
+
+struct StoredContext
+{
+    ConversationKey key;
+    std::shared_ptr<const OllamaContextTokens> tokens;
+};
+
+static std::mutex contextMutex;
+// Most recently used first
+static std::list<StoredContext> contextLru;
+static std::map<ConversationKey, std::list<StoredContext>::iterator> contextIndex;
+static size_t storedTokens = 0;
+
+static void EraseContext(std::map<ConversationKey, std::list<StoredContext>::iterator>::iterator it)
+{
+    storedTokens -= it->second->tokens->size();
+    contextLru.erase(it->second);
+    contextIndex.erase(it);
+}
+
+std::shared_ptr<const OllamaContextTokens> GetConversationContext(uint64_t botGuid, uint64_t playerGuid)
+{
+    std::lock_guard<std::mutex> lock(contextMutex);
+    auto it = contextIndex.find({ botGuid, playerGuid });
+    if (it == contextIndex.end())
+        return nullptr;
+
+    contextLru.splice(contextLru.begin(), contextLru, it->second);
+    return it->second->tokens;
+}
+
+void StoreConversationContext(uint64_t botGuid, uint64_t playerGuid, OllamaContextTokens tokens)
+{
+    ConversationKey key{ botGuid, playerGuid };
+
+    std::lock_guard<std::mutex> lock(contextMutex);
+    auto it = contextIndex.find(key);
+    if (it != contextIndex.end())
+        EraseContext(it);
+
+    if (tokens.empty() || g_MaxStoredContexts == 0)
+        return;
+
+    if (g_MaxContextTokens > 0 && tokens.size() > g_MaxContextTokens)
+    {
+        if (g_DebugEnabled)
+            LOG_INFO("server.loading", "[Ollama Chat] Context for bot {} and player {} reached {} tokens, restarting from history.",
+                     botGuid, playerGuid, tokens.size());
+        return;
+    }
+
+    storedTokens += tokens.size();
+    contextLru.push_front({ key, std::make_shared<const OllamaContextTokens>(std::move(tokens)) });
+    contextIndex[key] = contextLru.begin();
+
+    while (contextIndex.size() > g_MaxStoredContexts)
+        EraseContext(contextIndex.find(contextLru.back().key));
+}
+
+void ClearConversationContexts()
+{
+    std::lock_guard<std::mutex> lock(contextMutex);
+    contextLru.clear();
+    contextIndex.clear();
+    storedTokens = 0;
+}
+
+ConversationContextStats GetConversationContextStats()
+{
+    std::lock_guard<std::mutex> lock(contextMutex);
+    return { contextIndex.size(), storedTokens };
+}
@@ -0,0 +1,38 @@
+#ifndef MOD_OLLAMA_CHAT_CONTEXT_H
+#define MOD_OLLAMA_CHAT_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Token state Ollama returns in the "context" field of a generate response
+using OllamaContextTokens = std::vector<int>;
+
+/**
+ * Get the context stored for a bot/player conversation (OllamaChat.ApiBackend = context).
+ * @return The tokens of the previous turn, or null if there is none and the history has
+ *         to be sent as text
+ */
+std::shared_ptr<const OllamaContextTokens> GetConversationContext(uint64_t botGuid, uint64_t playerGuid);
+
+/**
+ * Store the context returned for a conversation turn, replacing the previous one.
+ * Contexts longer than OllamaChat.MaxContextTokens are dropped so the next turn starts
+ * over from the text history; past OllamaChat.MaxStoredContexts the least recently
+ * used conversation is evicted.
+ */
+void StoreConversationContext(uint64_t botGuid, uint64_t playerGuid, OllamaContextTokens tokens);
+
+// Drops every stored context, e.g. when the conversation history is reloaded
+void ClearConversationContexts();
+
+struct ConversationContextStats
+{
+    size_t contexts;
+    size_t tokens;
+};
+
+ConversationContextStats GetConversationContextStats();
+
+#endif // MOD_OLLAMA_CHAT_CONTEXT_H
@@ -0,0 +1,203 @@
+#include "mod-ollama-chat_cooldown.h"
+#include <algorithm>
+
+CooldownStore::CooldownStore(uint32_t retentionSeconds)
+    : m_retention(retentionSeconds), m_currentTick(time(nullptr))
+{
+    std::fill(std::begin(m_slots), std::end(m_slots), NO_ENTRY);
+}
+
+void CooldownStore::SetRetention(uint32_t retentionSeconds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_retention = retentionSeconds;
+}
+
+void CooldownStore::Set(uint64_t key, time_t deadline)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Advance(time(nullptr));
+
+    uint32_t index;
+    auto it = m_index.find(key);
+    if (it != m_index.end())
+    {
+        index = it->second;
+        Unlink(index);
+    }
+    else if (!m_freeList.empty())
+    {
+        index = m_freeList.back();
+        m_freeList.pop_back();
+        m_index.emplace(key, index);
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_entries.size());
+        m_entries.emplace_back();
+        m_index.emplace(key, index);
+    }
+
+    Entry& entry = m_entries[index];
+    entry.key = key;
+    entry.deadline = deadline;
+    entry.expireAt = deadline + m_retention;
+    Link(index);
+}
+
+bool CooldownStore::Get(uint64_t key, time_t* deadline)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Advance(time(nullptr));
+
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+        return false;
+    if (deadline)
+        *deadline = m_entries[it->second].deadline;
+    return true;
+}
+
+bool CooldownStore::IsActive(uint64_t key, time_t now)
+{
+    time_t deadline = 0;
+    return Get(key, &deadline) && now < deadline;
+}
+
+void CooldownStore::Erase(uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+        return;
+    uint32_t index = it->second;
+    Unlink(index);
+    Release(index);
+}
+
+void CooldownStore::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_freeList.clear();
+    m_index.clear();
+    std::fill(std::begin(m_slots), std::end(m_slots), NO_ENTRY);
+}
+
+size_t CooldownStore::Size()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Advance(time(nullptr));
+    return m_index.size();
+}
+
+// Places an entry in the wheel level whose span covers its remaining time.
+// Entries beyond the top level's span sit in its farthest slot and are re-placed when cascaded.
+void CooldownStore::Link(uint32_t index)
+{
+    Entry& entry = m_entries[index];
+    time_t expireAt = std::max<time_t>(entry.expireAt, m_currentTick + 1);
+    time_t delta = expireAt - m_currentTick;
+
+    uint32_t slot;
+    if (delta < static_cast<time_t>(WHEEL_SLOTS))
+        slot = static_cast<uint32_t>(expireAt & WHEEL_MASK);
+    else if (delta < static_cast<time_t>(1) << (2 * WHEEL_BITS))
+        slot = WHEEL_SLOTS + static_cast<uint32_t>((expireAt >> WHEEL_BITS) & WHEEL_MASK);
+    else
+    {
+        time_t maxSpan = (static_cast<time_t>(1) << (3 * WHEEL_BITS)) - 1;
+        time_t placeAt = std::min(expireAt, m_currentTick + maxSpan);
+        slot = 2 * WHEEL_SLOTS + static_cast<uint32_t>((placeAt >> (2 * WHEEL_BITS)) & WHEEL_MASK);
+    }
+
+    entry.slot = slot;
+    entry.prev = NO_ENTRY;
+    entry.next = m_slots[slot];
+    if (entry.next != NO_ENTRY)
+        m_entries[entry.next].prev = index;
+    m_slots[slot] = index;
+}
+
+void CooldownStore::Unlink(uint32_t index)
+{
+    Entry& entry = m_entries[index];
+    if (entry.prev != NO_ENTRY)
+        m_entries[entry.prev].next = entry.next;
+    else
+        m_slots[entry.slot] = entry.next;
+    if (entry.next != NO_ENTRY)
+        m_entries[entry.next].prev = entry.prev;
+    entry.prev = entry.next = NO_ENTRY;
+}
+
+void CooldownStore::Release(uint32_t index)
+{
+    m_index.erase(m_entries[index].key);
+    m_freeList.push_back(index);
+}
+
+// Moves every entry of a higher-level slot down to the level matching its remaining time
+void CooldownStore::Cascade(uint32_t level, uint32_t slot)
+{
+    uint32_t wheelSlot = level * WHEEL_SLOTS + slot;
+    uint32_t index = m_slots[wheelSlot];
+    m_slots[wheelSlot] = NO_ENTRY;
+    while (index != NO_ENTRY)
+    {
+        uint32_t next = m_entries[index].next;
+        Link(index);
+        index = next;
+    }
+}
+
+void CooldownStore::Advance(time_t now)
+{
+    if (now <= m_currentTick)
+        return;
+
+    // After a long stall, stepping tick by tick would be slower than re-placing everything
+    if (now - m_currentTick >= static_cast<time_t>(1) << (3 * WHEEL_BITS))
+    {
+        m_currentTick = now;
+        std::fill(std::begin(m_slots), std::end(m_slots), NO_ENTRY);
+        for (auto it = m_index.begin(); it != m_index.end(); )
+        {
+            uint32_t index = it->second;
+            if (m_entries[index].expireAt <= now)
+            {
+                m_freeList.push_back(index);
+                it = m_index.erase(it);
+                continue;
+            }
+            Link(index);
+            ++it;
+        }
+        return;
+    }
+
+    while (m_currentTick < now)
+    {
+        ++m_currentTick;
+        uint32_t slot0 = static_cast<uint32_t>(m_currentTick & WHEEL_MASK);
+        if (slot0 == 0)
+        {
+            uint32_t slot1 = static_cast<uint32_t>((m_currentTick >> WHEEL_BITS) & WHEEL_MASK);
+            if (slot1 == 0)
+                Cascade(2, static_cast<uint32_t>((m_currentTick >> (2 * WHEEL_BITS)) & WHEEL_MASK));
+            Cascade(1, slot1);
+        }
+
+        uint32_t index = m_slots[slot0];
+        m_slots[slot0] = NO_ENTRY;
+        while (index != NO_ENTRY)
+        {
+            uint32_t next = m_entries[index].next;
+            if (m_entries[index].expireAt <= m_currentTick)
+                Release(index);
+            else
+                Link(index);
+            index = next;
+        }
+    }
+}
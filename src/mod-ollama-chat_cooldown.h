@@ -0,0 +1,72 @@
+#ifndef MOD_OLLAMA_CHAT_COOLDOWN_H
+#define MOD_OLLAMA_CHAT_COOLDOWN_H
+
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Per-GUID deadline store used for chatter cooldowns and random chatter scheduling.
+//
+// Each entry holds a deadline (unix seconds) and is dropped automatically once
+// deadline + retention has passed, so bots that log out or stop chatting do not
+// accumulate. Expiry is driven by a 3-level hierarchical timer wheel (64 slots per
+// level, 1 second resolution, ~3 days span) that is advanced lazily on access.
+// Entries live in a pooled array linked into their wheel slot, so memory is fixed
+// per active GUID and re-setting a deadline is O(1). All methods are thread-safe.
+class CooldownStore
+{
+public:
+    explicit CooldownStore(uint32_t retentionSeconds = 0);
+
+    // How long an entry is kept after its deadline. Applies to entries set afterwards.
+    void SetRetention(uint32_t retentionSeconds);
+
+    // Stores (or replaces) the deadline for key.
+    void Set(uint64_t key, time_t deadline);
+
+    // Looks up the deadline for key without inserting anything.
+    // @return false if the key has no live entry
+    bool Get(uint64_t key, time_t* deadline = nullptr);
+
+    // True while key has a deadline that is still in the future.
+    bool IsActive(uint64_t key, time_t now);
+
+    void Erase(uint64_t key);
+    void Clear();
+    size_t Size();
+
+private:
+    static constexpr uint32_t WHEEL_BITS   = 6;
+    static constexpr uint32_t WHEEL_SLOTS  = 1u << WHEEL_BITS;
+    static constexpr uint32_t WHEEL_MASK   = WHEEL_SLOTS - 1;
+    static constexpr uint32_t WHEEL_LEVELS = 3;
+    static constexpr uint32_t NO_ENTRY     = UINT32_MAX;
+
+    struct Entry
+    {
+        uint64_t key      = 0;
+        time_t   deadline = 0;
+        time_t   expireAt = 0;
+        uint32_t prev     = NO_ENTRY;
+        uint32_t next     = NO_ENTRY;
+        uint32_t slot     = 0;
+    };
+
+    void Advance(time_t now);
+    void Link(uint32_t index);
+    void Unlink(uint32_t index);
+    void Release(uint32_t index);
+    void Cascade(uint32_t level, uint32_t slot);
+
+    std::mutex m_mutex;
+    uint32_t m_retention;
+    time_t m_currentTick;
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_freeList;
+    std::unordered_map<uint64_t, uint32_t> m_index;
+    uint32_t m_slots[WHEEL_LEVELS * WHEEL_SLOTS];
+};
+
+#endif // MOD_OLLAMA_CHAT_COOLDOWN_H
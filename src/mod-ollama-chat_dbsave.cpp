@@ -0,0 +1,84 @@
+#include "mod-ollama-chat_dbsave.h"
+#include "mod-ollama-chat_config.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+const char* DatabaseSaveKindStr[DB_SAVE_KIND_COUNT] =
+{
+    "History",
+    "Sentiment",
+    "Personality"
+};
+
+static std::mutex saveStatsMutex;
+static DatabaseSaveStats saveStats[DB_SAVE_KIND_COUNT] = {};
+
+BatchedStatementWriter::BatchedStatementWriter(CharacterDatabaseTransaction trans, std::string head, std::string tail)
+    : m_trans(std::move(trans)), m_head(std::move(head)), m_tail(std::move(tail))
+{
+}
+
+void BatchedStatementWriter::AddRow(const std::string& values)
+{
+    if (m_pending == 0)
+        m_sql = m_head;
+    else
+        m_sql += ", ";
+    m_sql += values;
+    ++m_pending;
+    ++m_rows;
+
+    if (m_pending >= std::max<uint32_t>(g_DatabaseBatchSize, 1))
+        Flush();
+}
+
+void BatchedStatementWriter::Flush()
+{
+    if (m_pending == 0)
+        return;
+
+    m_sql += m_tail;
+    m_trans->Append(m_sql);
+    m_sql.clear();
+    m_pending = 0;
+    ++m_statements;
+}
+
+bool CommitTransactionAndWait(CharacterDatabaseTransaction trans)
+{
+    bool committed = false;
+    TransactionCallback callback = CharacterDatabase.AsyncCommitTransaction(trans);
+    callback.AfterComplete([&committed](bool success) { committed = success; });
+
+    // The callback runs from InvokeIfReady, on this thread, once the worker has finished
+    while (!callback.InvokeIfReady())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return committed;
+}
+
+void RecordDatabaseSave(DatabaseSaveKind kind, uint32_t rows, uint32_t statements, uint64_t micros)
+{
+    {
+        std::lock_guard<std::mutex> lock(saveStatsMutex);
+        DatabaseSaveStats& stats = saveStats[kind];
+        ++stats.saves;
+        stats.rows += rows;
+        stats.statements += statements;
+        stats.totalMicros += micros;
+        stats.lastRows = rows;
+        stats.lastMicros = micros;
+    }
+
+    if (g_DebugEnabled)
+        LOG_INFO("server.loading", "[Ollama Chat] {} save: {} rows in {} statements, {} us.",
+                 DatabaseSaveKindStr[kind], rows, statements, micros);
+}
+
+DatabaseSaveStats GetDatabaseSaveStats(DatabaseSaveKind kind)
+{
+    std::lock_guard<std::mutex> lock(saveStatsMutex);
+    return saveStats[kind];
+}
@@ -0,0 +1,75 @@
+#ifndef MOD_OLLAMA_CHAT_DBSAVE_H
+#define MOD_OLLAMA_CHAT_DBSAVE_H
+
+#include "DatabaseEnv.h"
+#include <cstdint>
+#include <string>
+
+// Tables saved periodically from memory
+enum DatabaseSaveKind : uint8_t
+{
+    DB_SAVE_HISTORY = 0,
+    DB_SAVE_SENTIMENT,
+    DB_SAVE_PERSONALITY,
+    DB_SAVE_KIND_COUNT
+};
+
+extern const char* DatabaseSaveKindStr[DB_SAVE_KIND_COUNT];
+
+/**
+ * Collects rows into multi-row statements of at most OllamaChat.DatabaseBatchSize rows,
+ * appended to one transaction. Each statement is head + "(..),(..)" + tail, e.g.
+ * "INSERT IGNORE INTO t (a, b) VALUES " and "" or " ON DUPLICATE KEY UPDATE b = VALUES(b)".
+ * Upserts use VALUES(b): MySQL 8.0.20 deprecated it for the row alias form, but that form
+ * needs 8.0.19 and MariaDB does not support it, while VALUES(b) works on both.
+ */
+class BatchedStatementWriter
+{
+public:
+    BatchedStatementWriter(CharacterDatabaseTransaction trans, std::string head, std::string tail = "");
+
+    // values is one parenthesized row, already escaped
+    void AddRow(const std::string& values);
+    // Appends the rows collected so far as one statement
+    void Flush();
+
+    uint32_t Rows() const { return m_rows; }
+    uint32_t Statements() const { return m_statements; }
+
+private:
+    CharacterDatabaseTransaction m_trans;
+    std::string m_head;
+    std::string m_tail;
+    std::string m_sql;
+    uint32_t    m_pending = 0;
+    uint32_t    m_rows = 0;
+    uint32_t    m_statements = 0;
+};
+
+struct DatabaseSaveStats
+{
+    uint64_t saves;
+    uint64_t rows;
+    uint64_t statements;
+    uint64_t totalMicros;
+    uint32_t lastRows;
+    uint64_t lastMicros;
+};
+
+/**
+ * Commit a transaction through the database worker and wait for its result.
+ * DirectCommitTransaction does not report a failed commit; callers that drop data once it
+ * is stored use this instead. Blocks, so it must not be called from the world thread.
+ * @return true if the transaction was committed
+ */
+bool CommitTransactionAndWait(CharacterDatabaseTransaction trans);
+
+/**
+ * Record one save cycle. Saves commit synchronously on their own thread, so the time
+ * covers building the transaction and executing it.
+ */
+void RecordDatabaseSave(DatabaseSaveKind kind, uint32_t rows, uint32_t statements, uint64_t micros);
+
+DatabaseSaveStats GetDatabaseSaveStats(DatabaseSaveKind kind);
+
+#endif // MOD_OLLAMA_CHAT_DBSAVE_H
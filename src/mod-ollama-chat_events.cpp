@@ -5,6 +5,8 @@
 #include "mod-ollama-chat-utilities.h"
 #include "mod-ollama-chat_personality.h"
 #include "mod-ollama-chat_sentiment.h"
+#include "mod-ollama-chat_admission.h"
+#include "mod-ollama-chat_cooldown.h"
 #include "Player.h"
 #include "ObjectAccessor.h"
 #include "Guild.h"
@@ -20,9 +22,26 @@
 #include <fmt/core.h>
 #include <unordered_map>
 #include <chrono>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <algorithm>
 
 static OllamaBotEventChatter eventChatter;
-static std::unordered_map<Player*, std::chrono::steady_clock::time_point> botEventCooldowns;
+// Bot GUID -> time the bot may react to another event; entries expire once the cooldown ends
+static CooldownStore botEventCooldowns;
+
+// Pending events waiting for their coalescing window to close, keyed by (source GUID, event type)
+struct CoalescedGameEvent
+{
+    std::chrono::steady_clock::time_point windowStart;
+    std::vector<std::pair<std::string, uint32_t>> details; // detail -> count, in arrival order
+    std::string bestDetail;
+    uint32_t bestWeight = 0;
+    uint32_t total = 0;
+};
+static std::map<std::pair<uint64_t, OllamaEventType>, CoalescedGameEvent> coalescedEvents;
+static std::mutex coalescedEventsMutex;
 
 // Helper function to check if a bot is allowed to respond in restricted mode
 static bool IsBotAllowedForRestrictedMode(Player* bot, Player* source)
@@ -64,47 +83,35 @@ static bool IsBotAllowedForRestrictedMode(Player* bot, Player* source)
     return hasRealPlayer;
 }
 
-void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type, std::string detail)
+void OllamaBotEventChatter::DispatchGameEvent(Player* source, OllamaEventType type, std::string detail)
 {
     if (!g_Enable || !g_EnableEventChatter)
         return;
     
-    if (!source)
+    if (!source || type >= EVENT_TYPE_COUNT)
     {
        return;
     }
 
+    const EventTypeConfig& eventType = g_EventTypes[type];
+
     bool isSourceBot = sPlayerbotsMgr->GetPlayerbotAI(source) != nullptr;
     bool hasNearbyRealPlayer = false;
     bool isGuildEvent = false;
 
-    // Only set isGuildEvent for specific event types
-    if (source->GetGuild() && g_EnableGuildEventChatter) {
-        // List of event types that are considered guild events
-        if (
-            type == g_GuildEventTypeGuildJoin ||
-            type == g_GuildEventTypeGuildLeave ||
-            type == g_GuildEventTypeGuildPromotion ||
-            type == g_GuildEventTypeGuildDemotion ||
-            type == g_GuildEventTypeLevelUp ||
-            type == g_GuildEventTypeEpicGear ||
-            type == g_GuildEventTypeRareGear ||
-            type == g_GuildEventTypeDungeonComplete ||
-            type == g_GuildEventTypeGuildAchievement ||
-            type == g_GuildEventTypeGuildLogin
-        ) {
-            // Check if there are real players in the guild
-            Guild* guild = source->GetGuild();
-            for (auto const& pair : ObjectAccessor::GetPlayers()) {
-                Player* player = pair.second;
-                if (!player || !player->IsInWorld())
-                    continue;
-                if (sPlayerbotsMgr->GetPlayerbotAI(player))
-                    continue;
-                if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId()) {
-                    isGuildEvent = true;
-                    break;
-                }
+    // Only guild event types are routed to guild chat
+    if (eventType.isGuild && source->GetGuild() && g_EnableGuildEventChatter) {
+        // Check if there are real players in the guild
+        Guild* guild = source->GetGuild();
+        for (auto const& pair : ObjectAccessor::GetPlayers()) {
+            Player* player = pair.second;
+            if (!player || !player->IsInWorld())
+                continue;
+            if (sPlayerbotsMgr->GetPlayerbotAI(player))
+                continue;
+            if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId()) {
+                isGuildEvent = true;
+                break;
             }
         }
     }
@@ -133,7 +140,7 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
     }
 
     if (g_DebugEnabled)
-        LOG_INFO("server.loading", "[OllamaChat] DispatchGameEvent from {} | type={} | detail={}", source->GetName(), type, detail);
+        LOG_INFO("server.loading", "[OllamaChat] DispatchGameEvent from {} | type={} | detail={}", source->GetName(), eventType.text, detail);
 
     float maxDist = g_EventChatterRealPlayerDistance;
     bool disableInCombat = g_DisableRepliesInCombat;
@@ -194,7 +201,7 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
     }
 
     // Check cooldown for bots
-    auto now = std::chrono::steady_clock::now();
+    time_t now = time(nullptr);
     for (auto it = candidateBots.begin(); it != candidateBots.end(); ) {
         Player* bot = *it;
         
@@ -204,77 +211,22 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
             continue;
         }
         
-        auto lastEventTime = botEventCooldowns[bot]; // Track last event time for any event
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastEventTime).count() < g_EventCooldownTime) {
+        uint64_t botGuid = bot->GetGUID().GetRawValue();
+        if (botEventCooldowns.IsActive(botGuid, now)) {
             it = candidateBots.erase(it); // Remove bot if still in cooldown
         } else {
-            botEventCooldowns[bot] = now; // Update last event time
+            botEventCooldowns.Set(botGuid, now + eventType.cooldown); // Cooldown applies to any event
             ++it;
         }
     }
 
     // Check event-specific chance
-    float eventChance = 0.0f;
-    if (type == g_EventTypeLearnedSpell) {
-        eventChance = g_EventTypeLearnedSpell_Chance;
-    } else if (type == g_EventTypeDefeated) {
-        eventChance = g_EventTypeDefeated_Chance;
-    } else if (type == g_EventTypeDefeatedPlayer) {
-        eventChance = g_EventTypeDefeatedPlayer_Chance;
-    } else if (type == g_EventTypePetDefeated) {
-        eventChance = g_EventTypePetDefeated_Chance;
-    } else if (type == g_EventTypeGotItem) {
-        eventChance = g_EventTypeGotItem_Chance;
-    } else if (type == g_EventTypeDied) {
-        eventChance = g_EventTypeDied_Chance;
-    } else if (type == g_EventTypeCompletedQuest) {
-        eventChance = g_EventTypeCompletedQuest_Chance;
-    } else if (type == g_EventTypeRequestedDuel) {
-        eventChance = g_EventTypeRequestedDuel_Chance;
-    } else if (type == g_EventTypeStartedDueling) {
-        eventChance = g_EventTypeStartedDueling_Chance;
-    } else if (type == g_EventTypeWonDuel) {
-        eventChance = g_EventTypeWonDuel_Chance;
-    } else if (type == g_EventTypeLeveledUp) {
-        eventChance = g_EventTypeLeveledUp_Chance;
-    } else if (type == g_EventTypeAchievement) {
-        eventChance = g_EventTypeAchievement_Chance;
-    } else if (type == g_EventTypeUsedObject) {
-        eventChance = g_EventTypeUsedObject_Chance;
-    }
-
-    // Add chance checks for all GuildEventType entries
-    if (type == g_GuildEventTypeEpicGear) {
-        eventChance = g_GuildEventTypeEpicGear_Chance;
-    } else if (type == g_GuildEventTypeRareGear) {
-        eventChance = g_GuildEventTypeRareGear_Chance;
-    } else if (type == g_GuildEventTypeGuildJoin) {
-        eventChance = g_GuildEventTypeGuildJoin_Chance;
-    } else if (type == g_GuildEventTypeGuildLogin) {
-        eventChance = g_GuildEventTypeGuildLogin_Chance;
-    } else if (type == g_GuildEventTypeGuildLeave) {
-        eventChance = g_GuildEventTypeGuildLeave_Chance;
-    } else if (type == g_GuildEventTypeGuildPromotion) {
-        eventChance = g_GuildEventTypeGuildPromotion_Chance;
-    } else if (type == g_GuildEventTypeGuildDemotion) {
-        eventChance = g_GuildEventTypeGuildDemotion_Chance;
-    } else if (type == g_GuildEventTypeGuildAchievement) {
-        eventChance = g_GuildEventTypeGuildAchievement_Chance;
-    } else if (type == g_GuildEventTypeLevelUp) {
-        eventChance = g_GuildEventTypeLevelUp_Chance;
-    } else if (type == g_GuildEventTypeDungeonComplete) {
-        eventChance = g_GuildEventTypeDungeonComplete_Chance;
-    }
+    float eventChance = eventType.chance;
 
     if (urand(0, 100) > eventChance) {
         return;
     }
 
-    // Update cooldowns
-    for (Player* bot : candidateBots) {
-        botEventCooldowns[bot] = now;
-    }
-
     uint32_t responses = 0;
 
     for (Player* bot : candidateBots)
@@ -312,6 +264,12 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
             continue;
         }
 
+        if (!TryAdmitLLMRequest(LLM_SOURCE_EVENT)) {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[OllamaChat] Skipping {} - request budget exhausted", bot->GetName());
+            continue;
+        }
+
         if (g_DebugEnabled)
             LOG_INFO("server.loading", "[OllamaChat] Queueing event for bot {}", bot->GetName());
 
@@ -328,21 +286,121 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
 }
 
 
-void OllamaBotEventChatter::QueueEvent(Player* bot, std::string type, std::string detail, std::string actorName, bool isGuildEvent)
+// Builds the detail text for a merged event, e.g. "Defias Bandit (x7)" or "Cruel Barb and 3 other items"
+static std::string SummarizeCoalescedEvent(OllamaEventType type, const CoalescedGameEvent& event)
+{
+    if (event.total == 1 || event.details.empty())
+        return event.bestDetail;
+
+    if (type == EVENT_TYPE_GOT_ITEM)
+    {
+        uint32_t others = event.total - 1;
+        return SafeFormat("{} and {} other {}", event.bestDetail, others, others == 1 ? "item" : "items");
+    }
+
+    const size_t maxListed = 3;
+    std::string summary;
+    for (size_t i = 0; i < event.details.size() && i < maxListed; ++i)
+    {
+        if (!summary.empty())
+            summary += ", ";
+        const auto& [detail, count] = event.details[i];
+        summary += count > 1 ? SafeFormat("{} (x{})", detail, count) : detail;
+    }
+    if (event.details.size() > maxListed)
+        summary += SafeFormat(" and {} more", event.details.size() - maxListed);
+    return summary;
+}
+
+void OllamaBotEventChatter::CoalesceGameEvent(Player* source, OllamaEventType type, const std::string& detail, uint32_t weight)
+{
+    if (!g_Enable || !g_EnableEventChatter || !source)
+        return;
+
+    if (g_EventCoalesceWindowMs == 0)
+    {
+        DispatchGameEvent(source, type, detail);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(coalescedEventsMutex);
+    auto [it, inserted] = coalescedEvents.try_emplace({ source->GetGUID().GetRawValue(), type });
+    CoalescedGameEvent& event = it->second;
+    if (inserted)
+        event.windowStart = std::chrono::steady_clock::now();
+
+    auto detailIt = std::find_if(event.details.begin(), event.details.end(),
+        [&detail](const std::pair<std::string, uint32_t>& entry) { return entry.first == detail; });
+    if (detailIt != event.details.end())
+        ++detailIt->second;
+    else
+        event.details.emplace_back(detail, 1);
+
+    if (event.total == 0 || weight > event.bestWeight)
+    {
+        event.bestDetail = detail;
+        event.bestWeight = weight;
+    }
+    ++event.total;
+}
+
+void OllamaBotEventChatter::FlushCoalescedEvents()
+{
+    std::vector<std::tuple<uint64_t, OllamaEventType, std::string>> ready;
+    {
+        std::lock_guard<std::mutex> lock(coalescedEventsMutex);
+        if (coalescedEvents.empty())
+            return;
+
+        auto now = std::chrono::steady_clock::now();
+        auto window = std::chrono::milliseconds(g_EventCoalesceWindowMs);
+        for (auto it = coalescedEvents.begin(); it != coalescedEvents.end(); )
+        {
+            if (now - it->second.windowStart < window)
+            {
+                ++it;
+                continue;
+            }
+            ready.emplace_back(it->first.first, it->first.second, SummarizeCoalescedEvent(it->first.second, it->second));
+            if (g_DebugEnabled && it->second.total > 1)
+                LOG_INFO("server.loading", "[OllamaChat] Coalesced {} '{}' events into one", it->second.total, g_EventTypes[it->first.second].text);
+            it = coalescedEvents.erase(it);
+        }
+    }
+
+    // Dispatch outside the lock; the source may have logged out during the window
+    for (const auto& [sourceGuid, type, detail] : ready)
+    {
+        Player* source = ObjectAccessor::FindPlayer(ObjectGuid(sourceGuid));
+        if (!source || !source->IsInWorld())
+            continue;
+        DispatchGameEvent(source, type, detail);
+    }
+}
+
+void FlushCoalescedGameEvents()
+{
+    eventChatter.FlushCoalescedEvents();
+}
+
+void OllamaBotEventChatter::QueueEvent(Player* bot, OllamaEventType type, std::string detail, std::string actorName, bool isGuildEvent)
 {
-    if (!g_Enable || !g_EnableEventChatter || !bot)
+    if (!g_Enable || !g_EnableEventChatter || !bot || type >= EVENT_TYPE_COUNT)
         return;
 
     uint64_t botGuid = bot->GetGUID().GetRawValue();
+    // Taken now so a config reload cannot change the text or template under the worker thread
+    std::string eventText = g_EventTypes[type].text;
+    std::shared_ptr<const PromptTemplates> templates = GetPromptTemplates();
 
-    std::thread([this, botGuid, type, detail, actorName, isGuildEvent]()
+    std::thread([this, botGuid, eventText, templates, type, detail, actorName, isGuildEvent]()
     {
         try
         {
             Player* botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
             if (!botPtr) return;
 
-            std::string prompt = BuildPrompt(botPtr, g_EventChatterPromptTemplate, type, detail, actorName);
+            std::string prompt = BuildPrompt(botPtr, templates->events[type], eventText, detail, actorName);
             if (prompt.empty()) return;
 
             std::string response = QueryOllamaAPI(prompt);
@@ -369,7 +427,7 @@ void OllamaBotEventChatter::QueueEvent(Player* bot, std::string type, std::strin
 }
 
 
-std::string OllamaBotEventChatter::BuildPrompt(Player* bot, std::string promptTemplate, std::string eventType, std::string eventDetail, std::string actorName)
+std::string OllamaBotEventChatter::BuildPrompt(Player* bot, const CompiledPromptTemplate& promptTemplate, std::string eventType, std::string eventDetail, std::string actorName)
 {
     if (!bot) return "";
 
@@ -382,7 +440,9 @@ std::string OllamaBotEventChatter::BuildPrompt(Player* bot, std::string promptTe
     std::string botClass = ai->GetChatHelper() ? ai->GetChatHelper()->FormatClass(bot->getClass()) : "UnknownClass";
     uint32_t botLevel = bot->GetLevel();
     std::string botRace = ai->GetChatHelper() ? ai->GetChatHelper()->FormatRace(bot->getRace()) : "UnknownRace";
-    std::string botRole = ai->GetChatHelper() ? ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot)) : "UnknownRole";
+    std::string botRole;
+    if (promptTemplate.Uses(PROMPT_VAR_BOT_ROLE))
+        botRole = ai->GetChatHelper() ? ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot)) : "UnknownRole";
     std::string botGender = bot->getGender() == GENDER_MALE ? "Male" : "Female";
     std::string botFaction = bot->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde";
 
@@ -394,7 +454,7 @@ std::string OllamaBotEventChatter::BuildPrompt(Player* bot, std::string promptTe
 
     // Try to get sentiment information if the actor is a player
     std::string sentimentInfo = "";
-    if (g_EnableSentimentTracking && !actorName.empty())
+    if (g_EnableSentimentTracking && !actorName.empty() && promptTemplate.Uses(PROMPT_VAR_SENTIMENT_INFO))
     {
         // Try to find the actor player by name
         Player* actorPlayer = ObjectAccessor::FindPlayerByName(actorName);
@@ -404,25 +464,24 @@ std::string OllamaBotEventChatter::BuildPrompt(Player* bot, std::string promptTe
         }
     }
 
-    return SafeFormat(
-        promptTemplate,
-        fmt::arg("bot_name", botName),
-        fmt::arg("bot_level", botLevel),
-        fmt::arg("bot_class", botClass),
-        fmt::arg("bot_race", botRace),
-        fmt::arg("bot_gender", botGender),
-        fmt::arg("bot_role", botRole),
-        fmt::arg("bot_faction", botFaction),
-        fmt::arg("bot_area", botAreaName),
-        fmt::arg("bot_zone", botZoneName),
-        fmt::arg("bot_map", botMapName),
-        fmt::arg("bot_personality", personalityPrompt),
-        fmt::arg("bot_personality_name", personality),
-        fmt::arg("event_type", eventType),
-        fmt::arg("event_detail", eventDetail),
-        fmt::arg("actor_name", actorName),
-        fmt::arg("sentiment_info", sentimentInfo)
-    );
+    PromptVars vars;
+    vars.Set(PROMPT_VAR_BOT_NAME, botName);
+    vars.Set(PROMPT_VAR_BOT_LEVEL, botLevel);
+    vars.Set(PROMPT_VAR_BOT_CLASS, botClass);
+    vars.Set(PROMPT_VAR_BOT_RACE, botRace);
+    vars.Set(PROMPT_VAR_BOT_GENDER, botGender);
+    vars.Set(PROMPT_VAR_BOT_ROLE, botRole);
+    vars.Set(PROMPT_VAR_BOT_FACTION, botFaction);
+    vars.Set(PROMPT_VAR_BOT_AREA, botAreaName);
+    vars.Set(PROMPT_VAR_BOT_ZONE, botZoneName);
+    vars.Set(PROMPT_VAR_BOT_MAP, botMapName);
+    vars.Set(PROMPT_VAR_BOT_PERSONALITY, personalityPrompt);
+    vars.Set(PROMPT_VAR_BOT_PERSONALITY_NAME, personality);
+    vars.Set(PROMPT_VAR_EVENT_TYPE, eventType);
+    vars.Set(PROMPT_VAR_EVENT_DETAIL, eventDetail);
+    vars.Set(PROMPT_VAR_ACTOR_NAME, actorName);
+    vars.Set(PROMPT_VAR_SENTIMENT_INFO, sentimentInfo);
+    return promptTemplate.Render(vars);
 }
 
 // === Script Hooks ===
@@ -435,7 +494,7 @@ void ChatOnKill::OnPlayerCreatureKill(Player* killer, Creature* victim)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(killer, g_EventTypeDefeated, victim->GetName());
+    eventChatter.CoalesceGameEvent(killer, EVENT_TYPE_DEFEATED, victim->GetName());
 }
 
 void ChatOnKill::OnPlayerPVPKill(Player* killer, Player* killed)
@@ -444,7 +503,7 @@ void ChatOnKill::OnPlayerPVPKill(Player* killer, Player* killed)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(killer, g_EventTypeDefeatedPlayer, killed->GetName());
+    eventChatter.DispatchGameEvent(killer, EVENT_TYPE_DEFEATED_PLAYER, killed->GetName());
 }
 
 void ChatOnKill::OnPlayerCreatureKilledByPet(Player* owner, Creature* victim)
@@ -453,7 +512,7 @@ void ChatOnKill::OnPlayerCreatureKilledByPet(Player* owner, Creature* victim)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(owner, g_EventTypePetDefeated, victim->GetName());
+    eventChatter.CoalesceGameEvent(owner, EVENT_TYPE_PET_DEFEATED, victim->GetName());
 }
 
 ChatOnLoot::ChatOnLoot() : PlayerScript("ChatOnLoot") {}
@@ -466,23 +525,24 @@ void ChatOnLoot::OnPlayerStoreNewItem(Player* player, Item* item, uint32 /*count
     }
     if (item->GetTemplate()->Quality >= ITEM_QUALITY_UNCOMMON)
     {
-        eventChatter.DispatchGameEvent(player, g_EventTypeGotItem, item->GetTemplate()->Name1);
+        // Quality ranks the loot so the summary leads with the best item
+        eventChatter.CoalesceGameEvent(player, EVENT_TYPE_GOT_ITEM, item->GetTemplate()->Name1, item->GetTemplate()->Quality);
     }
     
     // Guild-specific gear events
     if (player->GetGuild() && g_EnableGuildEventChatter)
     {
-        if (item->GetTemplate()->Quality == ITEM_QUALITY_EPIC && !g_GuildEventTypeEpicGear.empty())
+        if (item->GetTemplate()->Quality == ITEM_QUALITY_EPIC && !g_EventTypes[GUILD_EVENT_TYPE_EPIC_GEAR].text.empty())
         {
-            eventChatter.DispatchGameEvent(player, g_GuildEventTypeEpicGear, item->GetTemplate()->Name1);
+            eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_EPIC_GEAR, item->GetTemplate()->Name1);
         }
-        else if (item->GetTemplate()->Quality == ITEM_QUALITY_RARE && !g_GuildEventTypeRareGear.empty())
+        else if (item->GetTemplate()->Quality == ITEM_QUALITY_RARE && !g_EventTypes[GUILD_EVENT_TYPE_RARE_GEAR].text.empty())
         {
             // Only announce rare gear if it's equipment (not consumables, etc.)
             if (item->GetTemplate()->Class == ITEM_CLASS_WEAPON || 
                 item->GetTemplate()->Class == ITEM_CLASS_ARMOR)
             {
-                eventChatter.DispatchGameEvent(player, g_GuildEventTypeRareGear, item->GetTemplate()->Name1);
+                eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_RARE_GEAR, item->GetTemplate()->Name1);
             }
         }
     }
@@ -496,7 +556,7 @@ void ChatOnDeath::OnPlayerJustDied(Player* player)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(player, g_EventTypeDied, "");
+    eventChatter.DispatchGameEvent(player, EVENT_TYPE_DIED, "");
 }
 
 ChatOnQuest::ChatOnQuest() : PlayerScript("ChatOnQuest") {}
@@ -507,16 +567,16 @@ void ChatOnQuest::OnPlayerCompleteQuest(Player* player, Quest const* quest)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(player, g_EventTypeCompletedQuest, quest->GetTitle());
+    eventChatter.DispatchGameEvent(player, EVENT_TYPE_COMPLETED_QUEST, quest->GetTitle());
     
     // Guild-specific dungeon completion events
-    if (player->GetGuild() && g_EnableGuildEventChatter && !g_GuildEventTypeDungeonComplete.empty())
+    if (player->GetGuild() && g_EnableGuildEventChatter && !g_EventTypes[GUILD_EVENT_TYPE_DUNGEON_COMPLETE].text.empty())
     {
         // Check if this is a dungeon quest
         if (player->GetMap() && player->GetMap()->IsDungeon())
         {
             std::string dungeonInfo = SafeFormat("{} in {}", quest->GetTitle(), player->GetMap()->GetMapName());
-            eventChatter.DispatchGameEvent(player, g_GuildEventTypeDungeonComplete, dungeonInfo);
+            eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_DUNGEON_COMPLETE, dungeonInfo);
         }
     }
 }
@@ -532,11 +592,11 @@ void ChatOnLearn::OnPlayerLearnSpell(Player* player, uint32 spellID)
     SpellInfo const* spellInfo = sSpellMgr->GetSpellInfo(spellID);
     if (spellInfo)
     {
-        eventChatter.DispatchGameEvent(player, g_EventTypeLearnedSpell, spellInfo->SpellName[0]);
+        eventChatter.DispatchGameEvent(player, EVENT_TYPE_LEARNED_SPELL, spellInfo->SpellName[0]);
     }
     else
     {
-        eventChatter.DispatchGameEvent(player, g_EventTypeLearnedSpell, std::to_string(spellID));
+        eventChatter.DispatchGameEvent(player, EVENT_TYPE_LEARNED_SPELL, std::to_string(spellID));
     }
 }
 
@@ -548,7 +608,7 @@ void ChatOnDuel::OnPlayerDuelRequest(Player* target, Player* challenger)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(challenger, g_EventTypeRequestedDuel, target->GetName());
+    eventChatter.DispatchGameEvent(challenger, EVENT_TYPE_REQUESTED_DUEL, target->GetName());
 }
 
 void ChatOnDuel::OnPlayerDuelStart(Player* player1, Player* player2)
@@ -557,7 +617,7 @@ void ChatOnDuel::OnPlayerDuelStart(Player* player1, Player* player2)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(player1, g_EventTypeStartedDueling, player2->GetName());
+    eventChatter.DispatchGameEvent(player1, EVENT_TYPE_STARTED_DUELING, player2->GetName());
 }
 
 void ChatOnDuel::OnPlayerDuelEnd(Player* winner, Player* loser, DuelCompleteType /*type*/)
@@ -566,7 +626,7 @@ void ChatOnDuel::OnPlayerDuelEnd(Player* winner, Player* loser, DuelCompleteType
     {
         return;
     }
-    eventChatter.DispatchGameEvent(winner, g_EventTypeWonDuel, loser->GetName());
+    eventChatter.DispatchGameEvent(winner, EVENT_TYPE_WON_DUEL, loser->GetName());
 }
 
 ChatOnLevelUp::ChatOnLevelUp() : PlayerScript("ChatOnLevelUp") {}
@@ -577,12 +637,12 @@ void ChatOnLevelUp::OnPlayerLevelChanged(Player* player, uint8 /*oldLevel*/)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(player, g_EventTypeLeveledUp, std::to_string(player->GetLevel()));
+    eventChatter.DispatchGameEvent(player, EVENT_TYPE_LEVELED_UP, std::to_string(player->GetLevel()));
     
     // Guild-specific level up events
-    if (player->GetGuild() && g_EnableGuildEventChatter && !g_GuildEventTypeLevelUp.empty())
+    if (player->GetGuild() && g_EnableGuildEventChatter && !g_EventTypes[GUILD_EVENT_TYPE_LEVEL_UP].text.empty())
     {
-        eventChatter.DispatchGameEvent(player, g_GuildEventTypeLevelUp, std::to_string(player->GetLevel()));
+        eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_LEVEL_UP, std::to_string(player->GetLevel()));
     }
 }
 
@@ -595,13 +655,13 @@ void ChatOnAchievement::OnPlayerCompleteAchievement(Player* player, AchievementE
     {
         return;
     }
-    eventChatter.DispatchGameEvent(player, g_EventTypeAchievement, achievement->name[0]);
+    eventChatter.DispatchGameEvent(player, EVENT_TYPE_ACHIEVEMENT, achievement->name[0]);
 
     // Guild-specific achievement event for real players only
-    if (player->GetGuild() && g_EnableGuildEventChatter && !g_GuildEventTypeGuildAchievement.empty())
+    if (player->GetGuild() && g_EnableGuildEventChatter && !g_EventTypes[GUILD_EVENT_TYPE_GUILD_ACHIEVEMENT].text.empty())
     {
         if (!sPlayerbotsMgr->GetPlayerbotAI(player)) // Only real players
-            eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildAchievement, achievement->name[0]);
+            eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_GUILD_ACHIEVEMENT, achievement->name[0]);
     }
 }
 
@@ -613,7 +673,7 @@ void ChatOnGameObjectUse::OnGameObjectUse(Player* player, GameObject* go)
     {
         return;
     }
-    eventChatter.DispatchGameEvent(player, g_EventTypeUsedObject, go->GetGOInfo()->name);
+    eventChatter.DispatchGameEvent(player, EVENT_TYPE_USED_OBJECT, go->GetGOInfo()->name);
 }
 
 ChatOnGuildMemberChange::ChatOnGuildMemberChange() : PlayerScript("ChatOnGuildMemberChange") {}
@@ -623,8 +683,8 @@ void ChatOnGuildMemberChange::OnGuildMemberJoin(Player* player, Guild* /*guild*/
     if (!player || !player->GetGuild() || !g_EnableGuildEventChatter)
         return;
         
-    if (!g_GuildEventTypeGuildJoin.empty())
-        eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildJoin, player->GetGuild()->GetName());
+    if (!g_EventTypes[GUILD_EVENT_TYPE_GUILD_JOIN].text.empty())
+        eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_GUILD_JOIN, player->GetGuild()->GetName());
 }
 
 void ChatOnGuildMemberChange::OnGuildMemberLeave(Player* player, Guild* guild)
@@ -632,8 +692,8 @@ void ChatOnGuildMemberChange::OnGuildMemberLeave(Player* player, Guild* guild)
     if (!player || !guild || !g_EnableGuildEventChatter)
         return;
         
-    if (!g_GuildEventTypeGuildLeave.empty())
-        eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildLeave, guild->GetName());
+    if (!g_EventTypes[GUILD_EVENT_TYPE_GUILD_LEAVE].text.empty())
+        eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_GUILD_LEAVE, guild->GetName());
 }
 
 void ChatOnGuildMemberChange::OnGuildMemberRankChange(Player* player, Guild* /*guild*/, uint8 /*oldRank*/, uint8 newRank)
@@ -644,14 +704,14 @@ void ChatOnGuildMemberChange::OnGuildMemberRankChange(Player* player, Guild* /*g
     if (newRank < player->GetGuild()->GetMember(player->GetGUID())->GetRankId())
     {
         // Promotion
-        if (!g_GuildEventTypeGuildPromotion.empty())
-            eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildPromotion, std::to_string(newRank));
+        if (!g_EventTypes[GUILD_EVENT_TYPE_GUILD_PROMOTION].text.empty())
+            eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_GUILD_PROMOTION, std::to_string(newRank));
     }
     else
     {
         // Demotion
-        if (!g_GuildEventTypeGuildDemotion.empty())
-            eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildDemotion, std::to_string(newRank));
+        if (!g_EventTypes[GUILD_EVENT_TYPE_GUILD_DEMOTION].text.empty())
+            eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_GUILD_DEMOTION, std::to_string(newRank));
     }
 }
 
@@ -662,7 +722,7 @@ void ChatOnGuildMemberChange::OnGuildMemberLogin(Player* player, Guild* guild)
         return;
     if (sPlayerbotsMgr->GetPlayerbotAI(player))
         return; // Only real players
-    if (!g_GuildEventTypeGuildLogin.empty())
-        eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildLogin, guild->GetName());
+    if (!g_EventTypes[GUILD_EVENT_TYPE_GUILD_LOGIN].text.empty())
+        eventChatter.DispatchGameEvent(player, GUILD_EVENT_TYPE_GUILD_LOGIN, guild->GetName());
 }
 
@@ -3,16 +3,24 @@
 
 #include "ScriptMgr.h"
 #include "Player.h"
+#include "mod-ollama-chat_config.h"
 #include <string>
 
 class OllamaBotEventChatter
 {
 public:
-    void DispatchGameEvent(Player* source, std::string type, std::string detail);
-    void QueueEvent(Player* bot, std::string type, std::string detail, std::string actorName, bool isGuildEvent = false);
-    std::string BuildPrompt(Player* bot, std::string promptTemplate, std::string eventType, std::string eventDetail, std::string actorName);
+    void DispatchGameEvent(Player* source, OllamaEventType type, std::string detail);
+    // Buffers high-frequency events (kills, loot) per source and type; they are merged into
+    // one summarized event when the coalescing window closes. weight picks the headline detail.
+    void CoalesceGameEvent(Player* source, OllamaEventType type, const std::string& detail, uint32_t weight = 0);
+    void FlushCoalescedEvents();
+    void QueueEvent(Player* bot, OllamaEventType type, std::string detail, std::string actorName, bool isGuildEvent = false);
+    std::string BuildPrompt(Player* bot, const CompiledPromptTemplate& promptTemplate, std::string eventType, std::string eventDetail, std::string actorName);
 };
 
+// Dispatches coalesced events whose window has closed. Called from the world update.
+void FlushCoalescedGameEvents();
+
 class ChatOnKill : public PlayerScript
 {
 public:
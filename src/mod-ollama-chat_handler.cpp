@@ -30,6 +30,11 @@
 #include "mod-ollama-chat-utilities.h"
 #include "mod-ollama-chat_sentiment.h"
 #include "mod-ollama-chat_rag.h"
+#include "mod-ollama-chat_blacklist.h"
+#include "mod-ollama-chat_admission.h"
+#include "mod-ollama-chat_snapshot.h"
+#include "mod-ollama-chat_context.h"
+#include "mod-ollama-chat_history.h"
 #include <iomanip>
 #include "SpellMgr.h"
 #include "SpellInfo.h"
@@ -48,48 +53,28 @@
 #include "Map.h"
 #include "GridNotifiers.h"
 
+// Everything a chat reply prompt needs from the world thread. The history and sentiment
+// are filled in and the prompt assembled by FinishBotPrompt on the reply thread.
+struct ChatPromptDraft
+{
+    OllamaRequest request;       // System prompt, conversation and context set; prompt still empty
+    std::shared_ptr<const PromptTemplates> templates;   // Set the sections were rendered with
+    PromptVars    vars;          // All chat template values except {chat_history}
+    std::string   persona;       // Persona section, when it goes in the prompt
+    std::string   ragInfo;       // Appended RAG section
+    std::string   snapshot;      // Game-state snapshot section
+    std::string   playerName;
+    std::string   playerMessage;
+    bool          renderHistory = false;     // Render {chat_history}
+    bool          renderSentiment = false;   // Render {sentiment_info}
+    bool          sendHistoryTurns = false;  // Send the history as chat messages
+};
+
 // Forward declarations for internal helper functions.
 static bool IsBotEligibleForChatChannelLocal(Player* bot, Player* player,
                                              ChatChannelSourceLocal source, Channel* channel = nullptr, Player* receiver = nullptr);
-static std::string GenerateBotPrompt(Player* bot, std::string playerMessage, Player* player);
-
-// Helper function to format class name for any player
-static std::string FormatPlayerClass(uint8_t classId)
-{
-    switch (classId)
-    {
-        case CLASS_WARRIOR:      return "Warrior";
-        case CLASS_PALADIN:      return "Paladin";
-        case CLASS_HUNTER:       return "Hunter";
-        case CLASS_ROGUE:        return "Rogue";
-        case CLASS_PRIEST:       return "Priest";
-        case CLASS_DEATH_KNIGHT: return "Death Knight";
-        case CLASS_SHAMAN:       return "Shaman";
-        case CLASS_MAGE:         return "Mage";
-        case CLASS_WARLOCK:      return "Warlock";
-        case CLASS_DRUID:        return "Druid";
-        default:                 return "Unknown";
-    }
-}
-
-// Helper function to format race name for any player
-static std::string FormatPlayerRace(uint8_t raceId)
-{
-    switch (raceId)
-    {
-        case RACE_HUMAN:         return "Human";
-        case RACE_ORC:           return "Orc";
-        case RACE_DWARF:         return "Dwarf";
-        case RACE_NIGHTELF:      return "Night Elf";
-        case RACE_UNDEAD_PLAYER: return "Undead";
-        case RACE_TAUREN:        return "Tauren";
-        case RACE_GNOME:         return "Gnome";
-        case RACE_TROLL:         return "Troll";
-        case RACE_BLOODELF:      return "Blood Elf";
-        case RACE_DRAENEI:       return "Draenei";
-        default:                 return "Unknown";
-    }
-}
+static ChatPromptDraft GenerateBotPrompt(Player* bot, std::string playerMessage, Player* player);
+static OllamaRequest FinishBotPrompt(ChatPromptDraft draft);
 
 const char* ChatChannelSourceLocalStr[] =
 {
@@ -257,420 +242,6 @@ void PlayerBotChatHandler::OnPlayerChat(Player* player, uint32_t type, uint32_t
     ProcessChat(player, type, lang, msg, sourceLocal, nullptr, receiver);
 }
 
-void AppendBotConversation(uint64_t botGuid, uint64_t playerGuid, const std::string& playerMessage, const std::string& botReply)
-{
-    std::lock_guard<std::mutex> lock(g_ConversationHistoryMutex);
-    auto& playerHistory = g_BotConversationHistory[botGuid][playerGuid];
-    playerHistory.push_back({ playerMessage, botReply });
-    while (playerHistory.size() > g_MaxConversationHistory)
-    {
-        playerHistory.pop_front();
-    }
-
-}
-
-void SaveBotConversationHistoryToDB()
-{
-    std::lock_guard<std::mutex> lock(g_ConversationHistoryMutex);
-
-    for (const auto& [botGuid, playerMap] : g_BotConversationHistory) {
-        for (const auto& [playerGuid, history] : playerMap) {
-            for (const auto& pair : history) {
-                const std::string& playerMessage = pair.first;
-                const std::string& botReply = pair.second;
-
-                std::string escPlayerMsg = playerMessage;
-                CharacterDatabase.EscapeString(escPlayerMsg);
-
-                std::string escBotReply = botReply;
-                CharacterDatabase.EscapeString(escBotReply);
-
-                CharacterDatabase.Execute(SafeFormat(
-                    "INSERT IGNORE INTO mod_ollama_chat_history (bot_guid, player_guid, timestamp, player_message, bot_reply) "
-                    "VALUES ({}, {}, NOW(), '{}', '{}')",
-                    botGuid, playerGuid, escPlayerMsg, escBotReply));
-            }
-        }
-    }
-
-    // Cleanup: keep only the N most recent entries per bot/player pair
-    std::string cleanupQuery = R"SQL(
-        WITH ranked_history AS (
-            SELECT
-                bot_guid,
-                player_guid,
-                timestamp,
-                ROW_NUMBER() OVER (
-                    PARTITION BY bot_guid, player_guid
-                    ORDER BY timestamp DESC
-                ) as rn
-            FROM mod_ollama_chat_history
-        )
-        DELETE FROM mod_ollama_chat_history
-        WHERE (bot_guid, player_guid, timestamp) IN (
-            SELECT bot_guid, player_guid, timestamp
-            FROM ranked_history
-            WHERE rn > {}
-        );
-    )SQL";
-    CharacterDatabase.Execute(SafeFormat(cleanupQuery, g_MaxConversationHistory));
-}
-
-
-std::string GetBotHistoryPrompt(uint64_t botGuid, uint64_t playerGuid, std::string playerMessage)
-{
-    if(!g_EnableChatHistory)
-    {
-        return "";
-    }
-    
-    std::lock_guard<std::mutex> lock(g_ConversationHistoryMutex);
-
-    std::string result;
-    const auto botIt = g_BotConversationHistory.find(botGuid);
-    if (botIt == g_BotConversationHistory.end())
-        return result;
-    const auto playerIt = botIt->second.find(playerGuid);
-    if (playerIt == botIt->second.end())
-        return result;
-
-    Player* player = ObjectAccessor::FindPlayer(ObjectGuid(playerGuid));
-    std::string playerName = player ? player->GetName() : "The player";
-
-    result += SafeFormat(g_ChatHistoryHeaderTemplate, fmt::arg("player_name", playerName));
-
-    for (const auto& entry : playerIt->second) {
-        result += SafeFormat(g_ChatHistoryLineTemplate,
-            fmt::arg("player_name", playerName),
-            fmt::arg("player_message", entry.first),
-            fmt::arg("bot_reply", entry.second)
-        );
-    }
-
-    result += SafeFormat(g_ChatHistoryFooterTemplate,
-        fmt::arg("player_name", playerName),
-        fmt::arg("player_message", playerMessage)
-    );
-
-    return result;
-}
-
-// --- Helper: Spells ---
-std::string ChatHandler_GetBotSpellInfo(Player* bot)
-{
-    // Map to store highest rank of each spell: spell name -> (spellId, rank, costText)
-    std::map<std::string, std::tuple<uint32, uint32, std::string>> uniqueSpells;
-    
-    for (const auto& spellPair : bot->GetSpellMap())
-    {
-        uint32 spellId = spellPair.first;
-        const SpellInfo* spellInfo = sSpellMgr->GetSpellInfo(spellId);
-        if (!spellInfo || spellInfo->Attributes & SPELL_ATTR0_PASSIVE)
-            continue;
-        if (spellInfo->SpellFamilyName == SPELLFAMILY_GENERIC)
-            continue;
-        if (bot->HasSpellCooldown(spellId))
-            continue;
-        
-        const char* name = spellInfo->SpellName[0];
-        if (!name || !*name)
-            continue;
-        
-        std::string costText;
-        if (spellInfo->ManaCost || spellInfo->ManaCostPercentage)
-        {
-            switch (spellInfo->PowerType)
-            {
-                case POWER_MANA: costText = std::to_string(spellInfo->ManaCost) + " mana"; break;
-                case POWER_RAGE: costText = std::to_string(spellInfo->ManaCost) + " rage"; break;
-                case POWER_FOCUS: costText = std::to_string(spellInfo->ManaCost) + " focus"; break;
-                case POWER_ENERGY: costText = std::to_string(spellInfo->ManaCost) + " energy"; break;
-                case POWER_RUNIC_POWER: costText = std::to_string(spellInfo->ManaCost) + " runic power"; break;
-                default: costText = std::to_string(spellInfo->ManaCost) + " unknown resource"; break;
-            }
-        }
-        else
-        {
-            costText = "no cost";
-        }
-        
-        // Get base spell name (without rank)
-        std::string spellName = name;
-        uint32 rank = spellInfo->GetRank();
-        
-        // Check if we already have this spell, and if so, only keep the highest rank
-        auto it = uniqueSpells.find(spellName);
-        if (it == uniqueSpells.end())
-        {
-            // First time seeing this spell
-            uniqueSpells[spellName] = std::make_tuple(spellId, rank, costText);
-        }
-        else
-        {
-            // We've seen this spell before, check if this is a higher rank
-            uint32 existingRank = std::get<1>(it->second);
-            if (rank > existingRank)
-            {
-                // Replace with higher rank
-                uniqueSpells[spellName] = std::make_tuple(spellId, rank, costText);
-            }
-        }
-    }
-    
-    // Build the output string from unique spells
-    std::ostringstream spellSummary;
-    for (const auto& [spellName, spellData] : uniqueSpells)
-    {
-        uint32 rank = std::get<1>(spellData);
-        const std::string& costText = std::get<2>(spellData);
-        
-        spellSummary << "**" << spellName << "**";
-        if (rank > 0)
-        {
-            spellSummary << " (Rank " << rank << ")";
-        }
-        spellSummary << " - Costs " << costText << "\n";
-    }
-    return spellSummary.str();
-}
-
-// --- Helper: Group info ---
-std::vector<std::string> ChatHandler_GetGroupStatus(Player* bot)
-{
-    std::vector<std::string> info;
-    if (!bot || !bot->GetGroup()) return info;
-    Group* group = bot->GetGroup();
-    for (GroupReference* ref = group->GetFirstMember(); ref; ref = ref->next())
-    {
-        Player* member = ref->GetSource();
-        if (!member || !member->GetMap()) continue;
-        if(bot == member) continue;
-        float dist = bot->GetDistance(member);
-        std::string beingAttacked = "";
-        if (Unit* attacker = member->GetVictim())
-        {
-            beingAttacked = " [Under Attack by " + attacker->GetName() +
-                            ", Level: " + std::to_string(attacker->GetLevel()) + ", HP: " + std::to_string(attacker->GetHealth()) +
-                            "/" + std::to_string(attacker->GetMaxHealth()) + ")]";
-        }
-        std::string className = FormatPlayerClass(member->getClass());
-        std::string raceName = FormatPlayerRace(member->getRace());
-        info.push_back(
-            member->GetName() +
-            " (Level: " + std::to_string(member->GetLevel()) +
-            ", Class: " + className +
-            ", Race: " + raceName +
-            ", HP: " + std::to_string(member->GetHealth()) + "/" + std::to_string(member->GetMaxHealth()) +
-            ", Dist: " + std::to_string(dist) + ")" + beingAttacked
-        );
-
-    }
-    return info;
-}
-
-// --- Helper: Visible players ---
-std::vector<std::string> ChatHandler_GetVisiblePlayers(Player* bot, float radius = 40.0f)
-{
-    std::vector<std::string> players;
-    if (!bot || !bot->GetMap()) return players;
-    for (auto const& pair : ObjectAccessor::GetPlayers())
-    {
-        Player* player = pair.second;
-        if (!player || player == bot) continue;
-        if (!player->IsInWorld() || player->IsGameMaster()) continue;
-        if (player->GetMap() != bot->GetMap()) continue;
-        if (!bot->IsWithinDistInMap(player, radius)) continue;
-        if (!bot->IsWithinLOS(player->GetPositionX(), player->GetPositionY(), player->GetPositionZ())) continue;
-        float dist = bot->GetDistance(player);
-        std::string faction = (player->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
-        std::string className = FormatPlayerClass(player->getClass());
-        std::string raceName = FormatPlayerRace(player->getRace());
-        players.push_back(
-            "Player: " + player->GetName() +
-            " (Level: " + std::to_string(player->GetLevel()) +
-            ", Class: " + className +
-            ", Race: " + raceName +
-            ", Faction: " + faction +
-            ", Distance: " + std::to_string(dist) + ")"
-        );
-
-    }
-    return players;
-}
-
-// --- Helper: Visible locations/objects (creatures and gameobjects) ---
-std::vector<std::string> ChatHandler_GetVisibleLocations(Player* bot, float radius = 40.0f)
-{
-    std::vector<std::string> visible;
-    if (!bot || !bot->GetMap()) return visible;
-    Map* map = bot->GetMap();
-    for (auto const& pair : map->GetCreatureBySpawnIdStore())
-    {
-        Creature* c = pair.second;
-        if (!c) continue;
-        if (c->GetGUID() == bot->GetGUID()) continue;
-        if (!bot->IsWithinDistInMap(c, radius)) continue;
-        if (!bot->IsWithinLOS(c->GetPositionX(), c->GetPositionY(), c->GetPositionZ())) continue;
-        if (c->IsPet() || c->IsTotem()) continue;
-        std::string type;
-        if (c->isDead()) type = "DEAD";
-        else if (c->IsHostileTo(bot)) type = "ENEMY";
-        else if (c->IsFriendlyTo(bot)) type = "FRIENDLY";
-        else type = "NEUTRAL";
-        float dist = bot->GetDistance(c);
-        visible.push_back(
-            type + ": " + c->GetName() +
-            ", Level: " + std::to_string(c->GetLevel()) +
-            ", HP: " + std::to_string(c->GetHealth()) + "/" + std::to_string(c->GetMaxHealth()) +
-            ", Distance: " + std::to_string(dist) + ")"
-        );
-    }
-    for (auto const& pair : map->GetGameObjectBySpawnIdStore())
-    {
-        GameObject* go = pair.second;
-        if (!go) continue;
-        if (!bot->IsWithinDistInMap(go, radius)) continue;
-        if (!bot->IsWithinLOS(go->GetPositionX(), go->GetPositionY(), go->GetPositionZ())) continue;
-        float dist = bot->GetDistance(go);
-        visible.push_back(
-            go->GetName() +
-            ", Type: " + std::to_string(go->GetGoType()) +
-            ", Distance: " + std::to_string(dist) + ")"
-        );
-    }
-    return visible;
-}
-
-// --- Helper: Combat summary ---
-std::string ChatHandler_GetCombatSummary(Player* bot)
-{
-    std::ostringstream oss;
-    bool inCombat = bot->IsInCombat();
-    Unit* victim = bot->GetVictim();
-
-    // Class-specific resource reporting
-    auto classId = bot->getClass();
-
-    auto printResource = [&](std::ostringstream& oss) {
-        switch (classId)
-        {
-            case CLASS_WARRIOR:
-                oss << ", Rage: " << bot->GetPower(POWER_RAGE) << "/" << bot->GetMaxPower(POWER_RAGE);
-                break;
-            case CLASS_ROGUE:
-                oss << ", Energy: " << bot->GetPower(POWER_ENERGY) << "/" << bot->GetMaxPower(POWER_ENERGY);
-                break;
-            case CLASS_DEATH_KNIGHT:
-                oss << ", Runic Power: " << bot->GetPower(POWER_RUNIC_POWER) << "/" << bot->GetMaxPower(POWER_RUNIC_POWER);
-                break;
-            case CLASS_HUNTER:
-                oss << ", Focus: " << bot->GetPower(POWER_FOCUS) << "/" << bot->GetMaxPower(POWER_FOCUS);
-                break;
-            default: // Mana classes
-                if (bot->GetMaxPower(POWER_MANA) > 0)
-                    oss << ", Mana: " << bot->GetPower(POWER_MANA) << "/" << bot->GetMaxPower(POWER_MANA);
-                break;
-        }
-    };
-
-    if (inCombat)
-    {
-        oss << "IN COMBAT: ";
-        if (victim)
-        {
-            oss << "Target: " << victim->GetName()
-                << ", Level: " << victim->GetLevel()
-                << ", HP: " << victim->GetHealth() << "/" << victim->GetMaxHealth();
-        }
-        else
-        {
-            oss << "No current target";
-        }
-        oss << ". ";
-        printResource(oss);
-    }
-    else
-    {
-        oss << "NOT IN COMBAT. ";
-        printResource(oss);
-    }
-    return oss.str();
-}
-
-
-static std::string GenerateBotGameStateSnapshot(Player* bot)
-{
-    // Prepare each section
-    std::string combat = ChatHandler_GetCombatSummary(bot);
-
-    std::string group;
-    std::vector<std::string> groupInfo = ChatHandler_GetGroupStatus(bot);
-    if (!groupInfo.empty()) {
-        group += "Group members:\n";
-        for (const auto& entry : groupInfo) group += " - " + entry + "\n";
-    }
-
-    std::string spells = ChatHandler_GetBotSpellInfo(bot);
-
-    std::string quests;
-    for (auto const& [questId, qsd] : bot->getQuestStatusMap())
-    {
-        // look up the template
-        Quest const* quest = sObjectMgr->GetQuestTemplate(questId);
-        if (!quest)
-            continue;
-
-        // get the English title as a fallback
-        std::string title = quest->GetTitle();
-
-        // then, if we have a locale record, overwrite it
-        if (auto const* locale = sObjectMgr->GetQuestLocale(questId))
-        {
-            int locIdx = bot->GetSession()->GetSessionDbLocaleIndex();
-            if (locIdx >= 0)
-                ObjectMgr::GetLocaleString(locale->Title, locIdx, title);
-        }
-
-        // Convert quest status to readable string
-        std::string statusText;
-        switch (qsd.Status)
-        {
-            case QUEST_STATUS_NONE:       statusText = "not started"; break;
-            case QUEST_STATUS_COMPLETE:   statusText = "complete (ready to turn in)"; break;
-            case QUEST_STATUS_INCOMPLETE: statusText = "in progress"; break;
-            case QUEST_STATUS_FAILED:     statusText = "failed"; break;
-            case QUEST_STATUS_REWARDED:   statusText = "completed and rewarded"; break;
-            default:                      statusText = "unknown"; break;
-        }
-
-        quests += "Quest \"" + title + "\" is " + statusText + "\n";
-    }
-
-    std::string los;
-    std::vector<std::string> losLocs = ChatHandler_GetVisibleLocations(bot);
-    if (!losLocs.empty()) {
-        for (const auto& entry : losLocs) los += " - " + entry + "\n";
-    }
-
-    std::string players;
-    std::vector<std::string> nearbyPlayers = ChatHandler_GetVisiblePlayers(bot);
-    if (!nearbyPlayers.empty()) {
-        for (const auto& entry : nearbyPlayers) players += " - " + entry + "\n";
-    }
-
-    // Use template
-    return SafeFormat(
-        g_ChatBotSnapshotTemplate,
-        fmt::arg("combat", combat),
-        fmt::arg("group", group),
-        fmt::arg("spells", spells),
-        fmt::arg("quests", quests),
-        fmt::arg("los", los),
-        fmt::arg("players", players)
-    );
-}
-
-
 void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32_t lang, std::string& msg, ChatChannelSourceLocal sourceLocal, Channel* channel, Player* receiver)
 {
     if (player == nullptr) {
@@ -692,24 +263,15 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
     }
 
 
-    auto startsWithWord = [](const std::string& text, const std::string& word) {
-        if (text.size() < word.size()) return false;
-        if (text.compare(0, word.size(), word) != 0) return false;
-        // If exact length match or next char is whitespace/punctuation, it's a word
-        return text.size() == word.size() || !std::isalnum((unsigned char)text[word.size()]);
-    };
-
     std::string trimmedMsg = rtrim(msg);
-    for (const std::string& blacklist : g_BlacklistCommands)
+    std::string blacklistedPrefix;
+    if (IsBlacklistedCommand(trimmedMsg, &blacklistedPrefix))
     {
-        if (startsWithWord(trimmedMsg, blacklist))
-        {
-            if (g_DebugEnabled)
-                LOG_INFO("server.loading",
-                         "[Ollama Chat] Message starts with '{}' (blacklisted). Skipping bot responses.",
-                         blacklist);
-            return;
-        }
+        if (g_DebugEnabled)
+            LOG_INFO("server.loading",
+                     "[Ollama Chat] Message starts with '{}' (blacklisted). Skipping bot responses.",
+                     blacklistedPrefix);
+        return;
     }
              
     PlayerbotAI* senderAI = sPlayerbotsMgr->GetPlayerbotAI(player);
@@ -1036,13 +598,19 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
         if (bot == nullptr) {
             continue;
         }
-        std::string prompt = GenerateBotPrompt(bot, msg, player);
+        // Check the request budget before paying for prompt construction
+        if (!TryAdmitLLMRequest(LLM_SOURCE_CHAT))
+        {
+            continue;
+        }
+        ChatPromptDraft draft = GenerateBotPrompt(bot, msg, player);
         uint64_t botGuid = bot->GetGUID().GetRawValue();
         
-        std::thread([botGuid, senderGuid, prompt, sourceLocal, channelId = (channel ? channel->GetChannelId() : 0), channelName = (channel ? channel->GetName() : ""), msg]() {
+        std::thread([botGuid, senderGuid, draft = std::move(draft), sourceLocal, channelId = (channel ? channel->GetChannelId() : 0), channelName = (channel ? channel->GetName() : ""), msg]() {
             try {
                 // Use the QueryManager to submit the query.
-                auto responseFuture = SubmitQuery(prompt);
+                // History is read here rather than on the world thread; it may have to be loaded first
+                auto responseFuture = SubmitQuery(FinishBotPrompt(draft));
                 if (!responseFuture.valid())
                 {
                     return;
@@ -1328,132 +896,205 @@ static bool IsBotEligibleForChatChannelLocal(Player* bot, Player* player, ChatCh
     }
 }
 
-std::string GenerateBotPrompt(Player* bot, std::string playerMessage, Player* player)
+ChatPromptDraft GenerateBotPrompt(Player* bot, std::string playerMessage, Player* player)
 {  
     if (!bot || !player) {
-        return "";
+        return {};
     }
     PlayerbotAI* botAI = sPlayerbotsMgr->GetPlayerbotAI(bot);
     if (botAI == nullptr) {
-        return "";
+        return {};
     }
     ChatHelper* helper = botAI->GetChatHelper();
     if (helper == nullptr) {
-        return "";
+        return {};
     }
-    if (g_ChatPromptTemplate.empty()) {
+    std::shared_ptr<const PromptTemplates> templates = GetPromptTemplates();
+    if (templates->chat.Empty()) {
         LOG_ERROR("server.loading", "[Ollama Chat] GenerateBotPrompt: template is empty");
-        return "";
+        return {};
     }
 
-    AreaTableEntry const* botCurrentArea = botAI->GetCurrentArea();
-    AreaTableEntry const* botCurrentZone = botAI->GetCurrentZone();
-
     uint64_t botGuid                = bot->GetGUID().GetRawValue();
     uint64_t playerGuid             = player->GetGUID().GetRawValue();
 
     std::string personality         = GetBotPersonality(bot);
-    std::string personalityPrompt   = GetPersonalityPromptAddition(personality);
     std::string botName             = bot->GetName();
-    uint32_t botLevel               = bot->GetLevel();
-    uint8_t botGenderByte           = bot->getGender();
-    std::string botAreaName         = botCurrentArea ? botAI->GetLocalizedAreaName(botCurrentArea): "UnknownArea";
-    std::string botZoneName         = botCurrentZone ? botAI->GetLocalizedAreaName(botCurrentZone): "UnknownZone";
-    std::string botMapName          = bot->GetMap() ? bot->GetMap()->GetMapName() : "UnknownMap";
-    std::string botClass            = botAI->GetChatHelper()->FormatClass(bot->getClass());
-    std::string botRace             = botAI->GetChatHelper()->FormatRace(bot->getRace());
-    std::string botRole             = ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot));
-    std::string botGender           = (botGenderByte == 0 ? "Male" : "Female");
-    std::string botFaction          = (bot->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
-    std::string botGuild            = (bot->GetGuild() ? bot->GetGuild()->GetName() : "No Guild");
-    std::string botGroupStatus      = (bot->GetGroup() ? "In a group" : "Solo");
-    uint32_t botGold                = bot->GetMoney() / 10000;
-
     std::string playerName          = player->GetName();
-    uint32_t playerLevel            = player->GetLevel();
-    std::string playerClass         = botAI->GetChatHelper()->FormatClass(player->getClass());
-    std::string playerRace          = botAI->GetChatHelper()->FormatRace(player->getRace());
-    std::string playerRole          = ChatHelper::FormatClass(player, AiFactory::GetPlayerSpecTab(player));
-    uint8_t playerGenderByte        = player->getGender();
-    std::string playerGender        = (playerGenderByte == 0 ? "Male" : "Female");
-    std::string playerFaction       = (player->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
-    std::string playerGuild         = (player->GetGuild() ? player->GetGuild()->GetName() : "No Guild");
-    std::string playerGroupStatus   = (player->GetGroup() ? "In a group" : "Solo");
-    uint32_t playerGold             = player->GetMoney() / 10000;
-    float playerDistance            = player->IsInWorld() && bot->IsInWorld() ? player->GetDistance(bot) : -1.0f;
 
-    std::string chatHistory         = GetBotHistoryPrompt(botGuid, playerGuid, playerMessage);
-    std::string sentimentInfo       = GetSentimentPromptAddition(bot, player);
+    // Only values referenced by the chat and persona templates (or by the extra info template,
+    // if the chat template includes it) are computed; the rest render as empty and are never looked up.
+    bool usesExtraInfo = templates->chat.Uses(PROMPT_VAR_EXTRA_INFO);
+    auto uses = [&templates, usesExtraInfo](PromptVar var)
+    {
+        return templates->chat.Uses(var) || templates->chatPersona.Uses(var) ||
+               (usesExtraInfo && templates->chatExtraInfo.Uses(var));
+    };
 
-    // Retrieve RAG information if enabled
+    PromptVars vars;
+    vars.Set(PROMPT_VAR_BOT_NAME, botName);
+    vars.Set(PROMPT_VAR_BOT_LEVEL, bot->GetLevel());
+    vars.Set(PROMPT_VAR_BOT_CLASS, helper->FormatClass(bot->getClass()));
+    vars.Set(PROMPT_VAR_BOT_RACE, helper->FormatRace(bot->getRace()));
+    vars.Set(PROMPT_VAR_BOT_GENDER, bot->getGender() == 0 ? "Male" : "Female");
+    vars.Set(PROMPT_VAR_BOT_FACTION, bot->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
+    vars.Set(PROMPT_VAR_BOT_GROUP_STATUS, bot->GetGroup() ? "In a group" : "Solo");
+    vars.Set(PROMPT_VAR_BOT_PERSONALITY_NAME, personality);
+    vars.Set(PROMPT_VAR_PLAYER_NAME, playerName);
+    vars.Set(PROMPT_VAR_PLAYER_LEVEL, player->GetLevel());
+    vars.Set(PROMPT_VAR_PLAYER_CLASS, helper->FormatClass(player->getClass()));
+    vars.Set(PROMPT_VAR_PLAYER_RACE, helper->FormatRace(player->getRace()));
+    vars.Set(PROMPT_VAR_PLAYER_GENDER, player->getGender() == 0 ? "Male" : "Female");
+    vars.Set(PROMPT_VAR_PLAYER_FACTION, player->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
+    vars.Set(PROMPT_VAR_PLAYER_GROUP_STATUS, player->GetGroup() ? "In a group" : "Solo");
+    vars.Set(PROMPT_VAR_PLAYER_MESSAGE, playerMessage);
+
+    if (uses(PROMPT_VAR_BOT_PERSONALITY))
+        vars.Set(PROMPT_VAR_BOT_PERSONALITY, GetPersonalityPromptAddition(personality));
+    if (uses(PROMPT_VAR_BOT_ROLE))
+        vars.Set(PROMPT_VAR_BOT_ROLE, ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot)));
+    if (uses(PROMPT_VAR_PLAYER_ROLE))
+        vars.Set(PROMPT_VAR_PLAYER_ROLE, ChatHelper::FormatClass(player, AiFactory::GetPlayerSpecTab(player)));
+    if (uses(PROMPT_VAR_BOT_GUILD))
+        vars.Set(PROMPT_VAR_BOT_GUILD, bot->GetGuild() ? bot->GetGuild()->GetName() : "No Guild");
+    if (uses(PROMPT_VAR_PLAYER_GUILD))
+        vars.Set(PROMPT_VAR_PLAYER_GUILD, player->GetGuild() ? player->GetGuild()->GetName() : "No Guild");
+    if (uses(PROMPT_VAR_BOT_GOLD))
+        vars.Set(PROMPT_VAR_BOT_GOLD, bot->GetMoney() / 10000);
+    if (uses(PROMPT_VAR_PLAYER_GOLD))
+        vars.Set(PROMPT_VAR_PLAYER_GOLD, player->GetMoney() / 10000);
+    if (uses(PROMPT_VAR_PLAYER_DISTANCE))
+        vars.Set(PROMPT_VAR_PLAYER_DISTANCE, player->IsInWorld() && bot->IsInWorld() ? player->GetDistance(bot) : -1.0f);
+    if (uses(PROMPT_VAR_BOT_AREA))
+    {
+        AreaTableEntry const* botCurrentArea = botAI->GetCurrentArea();
+        vars.Set(PROMPT_VAR_BOT_AREA, botCurrentArea ? botAI->GetLocalizedAreaName(botCurrentArea) : "UnknownArea");
+    }
+    if (uses(PROMPT_VAR_BOT_ZONE))
+    {
+        AreaTableEntry const* botCurrentZone = botAI->GetCurrentZone();
+        vars.Set(PROMPT_VAR_BOT_ZONE, botCurrentZone ? botAI->GetLocalizedAreaName(botCurrentZone) : "UnknownZone");
+    }
+    if (uses(PROMPT_VAR_BOT_MAP))
+        vars.Set(PROMPT_VAR_BOT_MAP, bot->GetMap() ? bot->GetMap()->GetMapName() : "UnknownMap");
+
+    // With the chat and context backends the model already has the earlier turns, so the
+    // history text is only rendered when there is nothing to continue from. Either way the
+    // history itself is read in FinishBotPrompt, off the world thread.
+    ChatPromptDraft draft;
+    OllamaRequest& request = draft.request;
+    request.botGuid = botGuid;
+    request.playerGuid = playerGuid;
+    if (g_OllamaApiBackend == OLLAMA_BACKEND_CHAT)
+        draft.sendHistoryTurns = true;
+    else if (g_OllamaApiBackend == OLLAMA_BACKEND_CONTEXT)
+        request.context = GetConversationContext(botGuid, playerGuid);
+
+    draft.renderHistory = uses(PROMPT_VAR_CHAT_HISTORY) && g_OllamaApiBackend != OLLAMA_BACKEND_CHAT && !request.context;
+    draft.playerName = playerName;
+    draft.playerMessage = playerMessage;
+    // Like the history, the sentiment may have to be read from the database first
+    draft.renderSentiment = uses(PROMPT_VAR_SENTIMENT_INFO);
+
+    // Retrieve RAG information if enabled. It goes where the template puts {rag_info};
+    // templates without it get it appended after the prompt unless RAGAppendToPrompt is off.
+    bool ragInline = templates->chat.Uses(PROMPT_VAR_RAG_INFO);
+    bool ragAppended = !ragInline && g_RAGAppendToPrompt &&
+        std::find(g_ChatPromptSectionOrder.begin(), g_ChatPromptSectionOrder.end(), CHAT_PROMPT_SECTION_RAG) != g_ChatPromptSectionOrder.end();
     std::string ragInfo;
-    if (g_EnableRAG && g_RAGSystem) {
+    if (g_EnableRAG && g_RAGSystem && (ragInline || ragAppended)) {
         auto ragResults = g_RAGSystem->RetrieveRelevantInfo(playerMessage, g_RAGMaxRetrievedItems, g_RAGSimilarityThreshold);
         std::string ragContent = g_RAGSystem->GetFormattedRAGInfo(ragResults);
         if (!ragContent.empty()) {
-            ragInfo = SafeFormat(g_RAGPromptTemplate, fmt::arg("rag_info", ragContent));
+            PromptVars ragVars;
+            ragVars.Set(PROMPT_VAR_RAG_INFO, ragContent);
+            ragInfo = templates->ragPrompt.Render(ragVars);
         }
         if (g_DebugEnabled) {
             LOG_INFO("server.loading", "[Ollama Chat] RAG Debug - Enabled: {}, System: {}, Message: '{}', Results: {}, Content length: {}",
                 g_EnableRAG, (void*)g_RAGSystem, playerMessage, ragResults.size(), ragContent.length());
         }
     } else if (g_DebugEnabled) {
-        LOG_INFO("server.loading", "[Ollama Chat] RAG Debug - Not enabled or no system - Enabled: {}, System: {}",
+        LOG_INFO("server.loading", "[Ollama Chat] RAG Debug - Not enabled, no system or not used by the template - Enabled: {}, System: {}",
             g_EnableRAG, (void*)g_RAGSystem);
     }
 
-    std::string extraInfo = SafeFormat(
-        g_ChatExtraInfoTemplate,
-        fmt::arg("bot_race", botRace),
-        fmt::arg("bot_gender", botGender),
-        fmt::arg("bot_role", botRole),
-        fmt::arg("bot_faction", botFaction),
-        fmt::arg("bot_guild", botGuild),
-        fmt::arg("bot_group_status", botGroupStatus),
-        fmt::arg("bot_gold", botGold),
-        fmt::arg("player_race", playerRace),
-        fmt::arg("player_gender", playerGender),
-        fmt::arg("player_role", playerRole),
-        fmt::arg("player_faction", playerFaction),
-        fmt::arg("player_guild", playerGuild),
-        fmt::arg("player_group_status", playerGroupStatus),
-        fmt::arg("player_gold", playerGold),
-        fmt::arg("player_distance", playerDistance),
-        fmt::arg("bot_area", botAreaName),
-        fmt::arg("bot_zone", botZoneName),
-        fmt::arg("bot_map", botMapName)
-    );
-    
-    std::string prompt = SafeFormat(
-        g_ChatPromptTemplate,
-        fmt::arg("bot_name", botName),
-        fmt::arg("bot_level", botLevel),
-        fmt::arg("bot_class", botClass),
-        fmt::arg("bot_personality", personalityPrompt),
-        fmt::arg("bot_personality_name", personality),
-        fmt::arg("player_level", playerLevel),
-        fmt::arg("player_class", playerClass),
-        fmt::arg("player_name", playerName),
-        fmt::arg("player_message", playerMessage),
-        fmt::arg("extra_info", extraInfo),
-        fmt::arg("chat_history", chatHistory),
-        fmt::arg("sentiment_info", sentimentInfo)
-    );
+    if (usesExtraInfo)
+        vars.Set(PROMPT_VAR_EXTRA_INFO, templates->chatExtraInfo.Render(vars));
+    if (ragInline)
+        vars.Set(PROMPT_VAR_RAG_INFO, ragInfo);
+
+    // The persona only depends on the bot, so it is kept out of the volatile part of the
+    // prompt: either in the system field or at the front, per the configured section order.
+    std::string persona;
+    if (!templates->chatPersona.Empty())
+        persona = templates->chatPersona.Render(vars);
+    if (g_ChatPersonaInSystem)
+        request.system = persona;
+    else
+        draft.persona = persona;
+
+    // Legacy placement: add RAG information after the prompt
+    if (ragAppended)
+        draft.ragInfo = ragInfo;
 
-    // Add RAG information to the prompt if available
-    if (!ragInfo.empty()) {
-        prompt += ragInfo + "\n";
+    if (g_EnableChatBotSnapshotTemplate &&
+        std::find(g_ChatPromptSectionOrder.begin(), g_ChatPromptSectionOrder.end(), CHAT_PROMPT_SECTION_SNAPSHOT) != g_ChatPromptSectionOrder.end())
+    {
+        draft.snapshot = GenerateBotGameStateSnapshot(bot);
     }
 
-    if(g_EnableChatBotSnapshotTemplate)
+    draft.vars = std::move(vars);
+    // The prompt is rendered later on a reply thread, from the same set the values were chosen for
+    draft.templates = std::move(templates);
+    return draft;
+}
+
+OllamaRequest FinishBotPrompt(ChatPromptDraft draft)
+{
+    // GenerateBotPrompt bailed out before filling the draft
+    if (!draft.request.botGuid)
+        return {};
+
+    OllamaRequest request = std::move(draft.request);
+
+    if (draft.sendHistoryTurns)
+        request.history = GetBotHistoryTurns(request.botGuid, request.playerGuid);
+    if (draft.renderHistory)
+        draft.vars.Set(PROMPT_VAR_CHAT_HISTORY, GetBotHistoryPrompt(request.botGuid, request.playerGuid, draft.playerName, draft.playerMessage));
+    if (draft.renderSentiment)
+        draft.vars.Set(PROMPT_VAR_SENTIMENT_INFO, GetSentimentPromptAddition(request.botGuid, request.playerGuid, draft.playerName));
+
+    for (ChatPromptSection section : g_ChatPromptSectionOrder)
     {
-        prompt += GenerateBotGameStateSnapshot(bot);
+        switch (section)
+        {
+            case CHAT_PROMPT_SECTION_PERSONA:
+                if (!draft.persona.empty())
+                    request.prompt += draft.persona + "\n";
+                break;
+            case CHAT_PROMPT_SECTION_PROMPT:
+                draft.templates->chat.RenderTo(request.prompt, draft.vars);
+                break;
+            case CHAT_PROMPT_SECTION_RAG:
+                if (!draft.ragInfo.empty())
+                    request.prompt += draft.ragInfo + "\n";
+                break;
+            case CHAT_PROMPT_SECTION_SNAPSHOT:
+                request.prompt += draft.snapshot;
+                break;
+            default:
+                break;
+        }
     }
 
     // Debug logging for full prompt including RAG information
     if (g_DebugEnabled && g_DebugShowFullPrompt) {
-        LOG_INFO("server.loading", "[Ollama Chat] Full prompt sent to bot {} for player {}: {}", botName, playerName, prompt);
+        const std::string& botName = draft.vars.Get(PROMPT_VAR_BOT_NAME);
+        if (!request.system.empty())
+            LOG_INFO("server.loading", "[Ollama Chat] System prompt sent to bot {}: {}", botName, request.system);
+        LOG_INFO("server.loading", "[Ollama Chat] Full prompt sent to bot {} for player {}: {}", botName, draft.playerName, request.prompt);
     }
 
-    return prompt;
+    return request;
 }
@@ -0,0 +1,344 @@
+#include "mod-ollama-chat_history.h"
+#include "mod-ollama-chat_config.h"
+#include "mod-ollama-chat_context.h"
+#include "mod-ollama-chat_dbsave.h"
+#include "mod-ollama-chat_journal.h"
+#include "mod-ollama-chat_lockstats.h"
+#include "mod-ollama-chat_relationship.h"
+#include "mod-ollama-chat-utilities.h"
+#include "DatabaseEnv.h"
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iterator>
+#include <map>
+#include <thread>
+
+using ConversationKey = std::pair<uint64_t, uint64_t>;
+
+// The turns and the save queue both live in the relationship table, per shard
+static std::atomic<bool> historySaveRunning{false};
+
+void AppendBotConversation(uint64_t botGuid, uint64_t playerGuid, const std::string& playerMessage, const std::string& botReply)
+{
+    // Built before taking the lock so the copies are not made while holding it
+    PendingHistoryRow row{ botGuid, playerGuid, time(nullptr), playerMessage, botReply };
+
+    RelationshipShard& shard = GetRelationshipShard(botGuid);
+    TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+    RelationshipState& state = TouchRelationship(shard, botGuid, playerGuid);
+    ++state.unsavedTurns;
+
+    // Once the ring is full this reuses the oldest turn's slot and text chunks
+    AcquireRelationshipHistory(shard, state).Push(shard.historyText,
+        TruncateHistoryText(playerMessage, g_ChatHistoryMaxMessageLength),
+        TruncateHistoryText(botReply, g_ChatHistoryMaxReplyLength));
+    // Journaled under the lock, so a drain that takes this row also sees its record
+    JournalHistoryTurn(row);
+    shard.pendingHistoryRows.push_back(std::move(row));
+    TrimRelationshipShard(shard);
+}
+
+// Reads the stored turns of a pair if they are not in memory yet. Blocks on the database,
+// so it is only called from reply threads.
+static void EnsureBotHistoryLoaded(uint64_t botGuid, uint64_t playerGuid)
+{
+    RelationshipShard& shard = GetRelationshipShard(botGuid);
+    {
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+        const RelationshipState* state = shard.pairs.Find(botGuid, playerGuid);
+        if (state && (state->flags & RELATIONSHIP_HISTORY_LOADED))
+            return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    QueryResult result = CharacterDatabase.Query(SafeFormat(
+        "SELECT player_message, bot_reply FROM mod_ollama_chat_history WHERE bot_guid = {} AND player_guid = {} "
+        "ORDER BY id DESC LIMIT {}",
+        botGuid, playerGuid, g_MaxConversationHistory));
+
+    // Newest first, as read; cut to the same lengths as appended turns so they compare equal
+    std::vector<std::pair<std::string, std::string>> stored;
+    if (result)
+    {
+        do {
+            stored.emplace_back(
+                TruncateHistoryText((*result)[0].Get<std::string>(), g_ChatHistoryMaxMessageLength),
+                TruncateHistoryText((*result)[1].Get<std::string>(), g_ChatHistoryMaxReplyLength));
+        } while (result->NextRow());
+    }
+
+    TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+    RelationshipState& state = TouchRelationship(shard, botGuid, playerGuid);
+    if (state.flags & RELATIONSHIP_HISTORY_LOADED)
+        return;   // Another reply thread got there first
+
+    // Turns appended while the pair was not loaded come after the stored ones. A turn can be
+    // in both if its save committed in the meantime; the table's unique key means equal
+    // turns are the same row, so those are skipped.
+    HistoryRing& ring = AcquireRelationshipHistory(shard, state);
+    std::vector<std::pair<std::string, std::string>> merged;
+    for (auto it = stored.rbegin(); it != stored.rend(); ++it)
+    {
+        bool appended = false;
+        for (uint32_t i = 0; i < ring.Size() && !appended; ++i)
+            appended = ring.PlayerMessage(i) == it->first && ring.BotReply(i) == it->second;
+        if (!appended)
+            merged.push_back(std::move(*it));
+    }
+    for (uint32_t i = 0; i < ring.Size(); ++i)
+        merged.emplace_back(ring.PlayerMessage(i), ring.BotReply(i));
+
+    // Refilled oldest first; a full ring keeps the newest turns
+    ring.Clear(shard.historyText);
+    for (const auto& turn : merged)
+        ring.Push(shard.historyText, turn.first, turn.second);
+
+    state.flags |= RELATIONSHIP_HISTORY_LOADED;
+    TrimRelationshipShard(shard);
+
+    if (g_DebugEnabled)
+    {
+        uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("server.loading", "[Ollama Chat] Loaded {} history turns for bot {} and player {} in {} us ({} pairs in shard).",
+                 stored.size(), botGuid, playerGuid, micros, shard.historyPairs);
+    }
+}
+
+// Deletes all but the newest g_MaxConversationHistory rows of one pair. Rows are ordered
+// by id, which follows insertion order even when several turns share a timestamp.
+static std::string GetTrimHistorySql(uint64_t botGuid, uint64_t playerGuid)
+{
+    if (g_MaxConversationHistory == 0)
+    {
+        return SafeFormat(
+            "DELETE FROM mod_ollama_chat_history WHERE bot_guid = {} AND player_guid = {}",
+            botGuid, playerGuid);
+    }
+
+    // The derived table lets MySQL read the table it is deleting from; if the pair has
+    // fewer rows than the limit the subquery is NULL and nothing is deleted.
+    return SafeFormat(
+        "DELETE FROM mod_ollama_chat_history WHERE bot_guid = {} AND player_guid = {} AND id < ("
+        "SELECT id FROM (SELECT id FROM mod_ollama_chat_history WHERE bot_guid = {} AND player_guid = {} "
+        "ORDER BY id DESC LIMIT 1 OFFSET {}) AS newest)",
+        botGuid, playerGuid, botGuid, playerGuid, g_MaxConversationHistory - 1);
+}
+
+void QueueBotConversationHistoryRows(std::vector<PendingHistoryRow> rows)
+{
+    std::map<RelationshipShard*, std::vector<PendingHistoryRow>> shardRows;
+    for (PendingHistoryRow& row : rows)
+        shardRows[&GetRelationshipShard(row.botGuid)].push_back(std::move(row));
+
+    for (auto& [shard, queued] : shardRows)
+    {
+        TimedLockGuard lock(shard->mutex, TRACKED_LOCK_RELATIONSHIP);
+        shard->pendingHistoryRows.insert(shard->pendingHistoryRows.begin(),
+            std::make_move_iterator(queued.begin()), std::make_move_iterator(queued.end()));
+    }
+}
+
+// Returns false if the commit failed; the pairs then keep their unsaved turns
+static bool WriteBotConversationHistory(const std::vector<PendingHistoryRow>& rows)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::map<ConversationKey, uint32_t> dirtyPairs;
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    BatchedStatementWriter inserts(trans,
+        "INSERT IGNORE INTO mod_ollama_chat_history (bot_guid, player_guid, timestamp, player_message, bot_reply) VALUES ");
+
+    for (const PendingHistoryRow& row : rows)
+    {
+        std::string escPlayerMsg = row.playerMessage;
+        CharacterDatabase.EscapeString(escPlayerMsg);
+
+        std::string escBotReply = row.botReply;
+        CharacterDatabase.EscapeString(escBotReply);
+
+        inserts.AddRow(SafeFormat("({}, {}, FROM_UNIXTIME({}), '{}', '{}')",
+            row.botGuid, row.playerGuid, row.timestamp, escPlayerMsg, escBotReply));
+
+        ++dirtyPairs[{ row.botGuid, row.playerGuid }];
+    }
+    inserts.Flush();
+
+    // Only pairs that received rows can have grown past the limit
+    for (const auto& [key, count] : dirtyPairs)
+        trans->Append(GetTrimHistorySql(key.first, key.second));
+
+    // Waited for on this thread, so once it returns a lazy load of these pairs is
+    // guaranteed to see the rows and they can be evicted again
+    if (!CommitTransactionAndWait(trans))
+    {
+        LOG_ERROR("server.loading", "[Ollama Chat] Saving {} conversation history rows failed; they are kept for the next save.", rows.size());
+        return false;
+    }
+
+    for (const auto& [key, count] : dirtyPairs)
+    {
+        RelationshipShard& shard = GetRelationshipShard(key.first);
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        if (RelationshipState* state = shard.pairs.Find(key.first, key.second))
+            state->unsavedTurns -= std::min(state->unsavedTurns, count);
+    }
+
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    RecordDatabaseSave(DB_SAVE_HISTORY, inserts.Rows(), inserts.Statements() + uint32_t(dirtyPairs.size()), micros);
+    return true;
+}
+
+// Each shard's queue is swapped out under its own lock; rows of one pair stay in order
+static std::vector<PendingHistoryRow> TakePendingHistoryRows()
+{
+    std::vector<PendingHistoryRow> rows;
+    for (size_t i = 0; i < RELATIONSHIP_SHARD_COUNT; ++i)
+    {
+        RelationshipShard& shard = GetRelationshipShardByIndex(i);
+        std::vector<PendingHistoryRow> shardRows;
+        {
+            TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+            shardRows.swap(shard.pendingHistoryRows);
+        }
+        if (rows.empty())
+            rows.swap(shardRows);
+        else
+            rows.insert(rows.end(), std::make_move_iterator(shardRows.begin()), std::make_move_iterator(shardRows.end()));
+    }
+    return rows;
+}
+
+void SaveBotConversationHistoryToDB()
+{
+    if (historySaveRunning.exchange(true))
+    {
+        if (g_DebugEnabled)
+            LOG_INFO("server.loading", "[Ollama Chat] Previous conversation history save still running, skipping.");
+        return;
+    }
+
+    std::vector<PendingHistoryRow> rows = TakePendingHistoryRows();
+    if (rows.empty())
+    {
+        historySaveRunning = false;
+        return;
+    }
+
+    std::thread([rows = std::move(rows)]() mutable {
+        if (!WriteBotConversationHistory(rows))
+            QueueBotConversationHistoryRows(std::move(rows));
+        historySaveRunning = false;
+    }).detach();
+}
+
+bool FlushBotConversationHistoryToDB()
+{
+    if (historySaveRunning.exchange(true))
+        return false;
+
+    bool committed = true;
+    std::vector<PendingHistoryRow> rows = TakePendingHistoryRows();
+    if (!rows.empty() && !WriteBotConversationHistory(rows))
+    {
+        QueueBotConversationHistoryRows(std::move(rows));
+        committed = false;
+    }
+    historySaveRunning = false;
+    return committed;
+}
+
+void UnloadBotConversationHistory()
+{
+    // Stored contexts describe the conversations being dropped
+    ClearConversationContexts();
+
+    for (size_t i = 0; i < RELATIONSHIP_SHARD_COUNT; ++i)
+    {
+        RelationshipShard& shard = GetRelationshipShardByIndex(i);
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        shard.pairs.EraseIf([&shard](uint64_t, uint64_t, RelationshipState& state) {
+            // Pairs with unsaved turns stay until their save has gone through
+            if (!state.unsavedTurns)
+                ReleaseRelationshipHistory(shard, state);
+            return !state.HasHistory() && !state.HasSentiment();
+        });
+    }
+}
+
+size_t GetResidentHistoryPairCount()
+{
+    size_t count = 0;
+    for (size_t i = 0; i < RELATIONSHIP_SHARD_COUNT; ++i)
+    {
+        RelationshipShard& shard = GetRelationshipShardByIndex(i);
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+        count += shard.historyPairs;
+    }
+    return count;
+}
+
+std::vector<std::pair<std::string, std::string>> GetBotHistoryTurns(uint64_t botGuid, uint64_t playerGuid)
+{
+    if(!g_EnableChatHistory)
+    {
+        return {};
+    }
+
+    EnsureBotHistoryLoaded(botGuid, playerGuid);
+
+    RelationshipShard& shard = GetRelationshipShard(botGuid);
+    TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+
+    RelationshipState* state = shard.pairs.Find(botGuid, playerGuid);
+    if (!state || !state->HasHistory())
+        return {};
+
+    MarkRelationshipUsed(shard, *state);
+    const HistoryRing& ring = shard.historyRings[state->historyHandle];
+    std::vector<std::pair<std::string, std::string>> turns;
+    turns.reserve(ring.Size());
+    for (uint32_t i = 0; i < ring.Size(); ++i)
+        turns.emplace_back(ring.PlayerMessage(i), ring.BotReply(i));
+    return turns;
+}
+
+std::string GetBotHistoryPrompt(uint64_t botGuid, uint64_t playerGuid, const std::string& playerName, const std::string& playerMessage)
+{
+    if (!g_EnableChatHistory)
+        return "";
+
+    EnsureBotHistoryLoaded(botGuid, playerGuid);
+
+    std::shared_ptr<const PromptTemplates> templates = GetPromptTemplates();
+    std::string result;
+    PromptVars vars;
+    vars.Set(PROMPT_VAR_PLAYER_NAME, playerName);
+
+    {
+        // Lines are rendered straight from the ring's text under the shard lock; the
+        // variable strings keep their capacity, so no per-turn copies are made
+        RelationshipShard& shard = GetRelationshipShard(botGuid);
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+
+        RelationshipState* state = shard.pairs.Find(botGuid, playerGuid);
+        if (!state || !state->HasHistory() || !shard.historyRings[state->historyHandle].Size())
+            return "";
+
+        MarkRelationshipUsed(shard, *state);
+        const HistoryRing& ring = shard.historyRings[state->historyHandle];
+        templates->chatHistoryHeader.RenderTo(result, vars);
+        for (uint32_t i = 0; i < ring.Size(); ++i) {
+            vars.Set(PROMPT_VAR_PLAYER_MESSAGE, ring.PlayerMessage(i));
+            vars.Set(PROMPT_VAR_BOT_REPLY, ring.BotReply(i));
+            templates->chatHistoryLine.RenderTo(result, vars);
+        }
+    }
+
+    vars.Set(PROMPT_VAR_PLAYER_MESSAGE, playerMessage);
+    templates->chatHistoryFooter.RenderTo(result, vars);
+
+    return result;
+}
@@ -0,0 +1,63 @@
+#ifndef MOD_OLLAMA_CHAT_HISTORY_H
+#define MOD_OLLAMA_CHAT_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct PendingHistoryRow;
+
+/**
+ * Record a finished conversation turn in memory and queue it for the next save.
+ * Keeps at most OllamaChat.MaxConversationHistory turns per bot/player pair.
+ */
+void AppendBotConversation(uint64_t botGuid, uint64_t playerGuid, const std::string& playerMessage, const std::string& botReply);
+
+/**
+ * Write the turns appended since the last save and trim the pairs they belong to.
+ * The queued turns are taken under the history lock and written from a worker thread,
+ * so the world thread never formats or issues the queries. A call made while the
+ * previous save is still running does nothing; its turns go out with the next one.
+ */
+void SaveBotConversationHistoryToDB();
+
+/**
+ * Like SaveBotConversationHistoryToDB, but writes on the calling thread and returns once
+ * the commit has finished. Used by the persistence thread.
+ * @return false if another save was still running or the commit failed, so some rows may
+ *         not be stored yet. Rows of a failed commit are queued again.
+ */
+bool FlushBotConversationHistoryToDB();
+
+/**
+ * Queue rows for the next save, ahead of the rows appended since. Used to retry a failed
+ * save and to replay the journal; rows already stored are skipped by the insert.
+ */
+void QueueBotConversationHistoryRows(std::vector<PendingHistoryRow> rows);
+
+/**
+ * Drop the history held in memory; pairs are read back from mod_ollama_chat_history the
+ * next time they are needed. Pairs with unsaved turns are kept.
+ */
+void UnloadBotConversationHistory();
+
+// Number of bot/player pairs currently held in memory
+size_t GetResidentHistoryPairCount();
+
+/**
+ * Render the history of a bot/player pair with the ChatHistory*Template settings.
+ * The first use of a pair reads its stored turns, blocking on the database, so this
+ * must not be called from the world thread.
+ * @return Empty if chat history is disabled or the pair has none
+ */
+std::string GetBotHistoryPrompt(uint64_t botGuid, uint64_t playerGuid, const std::string& playerName, const std::string& playerMessage);
+
+/**
+ * Earlier (player message, bot reply) turns of a bot/player pair, oldest first.
+ * Like GetBotHistoryPrompt, may read the pair from the database on first use.
+ */
+std::vector<std::pair<std::string, std::string>> GetBotHistoryTurns(uint64_t botGuid, uint64_t playerGuid);
+
+#endif // MOD_OLLAMA_CHAT_HISTORY_H
@@ -0,0 +1,119 @@
+#include "mod-ollama-chat_historystore.h"
+#include <cstring>
+
+static int GetSizeClass(uint32_t length)
+{
+    int sizeClass = 0;
+    while ((HistoryTextArena::MIN_CHUNK << sizeClass) < length)
+        ++sizeClass;
+    return sizeClass;
+}
+
+char* HistoryTextArena::Allocate(int sizeClass)
+{
+    std::vector<char*>& freeList = m_free[sizeClass];
+    if (!freeList.empty())
+    {
+        char* chunk = freeList.back();
+        freeList.pop_back();
+        return chunk;
+    }
+
+    // Chunk sizes divide the slab size, so the tail of a slab is only lost when a
+    // large chunk follows small ones
+    size_t chunkBytes = size_t(MIN_CHUNK) << sizeClass;
+    if (m_slabUsed + chunkBytes > SLAB_BYTES)
+    {
+        m_slabs.emplace_back(new char[SLAB_BYTES]);
+        m_slabUsed = 0;
+    }
+    char* chunk = m_slabs.back().get() + m_slabUsed;
+    m_slabUsed += chunkBytes;
+    return chunk;
+}
+
+void HistoryTextArena::Assign(HistoryText& text, std::string_view value)
+{
+    if (value.size() > MAX_TEXT)
+        value = value.substr(0, MAX_TEXT);
+
+    int sizeClass = GetSizeClass(uint32_t(value.size()));
+    if (text.sizeClass != sizeClass)
+    {
+        // Shrinking to a smaller class too, so a chunk of a long reply is not held by short ones
+        Release(text);
+        text.data = Allocate(sizeClass);
+        text.sizeClass = uint8_t(sizeClass);
+        m_usedBytes += size_t(MIN_CHUNK) << sizeClass;
+    }
+    if (!value.empty())
+        std::memcpy(text.data, value.data(), value.size());
+    text.length = uint32_t(value.size());
+}
+
+void HistoryTextArena::Release(HistoryText& text)
+{
+    if (text.sizeClass < SIZE_CLASSES)
+    {
+        m_free[text.sizeClass].push_back(text.data);
+        m_usedBytes -= size_t(MIN_CHUNK) << text.sizeClass;
+    }
+    text = HistoryText();
+}
+
+void HistoryRing::Reset(uint32_t capacity)
+{
+    if (capacity != m_capacity)
+    {
+        m_slots.reset(capacity ? new TurnSlot[capacity] : nullptr);
+        m_capacity = capacity;
+    }
+    m_head = 0;
+    m_count = 0;
+}
+
+void HistoryRing::Push(HistoryTextArena& arena, std::string_view playerMessage, std::string_view botReply)
+{
+    if (!m_capacity)
+        return;
+
+    TurnSlot* slot;
+    if (m_count < m_capacity)
+    {
+        slot = &m_slots[(m_head + m_count) % m_capacity];
+        ++m_count;
+    }
+    else
+    {
+        // Full: the oldest slot becomes the newest and its chunks are reused
+        slot = &m_slots[m_head];
+        m_head = (m_head + 1) % m_capacity;
+    }
+    arena.Assign(slot->playerMessage, playerMessage);
+    arena.Assign(slot->botReply, botReply);
+}
+
+void HistoryRing::Clear(HistoryTextArena& arena)
+{
+    for (uint32_t i = 0; i < m_capacity; ++i)
+    {
+        arena.Release(m_slots[i].playerMessage);
+        arena.Release(m_slots[i].botReply);
+    }
+    m_head = 0;
+    m_count = 0;
+}
+
+std::string_view TruncateHistoryText(std::string_view text, uint32_t maxLength)
+{
+    if (!maxLength || maxLength > HistoryTextArena::MAX_TEXT)
+        maxLength = HistoryTextArena::MAX_TEXT;
+    if (text.size() <= maxLength)
+        return text;
+
+    // Back up over continuation bytes to the start of the cut sequence
+    size_t length = maxLength;
+    while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80)
+        --length;
+    return text.substr(0, length);
+}
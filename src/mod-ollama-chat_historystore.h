@@ -0,0 +1,90 @@
+#ifndef MOD_OLLAMA_CHAT_HISTORYSTORE_H
+#define MOD_OLLAMA_CHAT_HISTORYSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// One piece of history text in a HistoryTextArena chunk
+struct HistoryText
+{
+    char*    data = nullptr;
+    uint32_t length = 0;
+    uint8_t  sizeClass = 0xFF;   // 0xFF: no chunk
+
+    std::string_view View() const { return { data, length }; }
+};
+
+// Slab allocator for conversation history text.
+//
+// Chunks come in power-of-two size classes carved out of 64 KiB slabs. Freed chunks go to
+// a per-class free list and are handed out again, and text that still fits stays in its
+// chunk, so once the rings are full appending new turns no longer touches the heap.
+// Slabs are only returned when the arena is destroyed. Not thread-safe; each relationship
+// shard owns one and guards it with the shard lock.
+class HistoryTextArena
+{
+public:
+    static constexpr size_t   SLAB_BYTES = 64 * 1024;
+    static constexpr uint32_t MIN_CHUNK = 32;
+    static constexpr int      SIZE_CLASSES = 10;
+    static constexpr uint32_t MAX_TEXT = MIN_CHUNK << (SIZE_CLASSES - 1);   // 16 KiB
+
+    // Replaces the contents of text, truncated to MAX_TEXT
+    void Assign(HistoryText& text, std::string_view value);
+    void Release(HistoryText& text);
+
+    size_t ReservedBytes() const { return m_slabs.size() * SLAB_BYTES; }
+    size_t UsedBytes() const { return m_usedBytes; }
+
+private:
+    char* Allocate(int sizeClass);
+
+    std::vector<std::unique_ptr<char[]>> m_slabs;
+    size_t m_slabUsed = SLAB_BYTES;   // Bytes handed out from the newest slab
+    std::vector<char*> m_free[SIZE_CLASSES];
+    size_t m_usedBytes = 0;
+};
+
+// Fixed-capacity ring of the newest (player message, bot reply) turns of one pair,
+// with the text in a HistoryTextArena. Pushing onto a full ring overwrites the oldest turn.
+class HistoryRing
+{
+public:
+    // Sets the capacity of an empty ring; the slot array is kept if it already matches
+    void Reset(uint32_t capacity);
+    void Push(HistoryTextArena& arena, std::string_view playerMessage, std::string_view botReply);
+    // Releases all text; the slots stay allocated for reuse
+    void Clear(HistoryTextArena& arena);
+
+    uint32_t Size() const { return m_count; }
+    uint32_t Capacity() const { return m_capacity; }
+
+    // Turn i, 0 being the oldest. Valid until the ring is next changed.
+    std::string_view PlayerMessage(uint32_t i) const { return Slot(i).playerMessage.View(); }
+    std::string_view BotReply(uint32_t i) const { return Slot(i).botReply.View(); }
+
+private:
+    struct TurnSlot
+    {
+        HistoryText playerMessage;
+        HistoryText botReply;
+    };
+
+    const TurnSlot& Slot(uint32_t i) const { return m_slots[(m_head + i) % m_capacity]; }
+
+    std::unique_ptr<TurnSlot[]> m_slots;
+    uint32_t m_capacity = 0;
+    uint32_t m_head = 0;    // Oldest turn
+    uint32_t m_count = 0;
+};
+
+/**
+ * Shorten text to at most maxLength bytes (0 = HistoryTextArena::MAX_TEXT) without
+ * splitting a UTF-8 sequence.
+ */
+std::string_view TruncateHistoryText(std::string_view text, uint32_t maxLength);
+
+#endif // MOD_OLLAMA_CHAT_HISTORYSTORE_H
@@ -0,0 +1,519 @@
+#include "mod-ollama-chat_journal.h"
+#include "mod-ollama-chat_config.h"
+#include "mod-ollama-chat_history.h"
+#include "mod-ollama-chat_relationship.h"
+#include "mod-ollama-chat_sentiment.h"
+#include "Log.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+enum JournalRecordType : uint8_t
+{
+    JOURNAL_HISTORY_TURN = 1,
+    JOURNAL_SENTIMENT,
+    JOURNAL_SENTIMENT_RESET,
+};
+
+// A record is its payload length and FNV-1a checksum (little-endian uint32 each) followed
+// by the payload. A write torn by a crash fails one of the two, which ends the segment.
+static constexpr size_t   JOURNAL_HEADER_BYTES = 8;
+static constexpr uint32_t JOURNAL_MAX_RECORD = 1 << 20;
+
+static std::mutex journalMutex;                   // Guards the queue, the stop flag and the stats
+static std::condition_variable journalWake;
+static std::string journalQueue;                  // Encoded records not yet written
+static size_t journalQueuedRecords = 0;
+static bool journalStopping = false;
+static PersistenceJournalStats journalStats;
+static std::atomic<bool> journalRunning{false};
+static std::thread journalThread;
+
+// Only used by the persistence thread once it runs. The path is read at startup, so a
+// reload cannot move the journal away from its segments.
+static std::string journalPath;
+static FILE* journalFile = nullptr;
+static uint32_t journalSegment = 0;
+
+static uint32_t JournalChecksum(std::string_view data)
+{
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : data)
+        hash = (hash ^ c) * 16777619u;
+    return hash;
+}
+
+static void PutU32(std::string& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back(char(value >> (i * 8)));
+}
+
+static void PutU64(std::string& out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+        out.push_back(char(value >> (i * 8)));
+}
+
+static void PutString(std::string& out, std::string_view value)
+{
+    PutU32(out, uint32_t(value.size()));
+    out.append(value);
+}
+
+// Reads a payload back; any read past the end clears ok
+struct JournalReader
+{
+    std::string_view data;
+    bool ok = true;
+
+    uint64_t Get(int bytes)
+    {
+        if (data.size() < size_t(bytes))
+        {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= uint64_t(static_cast<unsigned char>(data[i])) << (i * 8);
+        data.remove_prefix(bytes);
+        return value;
+    }
+
+    std::string GetString()
+    {
+        uint32_t length = uint32_t(Get(4));
+        if (!ok || data.size() < length)
+        {
+            ok = false;
+            return {};
+        }
+        std::string value(data.substr(0, length));
+        data.remove_prefix(length);
+        return value;
+    }
+};
+
+// Frames a payload and queues it for the persistence thread
+static void QueueJournalRecord(const std::string& payload)
+{
+    std::string record;
+    record.reserve(JOURNAL_HEADER_BYTES + payload.size());
+    PutU32(record, uint32_t(payload.size()));
+    PutU32(record, JournalChecksum(payload));
+    record += payload;
+
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        journalQueue += record;
+        ++journalQueuedRecords;
+        ++journalStats.records;
+        journalStats.bytes += record.size();
+    }
+    journalWake.notify_one();
+}
+
+void JournalHistoryTurn(const PendingHistoryRow& row)
+{
+    if (!journalRunning)
+        return;
+
+    std::string payload;
+    payload.reserve(33 + row.playerMessage.size() + row.botReply.size());
+    payload.push_back(char(JOURNAL_HISTORY_TURN));
+    PutU64(payload, row.botGuid);
+    PutU64(payload, row.playerGuid);
+    PutU64(payload, uint64_t(row.timestamp));
+    PutString(payload, row.playerMessage);
+    PutString(payload, row.botReply);
+    QueueJournalRecord(payload);
+}
+
+void JournalSentimentChange(uint64_t botGuid, uint64_t playerGuid, float value)
+{
+    if (!journalRunning)
+        return;
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    std::string payload;
+    payload.push_back(char(JOURNAL_SENTIMENT));
+    PutU64(payload, botGuid);
+    PutU64(payload, playerGuid);
+    PutU32(payload, bits);
+    QueueJournalRecord(payload);
+}
+
+void JournalSentimentReset(const RelationshipShard& shard, uint64_t botGuid, uint64_t playerGuid)
+{
+    if (!journalRunning)
+        return;
+
+    std::string payload;
+    payload.push_back(char(JOURNAL_SENTIMENT_RESET));
+    PutU64(payload, botGuid);
+    PutU64(payload, playerGuid);
+    PutU32(payload, uint32_t(GetRelationshipShardIndex(shard)));
+    QueueJournalRecord(payload);
+}
+
+static std::string GetJournalSegmentPath(uint32_t segment)
+{
+    return fmt::format("{}.{:06}", journalPath, segment);
+}
+
+// Segment files on disk, oldest first
+static std::map<uint32_t, std::filesystem::path> ListJournalSegments()
+{
+    std::map<uint32_t, std::filesystem::path> segments;
+    std::filesystem::path base(journalPath);
+    std::filesystem::path dir = base.has_parent_path() ? base.parent_path() : std::filesystem::path(".");
+    std::string prefix = base.filename().string() + ".";
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string name = it->path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0)
+            continue;
+        std::string number = name.substr(prefix.size());
+        if (number.size() > 9 || !std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            continue;
+        segments[uint32_t(std::stoul(number))] = it->path();
+    }
+    return segments;
+}
+
+static void DeleteJournalSegments(uint32_t upToSegment)
+{
+    for (const auto& [segment, path] : ListJournalSegments())
+    {
+        if (segment > upToSegment)
+            break;
+        std::error_code ec;
+        if (!std::filesystem::remove(path, ec) && ec)
+            LOG_ERROR("server.loading", "[Ollama Chat] Could not delete journal segment {}: {}", path.string(), ec.message());
+    }
+}
+
+// Changes read back from the journal, in the order they were made
+struct JournalReplay
+{
+    std::vector<PendingHistoryRow> historyRows;
+    std::vector<std::pair<uint64_t, uint64_t>> sentimentResets;
+    SentimentValues sentiments;
+    uint64_t records = 0;
+};
+
+static void ApplyJournalRecord(JournalReplay& replay, std::string_view payload)
+{
+    JournalReader reader{ payload };
+    uint8_t type = uint8_t(reader.Get(1));
+    uint64_t botGuid = reader.Get(8);
+    uint64_t playerGuid = reader.Get(8);
+
+    switch (type)
+    {
+        case JOURNAL_HISTORY_TURN:
+        {
+            PendingHistoryRow row{ botGuid, playerGuid, time_t(reader.Get(8)), "", "" };
+            row.playerMessage = reader.GetString();
+            row.botReply = reader.GetString();
+            if (reader.ok)
+                replay.historyRows.push_back(std::move(row));
+            break;
+        }
+        case JOURNAL_SENTIMENT:
+        {
+            uint32_t bits = uint32_t(reader.Get(4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            if (reader.ok)
+                replay.sentiments[{ botGuid, playerGuid }] = value;
+            break;
+        }
+        case JOURNAL_SENTIMENT_RESET:
+        {
+            uint32_t shardIndex = uint32_t(reader.Get(4));
+            if (!reader.ok || shardIndex >= RELATIONSHIP_SHARD_COUNT)
+            {
+                reader.ok = false;
+                break;
+            }
+            // Values of the shard set before the reset are gone, so they are not written back.
+            // Other shards were reset at their own point in the journal.
+            const RelationshipShard* shard = &GetRelationshipShardByIndex(shardIndex);
+            for (auto it = replay.sentiments.begin(); it != replay.sentiments.end();)
+            {
+                bool matches = (!botGuid || it->first.first == botGuid) && (!playerGuid || it->first.second == playerGuid)
+                    && &GetRelationshipShard(it->first.first) == shard;
+                it = matches ? replay.sentiments.erase(it) : std::next(it);
+            }
+            // Deleting the rows once is enough for the records of every shard
+            std::pair<uint64_t, uint64_t> reset(botGuid, playerGuid);
+            if (std::find(replay.sentimentResets.begin(), replay.sentimentResets.end(), reset) == replay.sentimentResets.end())
+                replay.sentimentResets.push_back(reset);
+            break;
+        }
+        default:
+            reader.ok = false;
+            break;
+    }
+
+    if (reader.ok)
+        ++replay.records;
+}
+
+static void ReadJournalSegment(JournalReplay& replay, const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::string_view rest(data);
+    while (rest.size() >= JOURNAL_HEADER_BYTES)
+    {
+        JournalReader header{ rest.substr(0, JOURNAL_HEADER_BYTES) };
+        uint32_t length = uint32_t(header.Get(4));
+        uint32_t checksum = uint32_t(header.Get(4));
+        if (length > JOURNAL_MAX_RECORD || rest.size() - JOURNAL_HEADER_BYTES < length)
+            break;
+
+        std::string_view payload = rest.substr(JOURNAL_HEADER_BYTES, length);
+        if (JournalChecksum(payload) != checksum)
+            break;
+        ApplyJournalRecord(replay, payload);
+        rest.remove_prefix(JOURNAL_HEADER_BYTES + length);
+    }
+
+    if (!rest.empty())
+        LOG_WARN("server.loading", "[Ollama Chat] Ignoring {} bytes of incomplete records at the end of journal segment {}.",
+                 rest.size(), path.string());
+}
+
+// Queues the changes of segments a previous run did not drain, for the first drain to commit.
+// The segments stay until then. Returns the newest segment number.
+static uint32_t ReplayPersistenceJournal()
+{
+    std::map<uint32_t, std::filesystem::path> segments = ListJournalSegments();
+    if (segments.empty())
+        return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    JournalReplay replay;
+    for (const auto& [segment, path] : segments)
+        ReadJournalSegment(replay, path);
+
+    size_t historyRows = replay.historyRows.size();
+    if (!replay.historyRows.empty())
+        QueueBotConversationHistoryRows(std::move(replay.historyRows));
+
+    if (!replay.sentiments.empty() || !replay.sentimentResets.empty())
+    {
+        std::vector<BotPlayerSentiment> values;
+        values.reserve(replay.sentiments.size());
+        for (const auto& [key, value] : replay.sentiments)
+            values.push_back({ key.first, key.second, value });
+        QueueJournaledSentiments(replay.sentimentResets, values);
+    }
+
+    uint64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("server.loading", "[Ollama Chat] Replayed {} journal records from {} segments ({} history turns, {} sentiment values, {} resets) in {} ms.",
+             replay.records, segments.size(), historyRows, replay.sentiments.size(),
+             replay.sentimentResets.size(), millis);
+
+    std::lock_guard<std::mutex> lock(journalMutex);
+    journalStats.replayedRecords = replay.records;
+    return segments.rbegin()->first;
+}
+
+static bool OpenJournalSegment(uint32_t segment)
+{
+    std::string path = GetJournalSegmentPath(segment);
+    FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file)
+    {
+        LOG_ERROR("server.loading", "[Ollama Chat] Could not open journal segment {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    if (journalFile)
+        std::fclose(journalFile);
+    journalFile = file;
+    journalSegment = segment;
+    return true;
+}
+
+static void WriteJournalRecords(const std::string& records)
+{
+    if (std::fwrite(records.data(), 1, records.size(), journalFile) != records.size() || std::fflush(journalFile) != 0)
+    {
+        LOG_ERROR("server.loading", "[Ollama Chat] Writing journal segment {} failed: {}",
+                  GetJournalSegmentPath(journalSegment), std::strerror(errno));
+        return;
+    }
+
+    // Flushed data survives the process crashing; syncing also covers the machine going down
+    if (g_PersistenceJournalSync)
+    {
+#ifdef _WIN32
+        _commit(_fileno(journalFile));
+#else
+        fsync(fileno(journalFile));
+#endif
+    }
+}
+
+// Writes the queued changes to the database and deletes the segments holding them once the
+// commits are confirmed. If either fails, the segments stay for the next drain, which retries
+// the requeued changes, or for the replay at the next start.
+static void DrainPersistenceJournal()
+{
+    // Every record in the current segment, and in older segments still on disk, was journaled
+    // under the shard lock that queued its change, so once the next segment is open the flushes
+    // below take all of them. Records journaled after the switch may be committed as well and
+    // are then replayed harmlessly.
+    uint32_t drained = journalSegment;
+    if (!OpenJournalSegment(journalSegment + 1))
+        return;
+
+    bool historyCommitted = FlushBotConversationHistoryToDB();
+    bool sentimentsCommitted = FlushBotPlayerSentimentsToDB();
+    if (historyCommitted && sentimentsCommitted)
+        DeleteJournalSegments(drained);
+
+    std::lock_guard<std::mutex> lock(journalMutex);
+    ++journalStats.drains;
+    journalStats.lastDrain = time(nullptr);
+}
+
+// Replayed changes are only in memory until the first drain, so it runs right away
+static void PersistenceThreadMain(bool drainNow)
+{
+    auto drainInterval = [] { return std::chrono::seconds(std::max<uint32_t>(g_PersistenceDrainInterval, 1)); };
+    auto nextDrain = std::chrono::steady_clock::now() + (drainNow ? std::chrono::seconds(0) : drainInterval());
+    std::string records;
+
+    for (;;)
+    {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(journalMutex);
+            journalWake.wait_until(lock, nextDrain, [] { return journalStopping || !journalQueue.empty(); });
+            records.swap(journalQueue);
+            journalQueuedRecords = 0;
+            stopping = journalStopping;
+        }
+
+        // Records that arrive while this write runs are written together on the next pass
+        if (!records.empty())
+        {
+            WriteJournalRecords(records);
+            records.clear();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (stopping || now >= nextDrain)
+        {
+            DrainPersistenceJournal();
+            nextDrain = now + drainInterval();
+        }
+
+        if (stopping)
+            break;
+    }
+}
+
+void StartPersistenceJournal()
+{
+    if (!g_EnablePersistenceJournal || journalRunning)
+        return;
+
+    journalPath = g_PersistenceJournalPath;
+    uint32_t newest = ReplayPersistenceJournal();
+    if (!OpenJournalSegment(newest + 1))
+    {
+        // Without a thread to drain them, replayed changes are committed now so the segments
+        // are not replayed again over newer values
+        if (newest && FlushBotConversationHistoryToDB() && FlushBotPlayerSentimentsToDB())
+            DeleteJournalSegments(newest);
+        LOG_ERROR("server.loading", "[Ollama Chat] Persistence journal disabled; history and sentiment are saved at the configured intervals.");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        journalStopping = false;
+    }
+    journalRunning = true;
+    journalThread = std::thread(PersistenceThreadMain, newest != 0);
+
+    LOG_INFO("server.loading", "[Ollama Chat] Persistence journal started at {}, draining every {} seconds.",
+             GetJournalSegmentPath(journalSegment), g_PersistenceDrainInterval);
+    LOG_INFO("server.loading", "[Ollama Chat] OllamaChat.ConversationHistorySaveInterval ({}) and OllamaChat.SentimentSaveInterval ({}) "
+             "are not used while the persistence journal runs.", g_ConversationHistorySaveInterval, g_SentimentSaveInterval);
+}
+
+void StopPersistenceJournal()
+{
+    if (!journalRunning)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        journalStopping = true;
+    }
+    journalWake.notify_one();
+    journalThread.join();
+    journalRunning = false;
+
+    if (journalFile)
+    {
+        std::fclose(journalFile);
+        journalFile = nullptr;
+    }
+
+    // The final drain switched to a new segment and nothing was written after it. Older
+    // segments are only left if that drain could not commit, and are replayed next start.
+    std::error_code ec;
+    std::filesystem::path active(GetJournalSegmentPath(journalSegment));
+    if (std::filesystem::file_size(active, ec) == 0 && !ec)
+        std::filesystem::remove(active, ec);
+}
+
+bool IsPersistenceJournalRunning()
+{
+    return journalRunning;
+}
+
+PersistenceJournalStats GetPersistenceJournalStats()
+{
+    PersistenceJournalStats stats;
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        stats = journalStats;
+        stats.queued = journalQueuedRecords;
+    }
+    stats.segments = uint32_t(ListJournalSegments().size());
+    return stats;
+}
@@ -0,0 +1,62 @@
+#ifndef MOD_OLLAMA_CHAT_JOURNAL_H
+#define MOD_OLLAMA_CHAT_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+struct PendingHistoryRow;
+struct RelationshipShard;
+
+// --------------------------------------------
+// Write-behind persistence journal
+// --------------------------------------------
+//
+// History turns and sentiment changes are appended to a local journal as they happen,
+// and a persistence thread drains the in-memory save queues to the database every
+// OllamaChat.PersistenceDrainInterval seconds. The journal is split into numbered
+// segment files next to OllamaChat.PersistenceJournalPath; a drain starts a new segment
+// and deletes the older ones once the database confirms their changes are committed.
+// Segments left behind by a crash or a failed commit are replayed at startup into the
+// save queues and drained right away. Replaying is idempotent: history rows are inserted
+// with INSERT IGNORE and sentiment values are applied in order.
+
+/**
+ * Replay leftover segments, open a new one and start the persistence thread.
+ * Does nothing if OllamaChat.EnablePersistenceJournal is off. Called once at startup.
+ */
+void StartPersistenceJournal();
+
+/**
+ * Write out queued records, drain the save queues one last time and stop the thread
+ */
+void StopPersistenceJournal();
+
+// True while the persistence thread drains the save queues instead of the interval saves
+bool IsPersistenceJournalRunning();
+
+/**
+ * Journal a change. Called under the shard lock that queues the change for saving, so
+ * a drain never deletes a segment holding a change it did not take. Only encodes the
+ * record; the persistence thread writes it.
+ */
+void JournalHistoryTurn(const PendingHistoryRow& row);
+void JournalSentimentChange(uint64_t botGuid, uint64_t playerGuid, float value);
+// botGuid or playerGuid 0 matches all, as in ResetBotPlayerSentiments. A reset of all bots
+// is journaled once per shard; on replay each record only clears the pairs of its shard.
+void JournalSentimentReset(const RelationshipShard& shard, uint64_t botGuid, uint64_t playerGuid);
+
+struct PersistenceJournalStats
+{
+    uint64_t records = 0;        // Appended since startup
+    uint64_t bytes = 0;
+    size_t   queued = 0;         // Encoded but not written to the segment yet
+    uint32_t segments = 0;       // Segment files on disk, including the active one
+    uint64_t drains = 0;
+    time_t   lastDrain = 0;
+    uint64_t replayedRecords = 0;
+};
+
+PersistenceJournalStats GetPersistenceJournalStats();
+
+#endif // MOD_OLLAMA_CHAT_JOURNAL_H
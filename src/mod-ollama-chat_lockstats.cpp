@@ -0,0 +1,63 @@
+#include "mod-ollama-chat_lockstats.h"
+#include <fmt/core.h>
+
+const char* TrackedLockStr[TRACKED_LOCK_COUNT] =
+{
+    "Relationship (exclusive)",
+    "Relationship (shared)"
+};
+
+std::atomic<bool> g_LockTimingEnabled{false};
+
+static LockHoldHistogram lockHoldHistograms[TRACKED_LOCK_COUNT];
+static LockHoldHistogram lockWaitHistograms[TRACKED_LOCK_COUNT];
+
+LockHoldHistogram& GetLockHoldHistogram(TrackedLock lock)
+{
+    return lockHoldHistograms[lock];
+}
+
+LockHoldHistogram& GetLockWaitHistogram(TrackedLock lock)
+{
+    return lockWaitHistograms[lock];
+}
+
+void LockHoldHistogram::Record(uint64_t micros)
+{
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && micros >= (uint64_t(1) << bucket))
+        ++bucket;
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (micros > max && !m_max.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+        ;
+}
+
+uint64_t LockHoldHistogram::Percentile(double fraction) const
+{
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKETS; ++i)
+        total += Count(i);
+    if (!total)
+        return 0;
+
+    uint64_t target = uint64_t(fraction * total);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        seen += Count(i);
+        if (seen > target)
+            return uint64_t(1) << i;
+    }
+    return uint64_t(1) << (BUCKETS - 1);
+}
+
+std::string LockHoldHistogram::Describe(const char* what) const
+{
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKETS; ++i)
+        total += Count(i);
+
+    return fmt::format("{} {}, p50 <{} us, p99 <{} us, max {} us", total, what, Percentile(0.5), Percentile(0.99), Max());
+}
@@ -0,0 +1,135 @@
+#ifndef MOD_OLLAMA_CHAT_LOCKSTATS_H
+#define MOD_OLLAMA_CHAT_LOCKSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+// Shared-state locks whose wait and hold times are tracked for ".ollama stats"
+enum TrackedLock : uint8_t
+{
+    TRACKED_LOCK_RELATIONSHIP = 0,      // RelationshipShard::mutex held exclusively, all shards together
+    TRACKED_LOCK_RELATIONSHIP_SHARED,   // RelationshipShard::mutex held shared, all shards together
+    TRACKED_LOCK_COUNT
+};
+
+extern const char* TrackedLockStr[TRACKED_LOCK_COUNT];
+
+// OllamaChat.EnableLockTiming, set on every config load. Timing reads the clock twice per
+// lock and updates histograms shared by every shard, so it is off unless asked for.
+extern std::atomic<bool> g_LockTimingEnabled;
+
+// Power-of-two histogram of lock wait or hold times. Bucket i counts durations shorter
+// than 2^i microseconds (the last bucket takes everything longer).
+class LockHoldHistogram
+{
+public:
+    static constexpr int BUCKETS = 16;
+
+    void Record(uint64_t micros);
+    uint64_t Count(int bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+    uint64_t Max() const { return m_max.load(std::memory_order_relaxed); }
+
+    // Upper bound in microseconds of the bucket holding the given fraction of all holds
+    uint64_t Percentile(double fraction) const;
+    std::string Describe(const char* what = "holds") const;
+
+private:
+    std::atomic<uint64_t> m_buckets[BUCKETS] = {};
+    std::atomic<uint64_t> m_max{0};
+};
+
+LockHoldHistogram& GetLockHoldHistogram(TrackedLock lock);
+// Time spent waiting to acquire the lock, i.e. contention
+LockHoldHistogram& GetLockWaitHistogram(TrackedLock lock);
+
+// std::lock_guard that records how long it waited for the mutex and how long it held it,
+// while g_LockTimingEnabled is set. Takes the exclusive side of a std::shared_mutex too.
+template<typename Mutex>
+class TimedLockGuard
+{
+public:
+    TimedLockGuard(Mutex& mutex, TrackedLock lock)
+        : m_mutex(mutex), m_lock(lock), m_timed(g_LockTimingEnabled.load(std::memory_order_relaxed))
+    {
+        if (!m_timed)
+        {
+            m_mutex.lock();
+            return;
+        }
+
+        auto requested = std::chrono::steady_clock::now();
+        m_mutex.lock();
+        m_start = std::chrono::steady_clock::now();
+        GetLockWaitHistogram(m_lock).Record(std::chrono::duration_cast<std::chrono::microseconds>(m_start - requested).count());
+    }
+
+    ~TimedLockGuard()
+    {
+        if (!m_timed)
+        {
+            m_mutex.unlock();
+            return;
+        }
+
+        auto held = std::chrono::steady_clock::now() - m_start;
+        m_mutex.unlock();
+        GetLockHoldHistogram(m_lock).Record(std::chrono::duration_cast<std::chrono::microseconds>(held).count());
+    }
+
+    TimedLockGuard(const TimedLockGuard&) = delete;
+    TimedLockGuard& operator=(const TimedLockGuard&) = delete;
+
+private:
+    Mutex& m_mutex;
+    TrackedLock m_lock;
+    bool m_timed;   // Fixed at construction, so a reload between lock and unlock is harmless
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// std::shared_lock counterpart of TimedLockGuard
+class TimedSharedLockGuard
+{
+public:
+    TimedSharedLockGuard(std::shared_mutex& mutex, TrackedLock lock)
+        : m_mutex(mutex), m_lock(lock), m_timed(g_LockTimingEnabled.load(std::memory_order_relaxed))
+    {
+        if (!m_timed)
+        {
+            m_mutex.lock_shared();
+            return;
+        }
+
+        auto requested = std::chrono::steady_clock::now();
+        m_mutex.lock_shared();
+        m_start = std::chrono::steady_clock::now();
+        GetLockWaitHistogram(m_lock).Record(std::chrono::duration_cast<std::chrono::microseconds>(m_start - requested).count());
+    }
+
+    ~TimedSharedLockGuard()
+    {
+        if (!m_timed)
+        {
+            m_mutex.unlock_shared();
+            return;
+        }
+
+        auto held = std::chrono::steady_clock::now() - m_start;
+        m_mutex.unlock_shared();
+        GetLockHoldHistogram(m_lock).Record(std::chrono::duration_cast<std::chrono::microseconds>(held).count());
+    }
+
+    TimedSharedLockGuard(const TimedSharedLockGuard&) = delete;
+    TimedSharedLockGuard& operator=(const TimedSharedLockGuard&) = delete;
+
+private:
+    std::shared_mutex& m_mutex;
+    TrackedLock m_lock;
+    bool m_timed;   // Fixed at construction, so a reload between lock and unlock is harmless
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // MOD_OLLAMA_CHAT_LOCKSTATS_H
@@ -4,6 +4,8 @@
 #include "mod-ollama-chat_events.h"
 #include "mod-ollama-chat_command.h"
 #include "mod-ollama-chat_rag.h"
+#include "mod-ollama-chat_spellcache.h"
+#include "mod-ollama-chat_snapshot.h"
 #include "Log.h"
 
 void Addmod_ollama_chatScripts()
@@ -23,5 +25,7 @@ void Addmod_ollama_chatScripts()
     new ChatOnLevelUp();
     new ChatOnAchievement();
     new ChatOnGameObjectUse();
+    new OllamaSpellCacheScript();
+    new OllamaSnapshotCacheScript();
     new OllamaChatConfigCommand();
 }
@@ -0,0 +1,214 @@
+#ifndef MOD_OLLAMA_CHAT_PAIRMAP_H
+#define MOD_OLLAMA_CHAT_PAIRMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map keyed by a (bot GUID, player GUID) pair.
+//
+// Entries live in one array with linear probing, so a lookup is a single hash and
+// usually one cache line instead of the two hashes and node hops of a nested
+// unordered_map. A bot GUID of 0 marks an empty slot, so it cannot be used as a key.
+// Erasing shifts the following entries back instead of leaving tombstones, which keeps
+// probe sequences short under constant insert/evict churn. Inserting or erasing moves
+// entries, so pointers and references into the map are only valid until the next change.
+template<typename Value>
+class FlatPairMap
+{
+public:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    FlatPairMap() = default;
+
+    Value* Find(uint64_t botGuid, uint64_t playerGuid)
+    {
+        size_t slot = FindSlot(botGuid, playerGuid);
+        return slot == NOT_FOUND ? nullptr : &m_slots[slot].value;
+    }
+
+    const Value* Find(uint64_t botGuid, uint64_t playerGuid) const
+    {
+        size_t slot = FindSlot(botGuid, playerGuid);
+        return slot == NOT_FOUND ? nullptr : &m_slots[slot].value;
+    }
+
+    // Returns the entry for the pair, inserting a default-constructed one if there is none
+    Value& FindOrInsert(uint64_t botGuid, uint64_t playerGuid)
+    {
+        // Grow at 3/4 load; linear probing degrades quickly past that
+        if ((m_size + 1) * 4 > m_slots.size() * 3)
+            Rehash(m_slots.empty() ? MIN_CAPACITY : m_slots.size() * 2);
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t slot = Hash(botGuid, playerGuid) & mask;; slot = (slot + 1) & mask)
+        {
+            Slot& entry = m_slots[slot];
+            if (!entry.botGuid)
+            {
+                entry.botGuid = botGuid;
+                entry.playerGuid = playerGuid;
+                entry.value = Value();
+                ++m_size;
+                return entry.value;
+            }
+            if (entry.botGuid == botGuid && entry.playerGuid == playerGuid)
+                return entry.value;
+        }
+    }
+
+    bool Erase(uint64_t botGuid, uint64_t playerGuid)
+    {
+        size_t slot = FindSlot(botGuid, playerGuid);
+        if (slot == NOT_FOUND)
+            return false;
+        EraseSlot(slot);
+        return true;
+    }
+
+    // Calls fn(botGuid, playerGuid, value) for every entry; fn must not insert or erase
+    template<typename Fn>
+    void ForEach(Fn&& fn)
+    {
+        for (Slot& entry : m_slots)
+        {
+            if (entry.botGuid)
+                fn(entry.botGuid, entry.playerGuid, entry.value);
+        }
+    }
+
+    template<typename Fn>
+    void ForEach(Fn&& fn) const
+    {
+        for (const Slot& entry : m_slots)
+        {
+            if (entry.botGuid)
+                fn(entry.botGuid, entry.playerGuid, entry.value);
+        }
+    }
+
+    // Erases every entry for which pred(botGuid, playerGuid, value) returns true. pred may
+    // modify the value. Returns the number of erased entries.
+    template<typename Pred>
+    size_t EraseIf(Pred&& pred)
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> erased;
+        for (Slot& entry : m_slots)
+        {
+            if (entry.botGuid && pred(entry.botGuid, entry.playerGuid, entry.value))
+                erased.emplace_back(entry.botGuid, entry.playerGuid);
+        }
+        for (const auto& [botGuid, playerGuid] : erased)
+            Erase(botGuid, playerGuid);
+        return erased.size();
+    }
+
+    void Clear()
+    {
+        m_slots.clear();
+        m_slots.shrink_to_fit();
+        m_size = 0;
+    }
+
+    // Raw slot access, used for sampled eviction. Slots are not in any useful order.
+    size_t SlotCount() const { return m_slots.size(); }
+    bool SlotUsed(size_t slot) const { return m_slots[slot].botGuid != 0; }
+    std::pair<uint64_t, uint64_t> SlotKey(size_t slot) const { return { m_slots[slot].botGuid, m_slots[slot].playerGuid }; }
+    Value& SlotValue(size_t slot) { return m_slots[slot].value; }
+
+    size_t Size() const { return m_size; }
+    size_t MemoryBytes() const { return m_slots.capacity() * sizeof(Slot); }
+
+    // Average number of slots a successful lookup looks at, 1.0 being ideal
+    double AverageProbeLength() const
+    {
+        if (!m_size)
+            return 0.0;
+        size_t mask = m_slots.size() - 1;
+        size_t probes = 0;
+        for (size_t slot = 0; slot < m_slots.size(); ++slot)
+        {
+            if (m_slots[slot].botGuid)
+                probes += ((slot - (Hash(m_slots[slot].botGuid, m_slots[slot].playerGuid) & mask)) & mask) + 1;
+        }
+        return double(probes) / m_size;
+    }
+
+private:
+    static constexpr size_t NOT_FOUND = size_t(-1);
+
+    struct Slot
+    {
+        uint64_t botGuid = 0;
+        uint64_t playerGuid = 0;
+        Value    value{};
+    };
+
+    static size_t Hash(uint64_t botGuid, uint64_t playerGuid)
+    {
+        // Both GUIDs are mostly low counter bits; mix them so neighbours spread out
+        uint64_t h = botGuid * 0x9E3779B97F4A7C15ULL ^ playerGuid;
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 32;
+        return size_t(h);
+    }
+
+    size_t FindSlot(uint64_t botGuid, uint64_t playerGuid) const
+    {
+        if (m_slots.empty() || !botGuid)
+            return NOT_FOUND;
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t slot = Hash(botGuid, playerGuid) & mask;; slot = (slot + 1) & mask)
+        {
+            const Slot& entry = m_slots[slot];
+            if (!entry.botGuid)
+                return NOT_FOUND;
+            if (entry.botGuid == botGuid && entry.playerGuid == playerGuid)
+                return slot;
+        }
+    }
+
+    // Backward-shift deletion: pull later entries of the probe run into the gap
+    void EraseSlot(size_t slot)
+    {
+        size_t mask = m_slots.size() - 1;
+        size_t gap = slot;
+        for (size_t next = (gap + 1) & mask; m_slots[next].botGuid; next = (next + 1) & mask)
+        {
+            size_t home = Hash(m_slots[next].botGuid, m_slots[next].playerGuid) & mask;
+            // The entry may move into the gap only if its home is not between gap and next
+            if (((next - home) & mask) >= ((next - gap) & mask))
+            {
+                m_slots[gap] = std::move(m_slots[next]);
+                gap = next;
+            }
+        }
+        m_slots[gap] = Slot();
+        --m_size;
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        m_slots.resize(capacity);
+        size_t mask = capacity - 1;
+        for (Slot& entry : old)
+        {
+            if (!entry.botGuid)
+                continue;
+            size_t slot = Hash(entry.botGuid, entry.playerGuid) & mask;
+            while (m_slots[slot].botGuid)
+                slot = (slot + 1) & mask;
+            m_slots[slot] = std::move(entry);
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    size_t m_size = 0;
+};
+
+#endif // MOD_OLLAMA_CHAT_PAIRMAP_H
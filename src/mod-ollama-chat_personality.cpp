@@ -3,74 +3,75 @@
 #include "PlayerbotMgr.h"
 #include "Log.h"
 #include "mod-ollama-chat_config.h"
+#include "mod-ollama-chat_dbsave.h"
+#include "mod-ollama-chat-utilities.h"
 #include "DatabaseEnv.h"
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <random>
+#include <thread>
 #include <vector>
 
+// Assignments not yet written, the newest per bot. A random assignment and a manual change
+// of the same bot go out as one row, so they cannot reach the database out of order.
+// Queued while holding g_BotPersonalityMutex, which is always taken first.
+static std::mutex personalityWriteMutex;
+static std::map<uint64_t, std::string> pendingPersonalityWrites;
+static std::atomic<bool> personalitySaveRunning{false};
+
+// Caller holds g_BotPersonalityMutex exclusively
+static void QueueBotPersonalityWrite(uint64_t botGuid, const std::string& personality)
+{
+    if (!g_BotPersonalityTableExists)
+        return;
+
+    std::lock_guard<std::mutex> lock(personalityWriteMutex);
+    pendingPersonalityWrites[botGuid] = personality;
+}
+
 // Internal personality map
 std::string GetBotPersonality(Player* bot)
 {
     uint64_t botGuid = bot->GetGUID().GetRawValue();
 
     // If personality already assigned, return it (but only if RP personalities are enabled)
-    auto it = g_BotPersonalityList.find(botGuid);
-    if (it != g_BotPersonalityList.end())
     {
-        // If RP personalities are disabled, reset to default
-        if (!g_EnableRPPersonalities)
-        {
-            g_BotPersonalityList[botGuid] = "default";
-            return "default";
-        }
-        if(g_DebugEnabled)
+        std::shared_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
+        auto it = g_BotPersonalityList.find(botGuid);
+        if (it != g_BotPersonalityList.end() && g_EnableRPPersonalities)
         {
-            LOG_INFO("server.loading", "[Ollama Chat] Using existing personality '{}' for bot {}", it->second, bot->GetName());
+            if(g_DebugEnabled)
+            {
+                LOG_INFO("server.loading", "[Ollama Chat] Using existing personality '{}' for bot {}", it->second, bot->GetName());
+            }
+            return it->second;
         }
-        return it->second;
-    }
-
-    // RP personalities disabled or config not loaded
-    if (!g_EnableRPPersonalities || g_PersonalityKeysRandomOnly.empty())
-    {
-        g_BotPersonalityList[botGuid] = "default";
-        return "default";
     }
 
-    // Try to load from database if you have persistence
-    if (g_BotPersonalityList.find(botGuid) != g_BotPersonalityList.end())
+    std::string chosenPersonality;
     {
-        // DB stores string keys now
-        std::string dbPersonality = g_BotPersonalityList[botGuid];
+        std::unique_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
 
-        if (dbPersonality.empty())
+        // RP personalities disabled or config not loaded
+        if (!g_EnableRPPersonalities || g_PersonalityKeysRandomOnly.empty())
         {
-            dbPersonality = "default";
+            g_BotPersonalityList[botGuid] = "default";
+            return "default";
         }
 
-        g_BotPersonalityList[botGuid] = dbPersonality;
-
-        if(g_DebugEnabled)
-        {
-            LOG_INFO("server.loading", "[Ollama Chat] Using database personality '{}' for bot {}", dbPersonality, bot->GetName());
-        }
-        return dbPersonality;
-    }
+        // Another reply for the same bot may have assigned one since the lookup above
+        auto it = g_BotPersonalityList.find(botGuid);
+        if (it != g_BotPersonalityList.end())
+            return it->second;
 
-    // Otherwise, assign randomly from config (only from non-manual personalities)
-    uint32 newIdx = urand(0, g_PersonalityKeysRandomOnly.size() - 1);
-    std::string chosenPersonality = g_PersonalityKeysRandomOnly[newIdx];
-    g_BotPersonalityList[botGuid] = chosenPersonality;
+        // Otherwise, assign randomly from config (only from non-manual personalities)
+        uint32 newIdx = urand(0, g_PersonalityKeysRandomOnly.size() - 1);
+        chosenPersonality = g_PersonalityKeysRandomOnly[newIdx];
+        g_BotPersonalityList[botGuid] = chosenPersonality;
 
-    // Save to database if schema supports string (recommend TEXT or VARCHAR column for personality)
-    QueryResult tableExists = CharacterDatabase.Query(
-        "SELECT * FROM information_schema.tables WHERE table_schema = 'acore_characters' AND table_name = 'mod_ollama_chat_personality' LIMIT 1;");
-    if (!tableExists)
-    {
-        LOG_INFO("server.loading", "[Ollama Chat] Please source the required database table first");
-    }
-    else
-    {
-        CharacterDatabase.Execute("INSERT INTO mod_ollama_chat_personality (guid, personality) VALUES ({}, '{}')", botGuid, chosenPersonality);
+        // Written by the next batched save, so the reply never waits on the database
+        QueueBotPersonalityWrite(botGuid, chosenPersonality);
     }
 
     if(g_DebugEnabled)
@@ -83,6 +84,7 @@ std::string GetBotPersonality(Player* bot)
 
 std::string GetPersonalityPromptAddition(const std::string& personality)
 {
+    std::shared_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
     auto it = g_PersonalityPrompts.find(personality);
     if (it != g_PersonalityPrompts.end())
         return it->second;
@@ -96,19 +98,20 @@ bool SetBotPersonality(Player* bot, const std::string& personality)
     
     uint64_t botGuid = bot->GetGUID().GetRawValue();
     
-    // Check if personality exists
-    if (g_PersonalityPrompts.find(personality) == g_PersonalityPrompts.end() && personality != "default")
     {
-        return false;
+        std::unique_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
+
+        // Check if personality exists
+        if (g_PersonalityPrompts.find(personality) == g_PersonalityPrompts.end() && personality != "default")
+        {
+            return false;
+        }
+
+        // Update in memory; the database follows with the next batched save
+        g_BotPersonalityList[botGuid] = personality;
+        QueueBotPersonalityWrite(botGuid, personality);
     }
     
-    // Update in memory
-    g_BotPersonalityList[botGuid] = personality;
-    
-    // Update in database
-    CharacterDatabase.Execute("REPLACE INTO mod_ollama_chat_personality (guid, personality) VALUES ({}, '{}')", 
-                             botGuid, personality);
-    
     if(g_DebugEnabled)
     {
         LOG_INFO("server.loading", "[Ollama Chat] Set personality '{}' for bot {}", personality, bot->GetName());
@@ -117,8 +120,96 @@ bool SetBotPersonality(Player* bot, const std::string& personality)
     return true;
 }
 
+void SetStoredBotPersonalities(const std::vector<std::pair<uint64_t, std::string>>& stored)
+{
+    std::unique_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
+    std::lock_guard<std::mutex> writeLock(personalityWriteMutex);
+    for (const auto& [botGuid, personality] : stored)
+    {
+        // A queued assignment is newer than the stored row
+        if (!pendingPersonalityWrites.count(botGuid))
+            g_BotPersonalityList[botGuid] = personality;
+    }
+}
+
+// Returns false if the commit failed
+static bool WriteBotPersonalities(const std::map<uint64_t, std::string>& personalities)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    BatchedStatementWriter upserts(trans,
+        "INSERT INTO mod_ollama_chat_personality (guid, personality) VALUES ",
+        " ON DUPLICATE KEY UPDATE personality = VALUES(personality)");
+
+    for (const auto& [botGuid, personality] : personalities)
+    {
+        std::string escPersonality = personality;
+        CharacterDatabase.EscapeString(escPersonality);
+        upserts.AddRow(SafeFormat("({}, '{}')", botGuid, escPersonality));
+    }
+    upserts.Flush();
+    if (!CommitTransactionAndWait(trans))
+    {
+        LOG_ERROR("server.loading", "[Ollama Chat] Saving {} bot personalities failed.", personalities.size());
+        return false;
+    }
+
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    RecordDatabaseSave(DB_SAVE_PERSONALITY, upserts.Rows(), upserts.Statements(), micros);
+    return true;
+}
+
+static std::map<uint64_t, std::string> TakePendingBotPersonalities()
+{
+    std::map<uint64_t, std::string> personalities;
+    std::lock_guard<std::mutex> lock(personalityWriteMutex);
+    personalities.swap(pendingPersonalityWrites);
+    return personalities;
+}
+
+// Puts back the assignments of a failed save; one queued since for the same bot is newer
+static void RequeueBotPersonalities(const std::map<uint64_t, std::string>& personalities)
+{
+    std::lock_guard<std::mutex> lock(personalityWriteMutex);
+    pendingPersonalityWrites.insert(personalities.begin(), personalities.end());
+}
+
+void SaveBotPersonalitiesToDB()
+{
+    if (personalitySaveRunning.exchange(true))
+        return;
+
+    std::map<uint64_t, std::string> personalities = TakePendingBotPersonalities();
+    if (personalities.empty())
+    {
+        personalitySaveRunning = false;
+        return;
+    }
+
+    std::thread([personalities = std::move(personalities)]() {
+        if (!WriteBotPersonalities(personalities))
+            RequeueBotPersonalities(personalities);
+        personalitySaveRunning = false;
+    }).detach();
+}
+
+void FlushBotPersonalitiesToDB()
+{
+    // The detached save owns the flag until its commit returns; a failed one requeues
+    // its rows before clearing it, so they are written below
+    while (personalitySaveRunning.exchange(true))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::map<uint64_t, std::string> personalities = TakePendingBotPersonalities();
+    if (!personalities.empty() && !WriteBotPersonalities(personalities))
+        RequeueBotPersonalities(personalities);
+    personalitySaveRunning = false;
+}
+
 std::vector<std::string> GetAllPersonalityKeys()
 {
+    std::shared_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
     return g_PersonalityKeys;
 }
 
@@ -126,12 +217,16 @@ bool PersonalityExists(const std::string& personality)
 {
     if (personality == "default")
         return true;
+    std::shared_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
     return g_PersonalityPrompts.find(personality) != g_PersonalityPrompts.end();
 }
 
 void ClearAllBotPersonalities()
 {
-    g_BotPersonalityList.clear();
+    {
+        std::unique_lock<std::shared_mutex> lock(g_BotPersonalityMutex);
+        g_BotPersonalityList.clear();
+    }
     if(g_DebugEnabled)
     {
         LOG_INFO("server.loading", "[Ollama Chat] Cleared all bot personality assignments due to RP personalities being disabled");
@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <string>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 class Player; // forward declaration
@@ -16,9 +17,21 @@ std::string GetBotPersonality(Player* bot);
 // Falls back to a default if not found.
 std::string GetPersonalityPromptAddition(const std::string& type);
 
-// Set a bot's personality manually (saves to database)
+// Set a bot's personality manually (saved with the next batched save)
 bool SetBotPersonality(Player* bot, const std::string& personality);
 
+// Store the assignments read from mod_ollama_chat_personality. Bots with an assignment
+// that is not written yet keep it, as it is newer than their row.
+void SetStoredBotPersonalities(const std::vector<std::pair<uint64_t, std::string>>& stored);
+
+// Write the assignments made since the last save from a worker thread. Does nothing
+// while the previous save is still running; its assignments go out with the next one.
+void SaveBotPersonalitiesToDB();
+
+// Like SaveBotPersonalitiesToDB, but waits for a running save to finish and then writes
+// the rest of the queue on the calling thread; used at shutdown.
+void FlushBotPersonalitiesToDB();
+
 // Get all available personality keys
 std::vector<std::string> GetAllPersonalityKeys();
 
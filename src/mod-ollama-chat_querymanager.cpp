@@ -15,7 +15,7 @@ void QueryManager::setMaxConcurrentQueries(int maxQueries) {
 }
 
 // Submit a query and return a future for the result.
-std::future<std::string> QueryManager::submitQuery(const std::string& prompt) {
+std::future<std::string> QueryManager::submitQuery(const OllamaRequest& request) {
     std::promise<std::string> promise;
     std::future<std::string> future = promise.get_future();
 
@@ -27,20 +27,20 @@ std::future<std::string> QueryManager::submitQuery(const std::string& prompt) {
             ++currentQueries;
             shouldRunNow = true;
         } else {
-            taskQueue.push({ prompt, std::move(promise) });
+            taskQueue.push({ request, std::move(promise) });
         }
     }
 
     if (shouldRunNow) {
-        std::thread(&QueryManager::processQuery, this, prompt, std::move(promise)).detach();
+        std::thread(&QueryManager::processQuery, this, request, std::move(promise)).detach();
     }
 
     return future;
 }
 
 // Process the query by calling the API and then handling any queued tasks.
-void QueryManager::processQuery(const std::string& prompt, std::promise<std::string> promise) {
-    std::string result = QueryOllamaAPI(prompt);
+void QueryManager::processQuery(const OllamaRequest& request, std::promise<std::string> promise) {
+    std::string result = QueryOllamaAPI(request);
     promise.set_value(result);
 
     {
@@ -50,7 +50,7 @@ void QueryManager::processQuery(const std::string& prompt, std::promise<std::str
             QueryTask task = std::move(taskQueue.front());
             taskQueue.pop();
             ++currentQueries;
-            std::thread(&QueryManager::processQuery, this, task.prompt, std::move(task.promise)).detach();
+            std::thread(&QueryManager::processQuery, this, task.request, std::move(task.promise)).detach();
         }
     }
 }
@@ -1,27 +1,50 @@
 #ifndef MOD_OLLAMA_CHAT_QUERYMANAGER_H
 #define MOD_OLLAMA_CHAT_QUERYMANAGER_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <future>
+#include <utility>
+#include <vector>
 #include <mutex>
 #include <queue>
 #include <thread>
 
+// One generate request. The system text is sent in Ollama's "system" field after
+// OllamaChat.SystemPrompt; keeping it identical between calls lets the server reuse
+// the already-evaluated prefix of the prompt.
+struct OllamaRequest {
+    std::string prompt;
+    std::string system;
+
+    // Conversation the request belongs to; 0 for one-off prompts such as event chatter
+    uint64_t botGuid = 0;
+    uint64_t playerGuid = 0;
+
+    // OllamaChat.ApiBackend = chat: earlier (player message, bot reply) turns, oldest first
+    std::vector<std::pair<std::string, std::string>> history;
+
+    // OllamaChat.ApiBackend = context: tokens returned by the previous turn, null to start fresh
+    std::shared_ptr<const std::vector<int>> context;
+};
+
 std::string QueryOllamaAPI(const std::string& prompt);
+std::string QueryOllamaAPI(const OllamaRequest& request);
 
 class QueryManager {
 public:
     QueryManager();
     void setMaxConcurrentQueries(int maxQueries);
-    std::future<std::string> submitQuery(const std::string& prompt);
+    std::future<std::string> submitQuery(const OllamaRequest& request);
 
 private:
     struct QueryTask {
-        std::string prompt;
+        OllamaRequest request;
         std::promise<std::string> promise;
     };
 
-    void processQuery(const std::string& prompt, std::promise<std::string> promise);
+    void processQuery(const OllamaRequest& request, std::promise<std::string> promise);
 
     int maxConcurrentQueries; // 0 means no limit
     int currentQueries;
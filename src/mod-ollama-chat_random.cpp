@@ -12,6 +12,13 @@
 #include "mod-ollama-chat_api.h"
 #include "mod-ollama-chat_personality.h"
 #include "mod-ollama-chat-utilities.h"
+#include "mod-ollama-chat_admission.h"
+#include "mod-ollama-chat_events.h"
+#include "mod-ollama-chat_cooldown.h"
+#include "mod-ollama-chat_spellcache.h"
+#include "mod-ollama-chat_snapshot.h"
+#include "mod-ollama-chat_history.h"
+#include "mod-ollama-chat_journal.h"
 #include "GridNotifiersImpl.h"
 #include "CellImpl.h"
 #include "Map.h"
@@ -21,6 +28,9 @@
 #include <random>
 #include <thread>
 #include <ctime>
+#include <algorithm>
+#include <chrono>
+#include <queue>
 #include "Item.h"
 #include "Bag.h"
 #include "SpellMgr.h"
@@ -30,14 +40,359 @@
 
 OllamaBotRandomChatter::OllamaBotRandomChatter() : WorldScript("OllamaBotRandomChatter") {}
 
-std::unordered_map<uint64_t, time_t> nextRandomChatTime;
+// Quest level -> zone area IDs that have quests of that level (deduplicated).
+// Built once at startup; quest templates do not change while the server runs.
+static std::vector<std::vector<uint32>> questAreasByLevel;
+
+static void BuildQuestAreaIndex()
+{
+    questAreasByLevel.clear();
+    size_t areaCount = 0;
+    for (auto const& qkv : sObjectMgr->GetQuestTemplates())
+    {
+        Quest const* qt = qkv.second;
+        if (!qt) continue;
+        int32 qlevel = qt->GetQuestLevel();
+        int32 zone = qt->GetZoneOrSort();
+        // Level -1 quests scale with the player and negative zones are quest sorts, not areas
+        if (qlevel <= 0 || zone <= 0)
+            continue;
+        if (!sAreaTableStore.LookupEntry(zone))
+            continue;
+
+        if (questAreasByLevel.size() <= static_cast<size_t>(qlevel))
+            questAreasByLevel.resize(qlevel + 1);
+        std::vector<uint32>& areas = questAreasByLevel[qlevel];
+        if (std::find(areas.begin(), areas.end(), static_cast<uint32>(zone)) == areas.end())
+        {
+            areas.push_back(zone);
+            ++areaCount;
+        }
+    }
+
+    LOG_INFO("server.loading", "[Ollama Chat] Built quest area index: {} level/area entries over {} levels",
+             areaCount, questAreasByLevel.size());
+}
+
+// Picks a quest area within two levels of the bot, weighted by how many areas each level has
+static AreaTableEntry const* PickQuestAreaForLevel(uint32 level)
+{
+    int32 minLevel = std::max<int32>(1, static_cast<int32>(level) - 2);
+    int32 maxLevel = std::min<int32>(static_cast<int32>(questAreasByLevel.size()) - 1, static_cast<int32>(level) + 2);
+
+    size_t total = 0;
+    for (int32 l = minLevel; l <= maxLevel; ++l)
+        total += questAreasByLevel[l].size();
+    if (total == 0)
+        return nullptr;
+
+    size_t pick = urand(0, total - 1);
+    for (int32 l = minLevel; l <= maxLevel; ++l)
+    {
+        const std::vector<uint32>& areas = questAreasByLevel[l];
+        if (pick < areas.size())
+            return sAreaTableStore.LookupEntry(areas[pick]);
+        pick -= areas.size();
+    }
+    return nullptr;
+}
+
+// --------------------------------------------
+// Environment comment generators
+// Random chatter picks a category by weight first and only then runs that
+// category's world query and formats a single comment. A generator returns an
+// empty string when the bot has nothing to say about its category, and the
+// next category is drawn from the remaining weight.
+// --------------------------------------------
+enum EnvCommentCategory
+{
+    ENV_COMMENT_CREATURE         = 0,
+    ENV_COMMENT_GAMEOBJECT       = 1,
+    ENV_COMMENT_EQUIPPED_ITEM    = 2,
+    ENV_COMMENT_SPELL            = 3,
+    ENV_COMMENT_QUEST_AREA       = 4,
+    ENV_COMMENT_VENDOR           = 5,
+    ENV_COMMENT_QUESTGIVER       = 6,
+    ENV_COMMENT_BAG_SLOTS        = 7,
+    ENV_COMMENT_DUNGEON          = 8,
+    ENV_COMMENT_UNFINISHED_QUEST = 9,
+    ENV_COMMENT_GUILD            = 10,
+    ENV_COMMENT_COUNT
+};
+
+static std::string PickEnvTemplate(const std::vector<std::string>& templates)
+{
+    return templates.size() == 1 ? templates[0] : templates[urand(0, templates.size() - 1)];
+}
+
+static std::string GenerateCreatureComment(Player* bot)
+{
+    Unit* unitInRange = nullptr;
+    Acore::AnyUnitInObjectRangeCheck creatureCheck(bot, g_SayDistance);
+    Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> creatureSearcher(bot, unitInRange, creatureCheck);
+    Cell::VisitObjects(bot, creatureSearcher, g_SayDistance);
+    if (!unitInRange || unitInRange->GetTypeId() != TYPEID_UNIT)
+        return "";
+    return SafeFormat(PickEnvTemplate(g_EnvCommentCreature), fmt::arg("creature_name", unitInRange->ToCreature()->GetName()));
+}
+
+static std::string GenerateGameObjectComment(Player* bot)
+{
+    Acore::GameObjectInRangeCheck goCheck(bot->GetPositionX(), bot->GetPositionY(), bot->GetPositionZ(), g_SayDistance);
+    GameObject* goInRange = nullptr;
+    Acore::GameObjectSearcher<Acore::GameObjectInRangeCheck> goSearcher(bot, goInRange, goCheck);
+    Cell::VisitObjects(bot, goSearcher, g_SayDistance);
+    if (!goInRange)
+        return "";
+    return SafeFormat(PickEnvTemplate(g_EnvCommentGameObject), fmt::arg("object_name", goInRange->GetName()));
+}
+
+static std::string GenerateEquippedItemComment(Player* bot)
+{
+    std::vector<Item*> equippedItems;
+    for (uint8_t slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; ++slot)
+        if (Item* item = bot->GetItemByPos(slot))
+            equippedItems.push_back(item);
+
+    if (equippedItems.empty())
+        return "";
+
+    uint32_t eqIdx = equippedItems.size() == 1 ? 0 : urand(0, equippedItems.size() - 1);
+    Item* randomEquipped = equippedItems[eqIdx];
+    return SafeFormat(PickEnvTemplate(g_EnvCommentEquippedItem), fmt::arg("item_name", randomEquipped->GetTemplate()->Name1));
+}
+
+static std::string GenerateSpellComment(Player* bot)
+{
+    std::shared_ptr<const BotSpellDigest> digest = GetBotSpellDigest(bot);
+    std::vector<bool> onCooldown = GetBotSpellCooldownMask(bot, *digest);
+
+    std::vector<const BotSpellDigestEntry*> validSpells;
+    for (size_t i = 0; i < digest->spells.size(); ++i)
+    {
+        if (!onCooldown[i] && !digest->spells[i].effectText.empty())
+            validSpells.push_back(&digest->spells[i]);
+    }
+
+    if (validSpells.empty())
+        return "";
+
+    uint32_t spellIdx = validSpells.size() == 1 ? 0 : urand(0, validSpells.size() - 1);
+    const BotSpellDigestEntry& randomSpell = *validSpells[spellIdx];
+    return SafeFormat(
+        PickEnvTemplate(g_EnvCommentSpell),
+        fmt::arg("spell_name", randomSpell.name),
+        fmt::arg("spell_effect", randomSpell.effectText),
+        fmt::arg("spell_cost", randomSpell.costText)
+    );
+}
+
+static std::string GenerateQuestAreaComment(Player* bot)
+{
+    AreaTableEntry const* area = PickQuestAreaForLevel(bot->GetLevel());
+    if (!area)
+        return "";
+    return SafeFormat(PickEnvTemplate(g_EnvCommentQuestArea), fmt::arg("quest_area", area->area_name[LocaleConstant::LOCALE_enUS]));
+}
+
+static std::string GenerateVendorComment(Player* bot)
+{
+    Unit* unit = nullptr;
+    Acore::AnyUnitInObjectRangeCheck check(bot, g_SayDistance);
+    Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> searcher(bot, unit, check);
+    Cell::VisitObjects(bot, searcher, g_SayDistance);
+
+    if (!unit || unit->GetTypeId() != TYPEID_UNIT)
+        return "";
+    Creature* vendor = unit->ToCreature();
+    if (!vendor->HasNpcFlag(UNIT_NPC_FLAG_VENDOR))
+        return "";
+    return SafeFormat(PickEnvTemplate(g_EnvCommentVendor), fmt::arg("vendor_name", vendor->GetName()));
+}
+
+static std::string GenerateQuestgiverComment(Player* bot)
+{
+    Unit* unit = nullptr;
+    Acore::AnyUnitInObjectRangeCheck check(bot, g_SayDistance);
+    Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> searcher(bot, unit, check);
+    Cell::VisitObjects(bot, searcher, g_SayDistance);
+
+    if (!unit || unit->GetTypeId() != TYPEID_UNIT)
+        return "";
+    Creature* giver = unit->ToCreature();
+    if (!giver->HasNpcFlag(UNIT_NPC_FLAG_QUESTGIVER))
+        return "";
+
+    auto bounds = sObjectMgr->GetCreatureQuestRelationBounds(giver->GetEntry());
+    int n       = std::distance(bounds.first, bounds.second);
+    return SafeFormat(PickEnvTemplate(g_EnvCommentQuestgiver),
+        fmt::arg("questgiver_name", giver->GetName()),
+        fmt::arg("quest_count", n)
+    );
+}
+
+static std::string GenerateBagSlotsComment(Player* bot)
+{
+    int freeSlots = 0;
+    for (uint8 i = INVENTORY_SLOT_ITEM_START; i < INVENTORY_SLOT_ITEM_END; ++i)
+        if (!bot->GetItemByPos(i))
+            ++freeSlots;
+    for (uint8 b = INVENTORY_SLOT_BAG_START; b < INVENTORY_SLOT_BAG_END; ++b)
+        if (Bag* bag = bot->GetBagByPos(b))
+            freeSlots += bag->GetFreeSlots();
+
+    return SafeFormat(PickEnvTemplate(g_EnvCommentBagSlots), fmt::arg("bag_slots", freeSlots));
+}
+
+static std::string GenerateDungeonComment(Player* bot)
+{
+    if (!bot->GetMap() || !bot->GetMap()->IsDungeon())
+        return "";
+    std::string name = bot->GetMap()->GetMapName();
+    return SafeFormat(PickEnvTemplate(g_EnvCommentDungeon), fmt::arg("dungeon_name", name));
+}
+
+static std::string GenerateUnfinishedQuestComment(Player* bot)
+{
+    std::vector<Quest const*> unfinished;
+    for (auto const& qs : bot->getQuestStatusMap())
+    {
+        if (qs.second.Status == QUEST_STATUS_INCOMPLETE)
+            if (auto* qt = sObjectMgr->GetQuestTemplate(qs.first))
+                unfinished.push_back(qt);
+    }
+    if (unfinished.empty())
+        return "";
+
+    uint32_t uIdx = unfinished.size() == 1 ? 0 : urand(0, unfinished.size() - 1);
+    return SafeFormat(PickEnvTemplate(g_EnvCommentUnfinishedQuest), fmt::arg("quest_name", unfinished[uIdx]->GetTitle()));
+}
+
+// Guild comments: pick one guild sub-category that has data, then format only it
+static std::string GenerateGuildComment(Player* bot)
+{
+    Guild* guild = bot->GetGuild();
+    if (!guild)
+        return "";
+
+    enum GuildTopic { TOPIC_MEMBER, TOPIC_MOTD, TOPIC_BANK, TOPIC_STATIC };
+    std::vector<std::pair<GuildTopic, const std::vector<std::string>*>> topics;
+    if (!g_GuildEnvCommentGuildMember.empty())
+        topics.emplace_back(TOPIC_MEMBER, &g_GuildEnvCommentGuildMember);
+    if (!g_GuildEnvCommentGuildMOTD.empty() && !guild->GetMOTD().empty())
+        topics.emplace_back(TOPIC_MOTD, &g_GuildEnvCommentGuildMOTD);
+    if (!g_GuildEnvCommentGuildBank.empty())
+        topics.emplace_back(TOPIC_BANK, &g_GuildEnvCommentGuildBank);
+    for (const std::vector<std::string>* pool : { &g_GuildEnvCommentGuildRaid, &g_GuildEnvCommentGuildEndgame,
+                                                  &g_GuildEnvCommentGuildStrategy, &g_GuildEnvCommentGuildGroup,
+                                                  &g_GuildEnvCommentGuildPvP, &g_GuildEnvCommentGuildCommunity })
+    {
+        if (!pool->empty())
+            topics.emplace_back(TOPIC_STATIC, pool);
+    }
+    if (topics.empty())
+        return "";
+
+    const auto& [topic, pool] = topics[topics.size() == 1 ? 0 : urand(0, topics.size() - 1)];
+    std::string templ = PickEnvTemplate(*pool);
+    switch (topic)
+    {
+        case TOPIC_MEMBER: return SafeFormat(templ, fmt::arg("member_name", bot->GetName()));
+        case TOPIC_MOTD:   return SafeFormat(templ, fmt::arg("guild_motd", guild->GetMOTD()));
+        case TOPIC_BANK:   return SafeFormat(templ, fmt::arg("bank_gold", guild->GetTotalBankMoney() / 10000));
+        default:           return templ;
+    }
+}
+
+struct EnvCommentGenerator
+{
+    const char* name;                            // Key in OllamaChat.EnvCommentWeights
+    uint32_t defaultWeight;
+    const std::vector<std::string>* templates;   // Category is skipped when it has no templates
+    std::string (*generate)(Player* bot);
+};
+
+// Default weights match how often each category used to appear in the candidate list
+static const EnvCommentGenerator envCommentGenerators[ENV_COMMENT_COUNT] =
+{
+    { "creature",         1, &g_EnvCommentCreature,        GenerateCreatureComment },
+    { "gameobject",       1, &g_EnvCommentGameObject,      GenerateGameObjectComment },
+    { "equipped_item",    1, &g_EnvCommentEquippedItem,    GenerateEquippedItemComment },
+    { "spell",            2, &g_EnvCommentSpell,           GenerateSpellComment },
+    { "quest_area",       1, &g_EnvCommentQuestArea,       GenerateQuestAreaComment },
+    { "vendor",           2, &g_EnvCommentVendor,          GenerateVendorComment },
+    { "questgiver",       2, &g_EnvCommentQuestgiver,      GenerateQuestgiverComment },
+    { "bag_slots",        2, &g_EnvCommentBagSlots,        GenerateBagSlotsComment },
+    { "dungeon",          2, &g_EnvCommentDungeon,         GenerateDungeonComment },
+    { "unfinished_quest", 2, &g_EnvCommentUnfinishedQuest, GenerateUnfinishedQuestComment },
+    { "guild",            9, nullptr,                      GenerateGuildComment },
+};
+
+static std::string GenerateEnvironmentComment(Player* bot, bool allowGuildComment)
+{
+    uint32_t weights[ENV_COMMENT_COUNT];
+    uint32_t totalWeight = 0;
+    for (uint32_t i = 0; i < ENV_COMMENT_COUNT; ++i)
+    {
+        const EnvCommentGenerator& generator = envCommentGenerators[i];
+        auto it = g_EnvCommentWeights.find(generator.name);
+        uint32_t weight = it != g_EnvCommentWeights.end() ? it->second : generator.defaultWeight;
+        if (generator.templates && generator.templates->empty())
+            weight = 0;
+        if (i == ENV_COMMENT_GUILD && !allowGuildComment)
+            weight = 0;
+        weights[i] = weight;
+        totalWeight += weight;
+    }
+
+    while (totalWeight > 0)
+    {
+        uint32_t roll = urand(0, totalWeight - 1);
+        uint32_t category = 0;
+        while (roll >= weights[category])
+            roll -= weights[category++];
+
+        std::string comment = envCommentGenerators[category].generate(bot);
+        if (!comment.empty())
+            return comment;
+
+        // Nothing to say about this category; draw again from what is left
+        totalWeight -= weights[category];
+        weights[category] = 0;
+    }
+    return "";
+}
+
+void OllamaBotRandomChatter::OnStartup()
+{
+    BuildQuestAreaIndex();
+}
+
+// Bot GUID -> next time the bot may chatter. Entries are kept for MaxRandomInterval past
+// their deadline so a due bot survives until it is evaluated, then expire if the bot is gone.
+static CooldownStore nextRandomChatTime;
+
+// Bots ordered by the time their random chatter is next due, earliest first.
+// An entry is stale once nextRandomChatTime holds a different deadline for its GUID.
+// Only touched from the world thread.
+typedef std::pair<time_t, uint64_t> RandomChatterSlot;
+static std::priority_queue<RandomChatterSlot, std::vector<RandomChatterSlot>, std::greater<RandomChatterSlot>> randomChatterQueue;
+
+// Delay before a due bot that could not chatter (no real player near, failed roll, no budget) is evaluated again
+static constexpr time_t RANDOM_CHATTER_RETRY_SECONDS = 30;
+
+// How often personality assignments queued by replies are written
+static constexpr time_t PERSONALITY_SAVE_INTERVAL_SECONDS = 5;
 
 void OllamaBotRandomChatter::OnUpdate(uint32 diff)
 {
     if (!g_Enable)
         return;
 
-    if (g_ConversationHistorySaveInterval > 0)
+    // With the journal on, the persistence thread drains the saves continuously
+    bool intervalSaves = !IsPersistenceJournalRunning();
+
+    if (intervalSaves && g_ConversationHistorySaveInterval > 0)
     {
         time_t now = time(nullptr);
         if (difftime(now, g_LastHistorySaveTime) >= g_ConversationHistorySaveInterval * 60)
@@ -47,8 +402,26 @@ void OllamaBotRandomChatter::OnUpdate(uint32 diff)
         }
     }
 
+    // New personality assignments are written in batches off the world thread
+    static time_t lastPersonalitySave = 0;
+    {
+        time_t now = time(nullptr);
+        if (difftime(now, lastPersonalitySave) >= PERSONALITY_SAVE_INTERVAL_SECONDS)
+        {
+            SaveBotPersonalitiesToDB();
+            lastPersonalitySave = now;
+        }
+    }
+
+    // Dispatch kill/loot events whose coalescing window has closed
+    FlushCoalescedGameEvents();
+
+    // Refresh snapshot sections that were served stale on the reply path
+    if (g_EnableChatBotSnapshotTemplate && g_EnableSnapshotCache)
+        RefreshStaleSnapshotSections();
+
     // Save sentiment data periodically
-    if (g_EnableSentimentTracking && g_SentimentSaveInterval > 0)
+    if (intervalSaves && g_EnableSentimentTracking && g_SentimentSaveInterval > 0)
     {
         time_t now = time(nullptr);
         if (difftime(now, g_LastSentimentSaveTime) >= g_SentimentSaveInterval * 60)
@@ -61,26 +434,63 @@ void OllamaBotRandomChatter::OnUpdate(uint32 diff)
     if (!g_EnableRandomChatter)
         return;
 
+    // Picking up bots that logged in is cheap; evaluating them is spread over ticks below
     static uint32_t timer = 0;
     if (timer <= diff)
     {
         timer = 30000;
-        if (g_DebugEnabled)
-            LOG_INFO("server.loading", "[Ollama Chat] RandomChatter tick fired (HandleRandomChatter called)");
-        HandleRandomChatter();
+        ScheduleRandomChatterBots();
     }
     else
     {
         timer -= diff;
     }
+
+    ProcessDueRandomChatter();
+}
+
+void OllamaBotRandomChatter::ScheduleRandomChatterBots()
+{
+    // Keep entries alive across a retry even if MaxRandomInterval is short
+    nextRandomChatTime.SetRetention(std::max<uint32_t>(g_MaxRandomInterval, RANDOM_CHATTER_RETRY_SECONDS * 2));
+
+    time_t now = time(nullptr);
+    uint32_t added = 0;
+    for (auto const& itr : ObjectAccessor::GetPlayers())
+    {
+        Player* bot = itr.second;
+        if (!bot->IsInWorld() || !sPlayerbotsMgr->GetPlayerbotAI(bot))
+            continue;
+
+        uint64_t guid = bot->GetGUID().GetRawValue();
+        if (nextRandomChatTime.Get(guid))
+            continue;
+
+        time_t nextChatTime = now + urand(g_MinRandomInterval, g_MaxRandomInterval);
+        nextRandomChatTime.Set(guid, nextChatTime);
+        randomChatterQueue.emplace(nextChatTime, guid);
+        ++added;
+    }
+
+    if (g_DebugEnabled && added > 0)
+        LOG_INFO("server.loading", "[Ollama Chat] Random chatter scheduled {} new bots ({} queued).", added, randomChatterQueue.size());
 }
 
-void OllamaBotRandomChatter::HandleRandomChatter()
+void OllamaBotRandomChatter::ProcessDueRandomChatter()
 {
-    auto const& allPlayers = ObjectAccessor::GetPlayers();
+    time_t now = time(nullptr);
+    if (randomChatterQueue.empty() || randomChatterQueue.top().first > now)
+        return;
+
+    auto tickStart = std::chrono::steady_clock::now();
+    auto elapsedUs = [&tickStart]()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - tickStart).count());
+    };
 
     std::vector<Player*> realPlayers;
-    for (auto const& itr : allPlayers)
+    for (auto const& itr : ObjectAccessor::GetPlayers())
     {
         Player* player = itr.second;
         if (!player->IsInWorld()) continue;
@@ -88,809 +498,246 @@ void OllamaBotRandomChatter::HandleRandomChatter()
             realPlayers.push_back(player);
     }
 
-    std::unordered_set<uint64_t> processedBotsThisTick;
-
-    for (auto const& itr : allPlayers)
+    uint32_t evaluated = 0;
+    while (!randomChatterQueue.empty() && randomChatterQueue.top().first <= now)
     {
-        Player* bot = itr.second;
-        PlayerbotAI* ai = sPlayerbotsMgr->GetPlayerbotAI(bot);
-        if (!ai) continue;
-        if (!bot->IsInWorld() || bot->IsBeingTeleported()) continue;
-        if (processedBotsThisTick.count(bot->GetGUID().GetRawValue())) continue;
-
-        // If bot is in a guild, check if any real player from their guild is online
-        bool hasRealPlayerInGuild = false;
-        Guild* guild = bot->GetGuild();
-        if (guild)
-        {
-            for (auto const& pair : ObjectAccessor::GetPlayers())
-            {
-                Player* player = pair.second;
-                if (!player || !player->IsInWorld())
-                    continue;
-                if (sPlayerbotsMgr->GetPlayerbotAI(player))
-                    continue;
-                if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
-                {
-                    hasRealPlayerInGuild = true;
-                    break;
-                }
-            }
-        }
+        if (g_RandomChatterMaxBotsPerTick > 0 && evaluated >= g_RandomChatterMaxBotsPerTick)
+            break;
+        if (g_RandomChatterTickBudgetUs > 0 && evaluated > 0 && elapsedUs() >= g_RandomChatterTickBudgetUs)
+            break;
 
-        // For non-guild random chatter, require proximity to a real player, unless in guild with real player and flag is checked
-        bool nearRealPlayer = false;
-        for (Player* realPlayer : realPlayers)
-        {
-            if (bot->GetDistance(realPlayer) <= g_RandomChatterRealPlayerDistance)
-            {
-                nearRealPlayer = true;
-                break;
-            }
-        }
+        RandomChatterSlot slot = randomChatterQueue.top();
+        randomChatterQueue.pop();
 
-        bool allowWithoutProximity = g_RestrictBotsToPartyMembers && guild && hasRealPlayerInGuild;
-        if (!allowWithoutProximity && !nearRealPlayer)
+        uint64_t guid = slot.second;
+        time_t nextChatTime = 0;
+        if (!nextRandomChatTime.Get(guid, &nextChatTime) || nextChatTime != slot.first)
             continue;
 
-        // Apply party restriction for random chatter
-        if (g_RestrictBotsToPartyMembers)
+        Player* bot = ObjectAccessor::FindPlayer(ObjectGuid(guid));
+        if (!bot)
         {
-            Group* botGroup = bot->GetGroup();
-            if (!botGroup || (botGroup->isRaidGroup() && !botGroup->isBGGroup()))
-            {
-                // Bot is not in a valid party, skip
-                continue;
-            }
-            
-            // Check if there's at least one real player in the group
-            bool hasRealPlayerInParty = false;
-            for (GroupReference* ref = botGroup->GetFirstMember(); ref; ref = ref->next())
-            {
-                Player* member = ref->GetSource();
-                if (member && !sPlayerbotsMgr->GetPlayerbotAI(member))
-                {
-                    hasRealPlayerInParty = true;
-                    break;
-                }
-            }
-            
-            if (!hasRealPlayerInParty)
-            {
-                // No real players in party, skip
-                continue;
-            }
+            nextRandomChatTime.Erase(guid);
+            continue;
         }
 
-            uint64_t guid = bot->GetGUID().GetRawValue();
-            processedBotsThisTick.insert(guid);
+        ++evaluated;
+        if (TryRandomChatter(bot, realPlayers))
+            nextChatTime = now + urand(g_MinRandomInterval, g_MaxRandomInterval);
+        else
+            nextChatTime = now + RANDOM_CHATTER_RETRY_SECONDS;
 
-            time_t now = time(nullptr);
+        nextRandomChatTime.Set(guid, nextChatTime);
+        randomChatterQueue.emplace(nextChatTime, guid);
+    }
 
-            if (nextRandomChatTime.find(guid) == nextRandomChatTime.end())
-            {
-                nextRandomChatTime[guid] = now + urand(g_MinRandomInterval, g_MaxRandomInterval);
-                continue;
-            }
+    if (g_DebugEnabled)
+        LOG_INFO("server.loading", "[Ollama Chat] Random chatter evaluated {} due bots in {}us ({} queued).",
+                 evaluated, elapsedUs(), randomChatterQueue.size());
+}
 
-            if (now < nextRandomChatTime[guid])
+bool OllamaBotRandomChatter::TryRandomChatter(Player* bot, std::vector<Player*> const& realPlayers)
+{
+    PlayerbotAI* ai = sPlayerbotsMgr->GetPlayerbotAI(bot);
+    if (!ai) return false;
+    if (!bot->IsInWorld() || bot->IsBeingTeleported()) return false;
+
+    // If bot is in a guild, check if any real player from their guild is online
+    bool hasRealPlayerInGuild = false;
+    Guild* guild = bot->GetGuild();
+    if (guild)
+    {
+        for (auto const& pair : ObjectAccessor::GetPlayers())
+        {
+            Player* player = pair.second;
+            if (!player || !player->IsInWorld())
                 continue;
-
-            if(urand(0, 99) > g_RandomChatterBotCommentChance)
+            if (sPlayerbotsMgr->GetPlayerbotAI(player))
                 continue;
-
-            std::string environmentInfo;
-            std::vector<std::string> candidateComments;
-            std::vector<std::string> guildComments;
-
-            // Creature
-            {
-                Unit* unitInRange = nullptr;
-                Acore::AnyUnitInObjectRangeCheck creatureCheck(bot, g_SayDistance);
-                Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> creatureSearcher(bot, unitInRange, creatureCheck);
-                Cell::VisitObjects(bot, creatureSearcher, g_SayDistance);
-                if (unitInRange && unitInRange->GetTypeId() == TYPEID_UNIT)
-                    if (!g_EnvCommentCreature.empty()) {
-                        uint32_t idx = g_EnvCommentCreature.size() == 1 ? 0 : urand(0, g_EnvCommentCreature.size() - 1);
-                        std::string templ = g_EnvCommentCreature[idx];
-                        candidateComments.push_back(SafeFormat(templ, fmt::arg("creature_name", unitInRange->ToCreature()->GetName())));
-                    }
-            }
-
-            // Game Object
-            {
-                Acore::GameObjectInRangeCheck goCheck(bot->GetPositionX(), bot->GetPositionY(), bot->GetPositionZ(), g_SayDistance);
-                GameObject* goInRange = nullptr;
-                Acore::GameObjectSearcher<Acore::GameObjectInRangeCheck> goSearcher(bot, goInRange, goCheck);
-                Cell::VisitObjects(bot, goSearcher, g_SayDistance);
-                if (goInRange)
-                {
-                    if (!g_EnvCommentGameObject.empty()) {
-                        uint32_t idx = g_EnvCommentGameObject.size() == 1 ? 0 : urand(0, g_EnvCommentGameObject.size() - 1);
-                        std::string templ = g_EnvCommentGameObject[idx];
-                        std::string gameObjectName = goInRange->GetName();
-                        candidateComments.push_back(SafeFormat(templ, fmt::arg("object_name", gameObjectName)));
-                    }
-                }
-            }
-
-            // Equipped Item
-            {
-                std::vector<Item*> equippedItems;
-                for (uint8_t slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; ++slot)
-                    if (Item* item = bot->GetItemByPos(slot))
-                        equippedItems.push_back(item);
-
-                if (!equippedItems.empty())
-                {
-                    uint32_t eqIdx = equippedItems.size() == 1 ? 0 : urand(0, equippedItems.size() - 1);
-                    Item* randomEquipped = equippedItems[eqIdx];
-                    if (!g_EnvCommentEquippedItem.empty()) {
-                        uint32_t tempIdx = g_EnvCommentEquippedItem.size() == 1 ? 0 : urand(0, g_EnvCommentEquippedItem.size() - 1);
-                        std::string templ = g_EnvCommentEquippedItem[tempIdx];
-                        candidateComments.push_back(SafeFormat(templ, fmt::arg("item_name", randomEquipped->GetTemplate()->Name1)));
-                    }
-                }
-            }
-
-            // Spell
-            {
-                struct NamedSpell
-                {
-                    uint32 id;
-                    std::string name;
-                    std::string effect;
-                    std::string cost;
-                };
-                std::vector<NamedSpell> validSpells;
-                for (const auto& spellPair : bot->GetSpellMap())
-                {
-                    uint32 spellId = spellPair.first;
-                    const SpellInfo* spellInfo = sSpellMgr->GetSpellInfo(spellId);
-                    if (!spellInfo) continue;
-                    if (spellInfo->Attributes & SPELL_ATTR0_PASSIVE)
-                        continue;
-                    if (spellInfo->SpellFamilyName == SPELLFAMILY_GENERIC)
-                        continue;
-                    if (bot->HasSpellCooldown(spellId))
-                        continue;
-
-                    std::string effectText;
-                    for (int i = 0; i < MAX_SPELL_EFFECTS; ++i)
-                    {
-                        if (!spellInfo->Effects[i].IsEffect())
-                            continue;
-                        switch (spellInfo->Effects[i].Effect)
-                        {
-                            case SPELL_EFFECT_SCHOOL_DAMAGE: effectText = "Deals damage"; break;
-                            case SPELL_EFFECT_HEAL: effectText = "Heals the target"; break;
-                            case SPELL_EFFECT_APPLY_AURA: effectText = "Applies an effect"; break;
-                            case SPELL_EFFECT_DISPEL: effectText = "Dispels magic"; break;
-                            case SPELL_EFFECT_THREAT: effectText = "Generates threat"; break;
-                            default: continue;
-                        }
-                        if (!effectText.empty())
-                            break;
-                    }
-                    if (effectText.empty())
-                        continue;
-
-                    const char* name = spellInfo->SpellName[0];
-                    if (!name || !*name)
-                        continue;
-
-                    std::string costText;
-                    if (spellInfo->ManaCost || spellInfo->ManaCostPercentage)
-                    {
-                        switch (spellInfo->PowerType)
-                        {
-                            case POWER_MANA: costText = std::to_string(spellInfo->ManaCost) + " mana"; break;
-                            case POWER_RAGE: costText = std::to_string(spellInfo->ManaCost) + " rage"; break;
-                            case POWER_FOCUS: costText = std::to_string(spellInfo->ManaCost) + " focus"; break;
-                            case POWER_ENERGY: costText = std::to_string(spellInfo->ManaCost) + " energy"; break;
-                            case POWER_RUNIC_POWER: costText = std::to_string(spellInfo->ManaCost) + " runic power"; break;
-                            default: costText = std::to_string(spellInfo->ManaCost) + " unknown resource"; break;
-                        }
-                    }
-                    else
-                    {
-                        costText = "no cost";
-                    }
-
-                    validSpells.push_back({spellId, name, effectText, costText});
-                }
-
-                if (!validSpells.empty())
-                {
-                    uint32_t spellIdx = validSpells.size() == 1 ? 0 : urand(0, validSpells.size() - 1);
-                    const NamedSpell& randomSpell = validSpells[spellIdx];
-                    if (!g_EnvCommentSpell.empty())
-                    {
-                        uint32_t tempIdx = g_EnvCommentSpell.size() == 1 ? 0 : urand(0, g_EnvCommentSpell.size() - 1);
-                        std::string templ = g_EnvCommentSpell[tempIdx];
-                        candidateComments.push_back(SafeFormat(
-                            templ,
-                            fmt::arg("spell_name", randomSpell.name),
-                            fmt::arg("spell_effect", randomSpell.effect),
-                            fmt::arg("spell_cost", randomSpell.cost)
-                        ));
-                    }
-                }
-            }
-
-            // Quest Area
-            {
-                std::vector<std::string> questAreas;
-                for (auto const& qkv : sObjectMgr->GetQuestTemplates())
-                {
-                    Quest const* qt = qkv.second;
-                    if (!qt) continue;
-                    int32 qlevel = qt->GetQuestLevel();
-                    int32 plevel = bot->GetLevel();
-                    if (qlevel < plevel - 2 || qlevel > plevel + 2)
-                        continue;
-                    uint32 zone = qt->GetZoneOrSort();
-                    if (zone == 0) continue;
-                    if (auto const* area = sAreaTableStore.LookupEntry(zone))
-                    {
-                        if (!g_EnvCommentQuestArea.empty()) {
-                            uint32_t idx = g_EnvCommentQuestArea.size() == 1 ? 0 : urand(0, g_EnvCommentQuestArea.size() - 1);
-                            std::string templ = g_EnvCommentQuestArea[idx];
-                            questAreas.push_back(SafeFormat(templ, fmt::arg("quest_area", area->area_name[LocaleConstant::LOCALE_enUS])));
-                        }
-                    }
-                }
-                if (!questAreas.empty())
-                {
-                    uint32_t qIdx = questAreas.size() == 1 ? 0 : urand(0, questAreas.size() - 1);
-                    candidateComments.push_back(questAreas[qIdx]);
-                }
-            }
-
-            // Vendor
-            {
-                Unit* unit = nullptr;
-                Acore::AnyUnitInObjectRangeCheck check(bot, g_SayDistance);
-                Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> searcher(bot, unit, check);
-                Cell::VisitObjects(bot, searcher, g_SayDistance);
-
-                if (unit && unit->GetTypeId() == TYPEID_UNIT)
-                {
-                    Creature* vendor = unit->ToCreature();
-                    if (vendor->HasNpcFlag(UNIT_NPC_FLAG_VENDOR))
-                    {
-                        if (!g_EnvCommentVendor.empty()) {
-                            uint32_t idx = g_EnvCommentVendor.size() == 1 ? 0 : urand(0, g_EnvCommentVendor.size() - 1);
-                            std::string templ = g_EnvCommentVendor[idx];
-                            candidateComments.push_back(SafeFormat(templ, fmt::arg("vendor_name", vendor->GetName())));
-                        }
-                    }
-                }
-            }
-
-            // Questgiver
-            {
-                Unit* unit = nullptr;
-                Acore::AnyUnitInObjectRangeCheck check(bot, g_SayDistance);
-                Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> searcher(bot, unit, check);
-                Cell::VisitObjects(bot, searcher, g_SayDistance);
-
-                if (unit && unit->GetTypeId() == TYPEID_UNIT)
-                {
-                    Creature* giver = unit->ToCreature();
-                    if (giver->HasNpcFlag(UNIT_NPC_FLAG_QUESTGIVER))
-                    {
-                        auto bounds = sObjectMgr->GetCreatureQuestRelationBounds(giver->GetEntry());
-                        int n       = std::distance(bounds.first, bounds.second);
-                        if (!g_EnvCommentQuestgiver.empty()) {
-                            uint32_t idx = g_EnvCommentQuestgiver.size() == 1 ? 0 : urand(0, g_EnvCommentQuestgiver.size() - 1);
-                            std::string templ = g_EnvCommentQuestgiver[idx];
-                            candidateComments.push_back(SafeFormat(templ,
-                                fmt::arg("questgiver_name", giver->GetName()),
-                                fmt::arg("quest_count", n)
-                            ));
-                        }
-                    }
-                }
-            }
-
-            // Free bag slots
-            {
-                int freeSlots = 0;
-                for (uint8 i = INVENTORY_SLOT_ITEM_START; i < INVENTORY_SLOT_ITEM_END; ++i)
-                    if (!bot->GetItemByPos(i))
-                        ++freeSlots;
-                for (uint8 b = INVENTORY_SLOT_BAG_START; b < INVENTORY_SLOT_BAG_END; ++b)
-                    if (Bag* bag = bot->GetBagByPos(b))
-                        freeSlots += bag->GetFreeSlots();
-
-                if (!g_EnvCommentBagSlots.empty()) {
-                    uint32_t idx = g_EnvCommentBagSlots.size() == 1 ? 0 : urand(0, g_EnvCommentBagSlots.size() - 1);
-                    std::string templ = g_EnvCommentBagSlots[idx];
-                    candidateComments.push_back(SafeFormat(templ, fmt::arg("bag_slots", freeSlots)));
-                }
-            }
-
-            // Dungeon
-            {
-                if (bot->GetMap() && bot->GetMap()->IsDungeon())
-                {
-                    std::string name = bot->GetMap()->GetMapName();
-                    if (!g_EnvCommentDungeon.empty()) {
-                        uint32_t idx = g_EnvCommentDungeon.size() == 1 ? 0 : urand(0, g_EnvCommentDungeon.size() - 1);
-                        std::string templ = g_EnvCommentDungeon[idx];
-                        candidateComments.push_back(SafeFormat(templ, fmt::arg("dungeon_name", name)));
-                    }
-                }
-            }
-
-            // Unfinished Quest
+            if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
             {
-                std::vector<std::string> unfinished;
-                for (auto const& qs : bot->getQuestStatusMap())
-                {
-                    if (qs.second.Status == QUEST_STATUS_INCOMPLETE)
-                    {
-                        if (auto* qt = sObjectMgr->GetQuestTemplate(qs.first))
-                            if (!g_EnvCommentUnfinishedQuest.empty()) {
-                                uint32_t idx = g_EnvCommentUnfinishedQuest.size() == 1 ? 0 : urand(0, g_EnvCommentUnfinishedQuest.size() - 1);
-                                std::string templ = g_EnvCommentUnfinishedQuest[idx];
-                                unfinished.push_back(SafeFormat(templ, fmt::arg("quest_name", qt->GetTitle())));
-                            }
-                    }
-                }
-                if (!unfinished.empty())
-                {
-                    uint32_t uIdx = unfinished.size() == 1 ? 0 : urand(0, unfinished.size() - 1);
-                    candidateComments.push_back(unfinished[uIdx]);
-                }
+                hasRealPlayerInGuild = true;
+                break;
             }
+        }
+    }
 
-            // Spell
-            {
-                struct NamedSpell
-                {
-                    uint32 id;
-                    std::string name;
-                    std::string effect;
-                    std::string cost;
-                };
-                std::vector<NamedSpell> validSpells;
-                for (const auto& spellPair : bot->GetSpellMap())
-                {
-                    uint32 spellId = spellPair.first;
-                    const SpellInfo* spellInfo = sSpellMgr->GetSpellInfo(spellId);
-                    if (!spellInfo) continue;
-                    if (spellInfo->Attributes & SPELL_ATTR0_PASSIVE)
-                        continue;
-                    if (spellInfo->SpellFamilyName == SPELLFAMILY_GENERIC)
-                        continue;
-                    if (bot->HasSpellCooldown(spellId))
-                        continue;
-
-                    std::string effectText;
-                    for (int i = 0; i < MAX_SPELL_EFFECTS; ++i)
-                    {
-                        if (!spellInfo->Effects[i].IsEffect())
-                            continue;
-                        switch (spellInfo->Effects[i].Effect)
-                        {
-                            case SPELL_EFFECT_SCHOOL_DAMAGE: effectText = "Deals damage"; break;
-                            case SPELL_EFFECT_HEAL: effectText = "Heals the target"; break;
-                            case SPELL_EFFECT_APPLY_AURA: effectText = "Applies an effect"; break;
-                            case SPELL_EFFECT_DISPEL: effectText = "Dispels magic"; break;
-                            case SPELL_EFFECT_THREAT: effectText = "Generates threat"; break;
-                            default: continue;
-                        }
-                        if (!effectText.empty())
-                            break;
-                    }
-                    if (effectText.empty())
-                        continue;
-
-                    const char* name = spellInfo->SpellName[0];
-                    if (!name || !*name)
-                        continue;
-
-                    std::string costText;
-                    if (spellInfo->ManaCost || spellInfo->ManaCostPercentage)
-                    {
-                        switch (spellInfo->PowerType)
-                        {
-                            case POWER_MANA: costText = std::to_string(spellInfo->ManaCost) + " mana"; break;
-                            case POWER_RAGE: costText = std::to_string(spellInfo->ManaCost) + " rage"; break;
-                            case POWER_FOCUS: costText = std::to_string(spellInfo->ManaCost) + " focus"; break;
-                            case POWER_ENERGY: costText = std::to_string(spellInfo->ManaCost) + " energy"; break;
-                            case POWER_RUNIC_POWER: costText = std::to_string(spellInfo->ManaCost) + " runic power"; break;
-                            default: costText = std::to_string(spellInfo->ManaCost) + " unknown resource"; break;
-                        }
-                    }
-                    else
-                    {
-                        costText = "no cost";
-                    }
-
-                    validSpells.push_back({spellId, name, effectText, costText});
-                }
+    // For non-guild random chatter, require proximity to a real player, unless in guild with real player and flag is checked
+    bool nearRealPlayer = false;
+    for (Player* realPlayer : realPlayers)
+    {
+        if (bot->GetDistance(realPlayer) <= g_RandomChatterRealPlayerDistance)
+        {
+            nearRealPlayer = true;
+            break;
+        }
+    }
 
-                if (!validSpells.empty())
-                {
-                    uint32_t spellIdx = validSpells.size() == 1 ? 0 : urand(0, validSpells.size() - 1);
-                    const NamedSpell& randomSpell = validSpells[spellIdx];
-                    if (!g_EnvCommentSpell.empty())
-                    {
-                        uint32_t tempIdx = g_EnvCommentSpell.size() == 1 ? 0 : urand(0, g_EnvCommentSpell.size() - 1);
-                        std::string templ = g_EnvCommentSpell[tempIdx];
-                        candidateComments.push_back(SafeFormat(
-                            templ,
-                            fmt::arg("spell_name", randomSpell.name),
-                            fmt::arg("spell_effect", randomSpell.effect),
-                            fmt::arg("spell_cost", randomSpell.cost)
-                        ));
-                    }
-                }
-            }
+    bool allowWithoutProximity = g_RestrictBotsToPartyMembers && guild && hasRealPlayerInGuild;
+    if (!allowWithoutProximity && !nearRealPlayer)
+        return false;
 
-            // Quest Area
+    // Apply party restriction for random chatter
+    if (g_RestrictBotsToPartyMembers)
+    {
+        Group* botGroup = bot->GetGroup();
+        if (!botGroup || (botGroup->isRaidGroup() && !botGroup->isBGGroup()))
+        {
+            // Bot is not in a valid party, skip
+            return false;
+        }
+        
+        // Check if there's at least one real player in the group
+        bool hasRealPlayerInParty = false;
+        for (GroupReference* ref = botGroup->GetFirstMember(); ref; ref = ref->next())
+        {
+            Player* member = ref->GetSource();
+            if (member && !sPlayerbotsMgr->GetPlayerbotAI(member))
             {
-                std::vector<std::string> questAreas;
-                for (auto const& qkv : sObjectMgr->GetQuestTemplates())
-                {
-                    Quest const* qt = qkv.second;
-                    if (!qt) continue;
-                    int32 qlevel = qt->GetQuestLevel();
-                    int32 plevel = bot->GetLevel();
-                    if (qlevel < plevel - 2 || qlevel > plevel + 2)
-                        continue;
-                    uint32 zone = qt->GetZoneOrSort();
-                    if (zone == 0) continue;
-                    if (auto const* area = sAreaTableStore.LookupEntry(zone))
-                    {
-                        if (!g_EnvCommentQuestArea.empty()) {
-                            uint32_t idx = g_EnvCommentQuestArea.size() == 1 ? 0 : urand(0, g_EnvCommentQuestArea.size() - 1);
-                            std::string templ = g_EnvCommentQuestArea[idx];
-                            questAreas.push_back(SafeFormat(templ, fmt::arg("quest_area", area->area_name[LocaleConstant::LOCALE_enUS])));
-                        }
-                    }
-                }
-                if (!questAreas.empty())
-                {
-                    uint32_t qIdx = questAreas.size() == 1 ? 0 : urand(0, questAreas.size() - 1);
-                    candidateComments.push_back(questAreas[qIdx]);
-                }
+                hasRealPlayerInParty = true;
+                break;
             }
+        }
+        
+        if (!hasRealPlayerInParty)
+        {
+            // No real players in party, skip
+            return false;
+        }
+    }
 
-            // Vendor
-            {
-                Unit* unit = nullptr;
-                Acore::AnyUnitInObjectRangeCheck check(bot, g_SayDistance);
-                Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> searcher(bot, unit, check);
-                Cell::VisitObjects(bot, searcher, g_SayDistance);
-
-                if (unit && unit->GetTypeId() == TYPEID_UNIT)
-                {
-                    Creature* vendor = unit->ToCreature();
-                    if (vendor->HasNpcFlag(UNIT_NPC_FLAG_VENDOR))
-                    {
-                        if (!g_EnvCommentVendor.empty()) {
-                            uint32_t idx = g_EnvCommentVendor.size() == 1 ? 0 : urand(0, g_EnvCommentVendor.size() - 1);
-                            std::string templ = g_EnvCommentVendor[idx];
-                            candidateComments.push_back(SafeFormat(templ, fmt::arg("vendor_name", vendor->GetName())));
-                        }
-                    }
-                }
-            }
+    if(urand(0, 99) > g_RandomChatterBotCommentChance)
+        return false;
 
-            // Questgiver
-            {
-                Unit* unit = nullptr;
-                Acore::AnyUnitInObjectRangeCheck check(bot, g_SayDistance);
-                Acore::UnitSearcher<Acore::AnyUnitInObjectRangeCheck> searcher(bot, unit, check);
-                Cell::VisitObjects(bot, searcher, g_SayDistance);
+    // Random chatter is the first to give way when the request budget is spent;
+    // the bot stays due and is retried after RANDOM_CHATTER_RETRY_SECONDS.
+    if (!TryAdmitLLMRequest(LLM_SOURCE_RANDOM))
+        return false;
 
-                if (unit && unit->GetTypeId() == TYPEID_UNIT)
-                {
-                    Creature* giver = unit->ToCreature();
-                    if (giver->HasNpcFlag(UNIT_NPC_FLAG_QUESTGIVER))
-                    {
-                        auto bounds = sObjectMgr->GetCreatureQuestRelationBounds(giver->GetEntry());
-                        int n       = std::distance(bounds.first, bounds.second);
-                        if (!g_EnvCommentQuestgiver.empty()) {
-                            uint32_t idx = g_EnvCommentQuestgiver.size() == 1 ? 0 : urand(0, g_EnvCommentQuestgiver.size() - 1);
-                            std::string templ = g_EnvCommentQuestgiver[idx];
-                            candidateComments.push_back(SafeFormat(templ,
-                                fmt::arg("questgiver_name", giver->GetName()),
-                                fmt::arg("quest_count", n)
-                            ));
-                        }
-                    }
-                }
-            }
+    // Guild comments are rolled once per bot and then compete with the other categories by weight
+    bool allowGuildComment = g_EnableGuildRandomAmbientChatter && guild && hasRealPlayerInGuild &&
+                             urand(0, 99) < g_GuildRandomChatterChance;
 
-            // Free bag slots
-            {
-                int freeSlots = 0;
-                for (uint8 i = INVENTORY_SLOT_ITEM_START; i < INVENTORY_SLOT_ITEM_END; ++i)
-                    if (!bot->GetItemByPos(i))
-                        ++freeSlots;
-                for (uint8 b = INVENTORY_SLOT_BAG_START; b < INVENTORY_SLOT_BAG_END; ++b)
-                    if (Bag* bag = bot->GetBagByPos(b))
-                        freeSlots += bag->GetFreeSlots();
-
-                if (!g_EnvCommentBagSlots.empty()) {
-                    uint32_t idx = g_EnvCommentBagSlots.size() == 1 ? 0 : urand(0, g_EnvCommentBagSlots.size() - 1);
-                    std::string templ = g_EnvCommentBagSlots[idx];
-                    candidateComments.push_back(SafeFormat(templ, fmt::arg("bag_slots", freeSlots)));
-                }
-            }
+    auto generationStart = std::chrono::steady_clock::now();
+    std::string environmentInfo = GenerateEnvironmentComment(bot, allowGuildComment);
+    if (g_DebugEnabled)
+    {
+        auto generationUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - generationStart).count();
+        LOG_INFO("server.loading", "[Ollama Chat] Random chatter comment for {} generated in {}us", bot->GetName(), generationUs);
+    }
 
-            // Dungeon
-            {
-                if (bot->GetMap() && bot->GetMap()->IsDungeon())
-                {
-                    std::string name = bot->GetMap()->GetMapName();
-                    if (!g_EnvCommentDungeon.empty()) {
-                        uint32_t idx = g_EnvCommentDungeon.size() == 1 ? 0 : urand(0, g_EnvCommentDungeon.size() - 1);
-                        std::string templ = g_EnvCommentDungeon[idx];
-                        candidateComments.push_back(SafeFormat(templ, fmt::arg("dungeon_name", name)));
-                    }
-                }
-            }
 
-            // Unfinished Quest
-            {
-                std::vector<std::string> unfinished;
-                for (auto const& qs : bot->getQuestStatusMap())
-                {
-                    if (qs.second.Status == QUEST_STATUS_INCOMPLETE)
-                    {
-                        if (auto* qt = sObjectMgr->GetQuestTemplate(qs.first))
-                            if (!g_EnvCommentUnfinishedQuest.empty()) {
-                                uint32_t idx = g_EnvCommentUnfinishedQuest.size() == 1 ? 0 : urand(0, g_EnvCommentUnfinishedQuest.size() - 1);
-                                std::string templ = g_EnvCommentUnfinishedQuest[idx];
-                                unfinished.push_back(SafeFormat(templ, fmt::arg("quest_name", qt->GetTitle())));
-                            }
-                    }
-                }
-                if (!unfinished.empty())
-                {
-                    uint32_t uIdx = unfinished.size() == 1 ? 0 : urand(0, unfinished.size() - 1);
-                    candidateComments.push_back(unfinished[uIdx]);
-                }
-            }
+    auto prompt = [bot, &environmentInfo]()
+    {
+        PlayerbotAI* botAI = sPlayerbotsMgr->GetPlayerbotAI(bot);
+        if (!botAI)
+            return std::string("Error, no bot AI");
+
+        std::string personality         = GetBotPersonality(bot);
+        std::string personalityPrompt   = GetPersonalityPromptAddition(personality);
+        std::string botName             = bot->GetName();
+        uint32_t botLevel               = bot->GetLevel();
+        std::string botClass            = botAI->GetChatHelper()->FormatClass(bot->getClass());
+        std::string botRace             = botAI->GetChatHelper()->FormatRace(bot->getRace());
+        std::string botRole             = ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot));
+        std::string botGender           = (bot->getGender() == 0 ? "Male" : "Female");
+        std::string botFaction          = (bot->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
+
+        AreaTableEntry const* botCurrentArea = botAI->GetCurrentArea();
+        AreaTableEntry const* botCurrentZone = botAI->GetCurrentZone();
+        std::string botAreaName = botCurrentArea ? botAI->GetLocalizedAreaName(botCurrentArea) : "UnknownArea";
+        std::string botZoneName = botCurrentZone ? botAI->GetLocalizedAreaName(botCurrentZone) : "UnknownZone";
+        std::string botMapName  = bot->GetMap() ? bot->GetMap()->GetMapName() : "UnknownMap";
+
+        PromptVars vars;
+        vars.Set(PROMPT_VAR_BOT_NAME, botName);
+        vars.Set(PROMPT_VAR_BOT_LEVEL, botLevel);
+        vars.Set(PROMPT_VAR_BOT_CLASS, botClass);
+        vars.Set(PROMPT_VAR_BOT_RACE, botRace);
+        vars.Set(PROMPT_VAR_BOT_GENDER, botGender);
+        vars.Set(PROMPT_VAR_BOT_ROLE, botRole);
+        vars.Set(PROMPT_VAR_BOT_FACTION, botFaction);
+        vars.Set(PROMPT_VAR_BOT_AREA, botAreaName);
+        vars.Set(PROMPT_VAR_BOT_ZONE, botZoneName);
+        vars.Set(PROMPT_VAR_BOT_MAP, botMapName);
+        vars.Set(PROMPT_VAR_BOT_PERSONALITY, personalityPrompt);
+        vars.Set(PROMPT_VAR_BOT_PERSONALITY_NAME, personality);
+        vars.Set(PROMPT_VAR_ENVIRONMENT_INFO, environmentInfo);
+
+        return GetPromptTemplates()->randomChatter.Render(vars);
+
+    }();
+
+    if(g_DebugEnabled)
+    {
+        LOG_INFO("server.loading", "[Ollama Chat] Random Message Prompt: {} ", prompt);
+    }
 
-            // Guild-specific environment comments (if bot is in a guild with real players)
-            if (g_EnableGuildRandomAmbientChatter && bot->GetGuild())
+    uint64_t botGuid = bot->GetGUID().GetRawValue();
+
+    std::thread([botGuid, prompt]() {
+        try {
+            Player* botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
+            if (!botPtr) return;
+            std::string response = QueryOllamaAPI(prompt);
+            if (response.empty()) return;
+            botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
+            if (!botPtr) return;
+            PlayerbotAI* botAI = sPlayerbotsMgr->GetPlayerbotAI(botPtr);
+            if (!botAI) return;
+            if (botPtr->GetGroup())
+                botAI->SayToParty(response);
+            else if (botPtr->GetGuild() && g_EnableGuildRandomAmbientChatter)
             {
                 // Check if there are real players in the guild
                 bool hasRealPlayerInGuild = false;
-                Guild* guild = bot->GetGuild();
+                Guild* guild = botPtr->GetGuild();
                 for (auto const& pair : ObjectAccessor::GetPlayers())
                 {
                     Player* player = pair.second;
                     if (!player || !player->IsInWorld())
                         continue;
+                        
                     if (sPlayerbotsMgr->GetPlayerbotAI(player))
                         continue;
+                        
                     if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
                     {
                         hasRealPlayerInGuild = true;
                         break;
                     }
                 }
-                if (hasRealPlayerInGuild && urand(0, 99) < g_GuildRandomChatterChance)
+                
+                if (hasRealPlayerInGuild)
                 {
-                    // Guild member comments
-                    if (!g_GuildEnvCommentGuildMember.empty())
-                    {
-                        std::string memberName = bot->GetName();
-                        if (!memberName.empty())
-                        {
-                            uint32_t idx = urand(0, g_GuildEnvCommentGuildMember.size() - 1);
-                            std::string templ = g_GuildEnvCommentGuildMember[idx];
-                            guildComments.push_back(SafeFormat(templ, fmt::arg("member_name", memberName)));
-                        }
-                    }
-                    // Guild MOTD comments
-                    if (!g_GuildEnvCommentGuildMOTD.empty() && !guild->GetMOTD().empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildMOTD.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildMOTD[idx];
-                        guildComments.push_back(SafeFormat(templ, fmt::arg("guild_motd", guild->GetMOTD())));
-                    }
-                    // Guild bank comments
-                    if (!g_GuildEnvCommentGuildBank.empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildBank.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildBank[idx];
-                        guildComments.push_back(SafeFormat(templ, 
-                            fmt::arg("bank_gold", guild->GetTotalBankMoney() / 10000)));
-                    }
-                    // Guild raid comments
-                    if (!g_GuildEnvCommentGuildRaid.empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildRaid.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildRaid[idx];
-                        guildComments.push_back(templ);
-                    }
-                    // Guild endgame comments
-                    if (!g_GuildEnvCommentGuildEndgame.empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildEndgame.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildEndgame[idx];
-                        guildComments.push_back(templ);
-                    }
-                    // Guild strategy comments
-                    if (!g_GuildEnvCommentGuildStrategy.empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildStrategy.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildStrategy[idx];
-                        guildComments.push_back(templ);
-                    }
-                    // Guild group/quest/grind comments
-                    if (!g_GuildEnvCommentGuildGroup.empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildGroup.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildGroup[idx];
-                        guildComments.push_back(templ);
-                    }
-                    // Guild PvP comments
-                    if (!g_GuildEnvCommentGuildPvP.empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildPvP.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildPvP[idx];
-                        guildComments.push_back(templ);
-                    }
-                    // Guild community/social comments
-                    if (!g_GuildEnvCommentGuildCommunity.empty())
-                    {
-                        uint32_t idx = urand(0, g_GuildEnvCommentGuildCommunity.size() - 1);
-                        std::string templ = g_GuildEnvCommentGuildCommunity[idx];
-                        guildComments.push_back(templ);
-                    }
-                    candidateComments.insert(candidateComments.end(), guildComments.begin(), guildComments.end());
+                    // Guilded bots only speak in /guild
+                    if (g_DebugEnabled)
+                        LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter Guild: {}", response);
+                    botAI->SayToGuild(response);
                 }
             }
-
-            bool IsaGuildComment = false;
-
-            if (!candidateComments.empty())
-            {
-                uint32_t index = candidateComments.size() == 1 ? 0 : urand(0, candidateComments.size() - 1);
-                environmentInfo = candidateComments[index];
-                if (!candidateComments.empty() && !environmentInfo.empty()) {
-                    // If guildComments was appended, check if environmentInfo is one of them
-                    if (!guildComments.empty()) {
-                        for (const auto& gc : guildComments) {
-                            if (environmentInfo == gc) {
-                                IsaGuildComment = true;
-                                break;
-                            }
-                        }
-                    }
+            else {
+                std::vector<std::string> channels = {"General", "Say"};
+                std::random_device rd;
+                std::mt19937 gen(rd());
+                std::uniform_int_distribution<size_t> dist(0, channels.size() - 1);
+                std::string selectedChannel = channels[dist(gen)];
+                if (selectedChannel == "Say") {
+                    if (g_DebugEnabled)
+                        LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter Say: {}", response);
+                    botAI->Say(response);
+                } else if (selectedChannel == "General") {
+                    if (g_DebugEnabled)
+                        LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter General: {}", response);
+                    botAI->SayToChannel(response, ChatChannelId::GENERAL);
                 }
             }
-            else
-            {
-                environmentInfo = "";
-            }
-
-
-            auto prompt = [bot, &environmentInfo]()
-            {
-                PlayerbotAI* botAI = sPlayerbotsMgr->GetPlayerbotAI(bot);
-                if (!botAI)
-                    return std::string("Error, no bot AI");
-
-                std::string personality         = GetBotPersonality(bot);
-                std::string personalityPrompt   = GetPersonalityPromptAddition(personality);
-                std::string botName             = bot->GetName();
-                uint32_t botLevel               = bot->GetLevel();
-                std::string botClass            = botAI->GetChatHelper()->FormatClass(bot->getClass());
-                std::string botRace             = botAI->GetChatHelper()->FormatRace(bot->getRace());
-                std::string botRole             = ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot));
-                std::string botGender           = (bot->getGender() == 0 ? "Male" : "Female");
-                std::string botFaction          = (bot->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
-
-                AreaTableEntry const* botCurrentArea = botAI->GetCurrentArea();
-                AreaTableEntry const* botCurrentZone = botAI->GetCurrentZone();
-                std::string botAreaName = botCurrentArea ? botAI->GetLocalizedAreaName(botCurrentArea) : "UnknownArea";
-                std::string botZoneName = botCurrentZone ? botAI->GetLocalizedAreaName(botCurrentZone) : "UnknownZone";
-                std::string botMapName  = bot->GetMap() ? bot->GetMap()->GetMapName() : "UnknownMap";
-
-                std::string prompt = SafeFormat(
-                    g_RandomChatterPromptTemplate,
-                    fmt::arg("bot_name", botName),
-                    fmt::arg("bot_level", botLevel),
-                    fmt::arg("bot_class", botClass),
-                    fmt::arg("bot_race", botRace),
-                    fmt::arg("bot_gender", botGender),
-                    fmt::arg("bot_role", botRole),
-                    fmt::arg("bot_faction", botFaction),
-                    fmt::arg("bot_area", botAreaName),
-                    fmt::arg("bot_zone", botZoneName),
-                    fmt::arg("bot_map", botMapName),
-                    fmt::arg("bot_personality", personalityPrompt),
-                    fmt::arg("bot_personality_name", personality),
-                    fmt::arg("environment_info", environmentInfo)
-                );
-
-                return prompt;
-
-            }();
-
-            if(g_DebugEnabled)
-            {
-                LOG_INFO("server.loading", "[Ollama Chat] Random Message Prompt: {} ", prompt);
-            }
-
-            uint64_t botGuid = bot->GetGUID().GetRawValue();
-
-            std::thread([botGuid, prompt]() {
-                try {
-                    Player* botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                    if (!botPtr) return;
-                    std::string response = QueryOllamaAPI(prompt);
-                    if (response.empty()) return;
-                    botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                    if (!botPtr) return;
-                    PlayerbotAI* botAI = sPlayerbotsMgr->GetPlayerbotAI(botPtr);
-                    if (!botAI) return;
-                    if (botPtr->GetGroup())
-                        botAI->SayToParty(response);
-                    else if (botPtr->GetGuild() && g_EnableGuildRandomAmbientChatter)
-                    {
-                        // Check if there are real players in the guild
-                        bool hasRealPlayerInGuild = false;
-                        Guild* guild = botPtr->GetGuild();
-                        for (auto const& pair : ObjectAccessor::GetPlayers())
-                        {
-                            Player* player = pair.second;
-                            if (!player || !player->IsInWorld())
-                                continue;
-                                
-                            if (sPlayerbotsMgr->GetPlayerbotAI(player))
-                                continue;
-                                
-                            if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
-                            {
-                                hasRealPlayerInGuild = true;
-                                break;
-                            }
-                        }
-                        
-                        if (hasRealPlayerInGuild)
-                        {
-                            // Guilded bots only speak in /guild
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter Guild: {}", response);
-                            botAI->SayToGuild(response);
-                        }
-                    }
-                    else {
-                        std::vector<std::string> channels = {"General", "Say"};
-                        std::random_device rd;
-                        std::mt19937 gen(rd());
-                        std::uniform_int_distribution<size_t> dist(0, channels.size() - 1);
-                        std::string selectedChannel = channels[dist(gen)];
-                        if (selectedChannel == "Say") {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter Say: {}", response);
-                            botAI->Say(response);
-                        } else if (selectedChannel == "General") {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter General: {}", response);
-                            botAI->SayToChannel(response, ChatChannelId::GENERAL);
-                        }
-                    }
-                } catch (const std::exception& e) {
-                    LOG_ERROR("server.loading", "[Ollama Chat] Exception in random chatter thread: {}", e.what());
-                } catch (...) {
-                    LOG_ERROR("server.loading", "[Ollama Chat] Unknown exception in random chatter thread");
-                }
-            }).detach();
-
+        } catch (const std::exception& e) {
+            LOG_ERROR("server.loading", "[Ollama Chat] Exception in random chatter thread: {}", e.what());
+        } catch (...) {
+            LOG_ERROR("server.loading", "[Ollama Chat] Unknown exception in random chatter thread");
+        }
+    }).detach();
 
-            nextRandomChatTime[guid] = now + urand(g_MinRandomInterval, g_MaxRandomInterval);
-    }
+    return true;
 }
@@ -2,15 +2,24 @@
 #define MOD_OLLAMA_CHAT_RANDOM_H
 
 #include "ScriptMgr.h"
+#include <vector>
+
+class Player;
 
 class OllamaBotRandomChatter : public WorldScript
 {
 public:
     OllamaBotRandomChatter();
+    void OnStartup() override;
     void OnUpdate(uint32 diff) override;
 
 private:
-    void HandleRandomChatter();
+    // Queues bots that came online since the last scan
+    void ScheduleRandomChatterBots();
+    // Evaluates due bots, bounded by RandomChatterMaxBotsPerTick and RandomChatterTickBudgetUs
+    void ProcessDueRandomChatter();
+    // @return true if the bot chattered; false if it should be retried shortly
+    bool TryRandomChatter(Player* bot, std::vector<Player*> const& realPlayers);
 };
 
 #endif // MOD_OLLAMA_CHAT_RANDOM_H
@@ -0,0 +1,161 @@
+#include "mod-ollama-chat_relationship.h"
+#include "mod-ollama-chat_config.h"
+#include "mod-ollama-chat_lockstats.h"
+
+static RelationshipShard relationshipShards[RELATIONSHIP_SHARD_COUNT];
+
+// Entries looked at per eviction, and how far the scan may go to find them
+static constexpr int RELATIONSHIP_EVICTION_SAMPLES = 8;
+static constexpr size_t RELATIONSHIP_EVICTION_SCAN = 256;
+
+RelationshipShard& GetRelationshipShard(uint64_t botGuid)
+{
+    // Top bits of a multiplicative hash; the low bits of a GUID are a plain counter
+    return relationshipShards[(botGuid * 0x9E3779B97F4A7C15ULL) >> 60 & (RELATIONSHIP_SHARD_COUNT - 1)];
+}
+
+RelationshipShard& GetRelationshipShardByIndex(size_t index)
+{
+    return relationshipShards[index];
+}
+
+size_t GetRelationshipShardIndex(const RelationshipShard& shard)
+{
+    return size_t(&shard - relationshipShards);
+}
+
+RelationshipState& TouchRelationship(RelationshipShard& shard, uint64_t botGuid, uint64_t playerGuid)
+{
+    RelationshipState& state = shard.pairs.FindOrInsert(botGuid, playerGuid);
+    MarkRelationshipUsed(shard, state);
+    return state;
+}
+
+HistoryRing& AcquireRelationshipHistory(RelationshipShard& shard, RelationshipState& state)
+{
+    if (!state.HasHistory())
+    {
+        if (!shard.freeHistoryHandles.empty())
+        {
+            state.historyHandle = shard.freeHistoryHandles.back();
+            shard.freeHistoryHandles.pop_back();
+        }
+        else
+        {
+            state.historyHandle = uint32_t(shard.historyRings.size());
+            shard.historyRings.emplace_back();
+        }
+        // Only reallocates if OllamaChat.MaxConversationHistory changed since the ring was last used
+        shard.historyRings[state.historyHandle].Reset(g_MaxConversationHistory);
+        ++shard.historyPairs;
+    }
+    return shard.historyRings[state.historyHandle];
+}
+
+void ReleaseRelationshipHistory(RelationshipShard& shard, RelationshipState& state)
+{
+    state.flags &= ~RELATIONSHIP_HISTORY_LOADED;
+    if (!state.HasHistory())
+        return;
+
+    shard.historyRings[state.historyHandle].Clear(shard.historyText);
+    shard.freeHistoryHandles.push_back(state.historyHandle);
+    state.historyHandle = NO_HISTORY_HANDLE;
+    --shard.historyPairs;
+}
+
+void EraseRelationshipIfEmpty(RelationshipShard& shard, uint64_t botGuid, uint64_t playerGuid)
+{
+    const RelationshipState* state = shard.pairs.Find(botGuid, playerGuid);
+    if (state && !state->HasHistory() && !state->HasSentiment())
+        shard.pairs.Erase(botGuid, playerGuid);
+}
+
+// Drops the history (or sentiment) of the least recently used of a few sampled entries
+static bool EvictRelationshipSample(RelationshipShard& shard, bool history)
+{
+    size_t slots = shard.pairs.SlotCount();
+    if (!slots)
+        return false;
+
+    size_t mask = slots - 1;
+    size_t best = slots;
+    uint32_t bestAge = 0;
+    uint32_t clock = shard.clock.load(std::memory_order_relaxed);
+    int sampled = 0;
+    size_t scanned = 0;
+    for (; scanned < slots && scanned < RELATIONSHIP_EVICTION_SCAN && sampled < RELATIONSHIP_EVICTION_SAMPLES; ++scanned)
+    {
+        size_t slot = (shard.evictCursor + scanned) & mask;
+        if (!shard.pairs.SlotUsed(slot))
+            continue;
+
+        const RelationshipState& state = shard.pairs.SlotValue(slot);
+        if (history ? (!state.HasHistory() || state.unsavedTurns) : !state.HasSentiment())
+            continue;
+
+        ++sampled;
+        // Unsigned difference, so clock wrap-around does not matter
+        uint32_t age = clock - state.lastUsed.load(std::memory_order_relaxed);
+        if (age && (best == slots || age > bestAge))
+        {
+            best = slot;
+            bestAge = age;
+        }
+    }
+    shard.evictCursor = (shard.evictCursor + scanned) & mask;
+
+    if (best == slots)
+        return false;
+
+    auto [botGuid, playerGuid] = shard.pairs.SlotKey(best);
+    RelationshipState& state = shard.pairs.SlotValue(best);
+    if (history)
+    {
+        ReleaseRelationshipHistory(shard, state);
+    }
+    else
+    {
+        state.flags &= ~RELATIONSHIP_SENTIMENT_RESIDENT;
+        --shard.sentimentPairs;
+    }
+    EraseRelationshipIfEmpty(shard, botGuid, playerGuid);
+    return true;
+}
+
+void TrimRelationshipShard(RelationshipShard& shard)
+{
+    // Limits are spread evenly over the shards
+    size_t historyLimit = (g_MaxResidentHistoryPairs + RELATIONSHIP_SHARD_COUNT - 1) / RELATIONSHIP_SHARD_COUNT;
+    size_t sentimentLimit = (g_MaxResidentSentimentPairs + RELATIONSHIP_SHARD_COUNT - 1) / RELATIONSHIP_SHARD_COUNT;
+
+    while (historyLimit && shard.historyPairs > historyLimit && EvictRelationshipSample(shard, true))
+        ;
+    while (sentimentLimit && shard.sentimentPairs > sentimentLimit && EvictRelationshipSample(shard, false))
+        ;
+}
+
+RelationshipTableStats GetRelationshipTableStats()
+{
+    RelationshipTableStats stats;
+    double probes = 0.0;
+    for (RelationshipShard& shard : relationshipShards)
+    {
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+        stats.pairs += shard.pairs.Size();
+        stats.historyPairs += shard.historyPairs;
+        stats.sentimentPairs += shard.sentimentPairs;
+        stats.tableBytes += shard.pairs.MemoryBytes();
+        probes += shard.pairs.AverageProbeLength() * shard.pairs.Size();
+
+        stats.historyBytes += shard.historyRings.capacity() * sizeof(HistoryRing) +
+                              shard.freeHistoryHandles.capacity() * sizeof(uint32_t) +
+                              shard.historyText.ReservedBytes();
+        for (const HistoryRing& ring : shard.historyRings)
+            stats.historyBytes += ring.Capacity() * 2 * sizeof(HistoryText);
+        stats.historyTextBytes += shard.historyText.UsedBytes();
+    }
+    if (stats.pairs)
+        stats.averageProbeLength = probes / stats.pairs;
+    return stats;
+}
@@ -0,0 +1,151 @@
+#ifndef MOD_OLLAMA_CHAT_RELATIONSHIP_H
+#define MOD_OLLAMA_CHAT_RELATIONSHIP_H
+
+#include "mod-ollama-chat_historystore.h"
+#include "mod-ollama-chat_pairmap.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+static constexpr uint32_t NO_HISTORY_HANDLE = UINT32_MAX;
+
+enum RelationshipFlags : uint8_t
+{
+    RELATIONSHIP_HISTORY_LOADED    = 0x01,   // Stored turns have been read; otherwise only turns appended since
+    RELATIONSHIP_SENTIMENT_RESIDENT = 0x02,  // sentiment holds the pair's current value
+};
+
+// Everything kept in memory about one bot/player pair. History and sentiment are
+// resident independently; the entry goes away once neither is.
+struct RelationshipState
+{
+    // Shard clock at the last access, for eviction. Readers under the shared lock update it,
+    // hence atomic; the table only moves entries under the exclusive lock.
+    std::atomic<uint32_t> lastUsed{0};
+    uint32_t historyHandle = NO_HISTORY_HANDLE;    // Ring in the shard's historyRings
+    uint32_t unsavedTurns = 0;                     // Appended but not yet committed; history cannot be evicted
+    float    sentiment = 0.0f;
+    uint8_t  flags = 0;
+
+    RelationshipState() = default;
+    RelationshipState(const RelationshipState& other) { *this = other; }
+    RelationshipState& operator=(const RelationshipState& other)
+    {
+        lastUsed.store(other.lastUsed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        historyHandle = other.historyHandle;
+        unsavedTurns = other.unsavedTurns;
+        sentiment = other.sentiment;
+        flags = other.flags;
+        return *this;
+    }
+
+    bool HasHistory() const { return historyHandle != NO_HISTORY_HANDLE; }
+    bool HasSentiment() const { return flags & RELATIONSHIP_SENTIMENT_RESIDENT; }
+};
+
+// A conversation turn appended since the last history save
+struct PendingHistoryRow
+{
+    uint64_t    botGuid;
+    uint64_t    playerGuid;
+    time_t      timestamp;
+    std::string playerMessage;
+    std::string botReply;
+};
+
+using SentimentValues = std::map<std::pair<uint64_t, uint64_t>, float>;
+
+// Sentiment changes taken by one save. The resets (bot or player GUID 0 matches all) are
+// older than the values; the save deletes their rows before writing the values.
+struct SentimentChanges
+{
+    std::vector<std::pair<uint64_t, uint64_t>> resets;
+    SentimentValues values;
+};
+
+// One independently locked part of the relationship table. A bot's pairs all live in
+// the same shard, so per-bot lookups and resets only take one lock. Lookups and prompt
+// rendering take the lock shared; anything that changes the shard takes it exclusively.
+// The save queues of the pairs are kept here too, so a reply touches no global lock.
+struct RelationshipShard
+{
+    std::shared_mutex mutex;
+    FlatPairMap<RelationshipState> pairs;
+    std::vector<HistoryRing> historyRings;         // Indexed by RelationshipState::historyHandle
+    std::vector<uint32_t> freeHistoryHandles;      // Released rings, kept with their slots for reuse
+    HistoryTextArena historyText;
+    size_t historyPairs = 0;
+    size_t sentimentPairs = 0;
+    std::atomic<uint32_t> clock{0};
+    size_t evictCursor = 0;
+
+    std::vector<PendingHistoryRow> pendingHistoryRows;
+    // Sentiment values changed and resets made since the last save, and the changes the
+    // running save is writing; a pair read back from the database checks all of them first,
+    // as they are newer than its row. Every value in dirtySentiments is newer than every
+    // reset in pendingSentimentResets, as a reset drops the matching dirty values.
+    SentimentValues dirtySentiments;
+    std::vector<std::pair<uint64_t, uint64_t>> pendingSentimentResets;
+    std::shared_ptr<const SentimentChanges> savingSentiments;
+    std::set<std::pair<uint64_t, uint64_t>> sentimentLoads;   // Pairs being read by a worker thread
+};
+
+static constexpr size_t RELATIONSHIP_SHARD_COUNT = 16;
+
+RelationshipShard& GetRelationshipShard(uint64_t botGuid);
+RelationshipShard& GetRelationshipShardByIndex(size_t index);
+size_t GetRelationshipShardIndex(const RelationshipShard& shard);
+
+// Returns the entry for a pair, inserting it if needed, and marks it most recently used.
+// Caller holds the shard lock exclusively; the reference is valid until the shard is next changed.
+RelationshipState& TouchRelationship(RelationshipShard& shard, uint64_t botGuid, uint64_t playerGuid);
+
+// Marks an entry most recently used. Caller holds the shard lock, shared is enough.
+inline void MarkRelationshipUsed(RelationshipShard& shard, RelationshipState& state)
+{
+    state.lastUsed.store(shard.clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// History ring of an entry, taking one with OllamaChat.MaxConversationHistory slots if it
+// has none. Caller holds the shard lock exclusively.
+HistoryRing& AcquireRelationshipHistory(RelationshipShard& shard, RelationshipState& state);
+
+// Returns an entry's history ring and its text to the shard and clears
+// RELATIONSHIP_HISTORY_LOADED. Caller holds the shard lock exclusively.
+void ReleaseRelationshipHistory(RelationshipShard& shard, RelationshipState& state);
+
+/**
+ * Drop least recently used history and sentiment values of a shard beyond its share of
+ * OllamaChat.MaxResidentHistoryPairs and OllamaChat.MaxResidentSentimentPairs. Eviction
+ * samples a few entries and drops the oldest, so it is approximately LRU. History with
+ * unsaved turns and the entry used last are never evicted. Caller holds the shard lock
+ * exclusively.
+ */
+void TrimRelationshipShard(RelationshipShard& shard);
+
+// Erases an entry that holds neither history nor sentiment. Caller holds the shard lock exclusively.
+void EraseRelationshipIfEmpty(RelationshipShard& shard, uint64_t botGuid, uint64_t playerGuid);
+
+struct RelationshipTableStats
+{
+    size_t pairs = 0;
+    size_t historyPairs = 0;
+    size_t sentimentPairs = 0;
+    size_t tableBytes = 0;       // Hash table slots, including empty ones
+    size_t historyBytes = 0;     // History rings and text slabs
+    size_t historyTextBytes = 0; // Text chunks in use
+    double averageProbeLength = 0.0;
+};
+
+// Walks every shard, so only meant for ".ollama stats"
+RelationshipTableStats GetRelationshipTableStats();
+
+#endif // MOD_OLLAMA_CHAT_RELATIONSHIP_H
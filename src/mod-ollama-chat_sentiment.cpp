@@ -2,34 +2,257 @@
 #include "mod-ollama-chat_config.h"
 #include "mod-ollama-chat_api.h"
 #include "mod-ollama-chat-utilities.h"
+#include "mod-ollama-chat_dbsave.h"
+#include "mod-ollama-chat_journal.h"
+#include "mod-ollama-chat_lockstats.h"
+#include "mod-ollama-chat_relationship.h"
 #include "Log.h"
 #include "DatabaseEnv.h"
 #include "Player.h"
 #include <fmt/core.h>
 #include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <thread>
+
+using SentimentKey = std::pair<uint64_t, uint64_t>;
+
+// Resident values and the save queues all live in the relationship table, per shard.
+// Changed values go to the shard's dirtySentiments as well as the table, so evicting a
+// pair never loses a change: it stays queued for the next save and is served from there
+// if the pair is used again before it is written.
+static std::atomic<bool> sentimentSaveRunning{false};
+
+// Pairs missed by GetBotPlayerSentiment, read by a single loader thread so a burst of misses
+// cannot start a thread each. A pair is queued once; shard.sentimentLoads tracks it until read.
+static std::mutex sentimentLoadMutex;
+static std::condition_variable sentimentLoadWake;
+static std::deque<SentimentKey> sentimentLoadQueue;
+static std::once_flag sentimentLoaderStarted;
+
+// Pairs read per query by the loader thread
+static constexpr size_t SENTIMENT_LOAD_BATCH = 100;
+
+// Makes a value resident and marks the pair most recently used. Caller holds the shard lock exclusively.
+static void StoreResidentSentiment(RelationshipShard& shard, const SentimentKey& key, float value)
+{
+    RelationshipState& state = TouchRelationship(shard, key.first, key.second);
+    if (!state.HasSentiment())
+    {
+        state.flags |= RELATIONSHIP_SENTIMENT_RESIDENT;
+        ++shard.sentimentPairs;
+    }
+    state.sentiment = value;
+    TrimRelationshipShard(shard);
+}
+
+static bool SentimentKeyMatches(const SentimentKey& key, uint64_t botGuid, uint64_t playerGuid)
+{
+    return (!botGuid || key.first == botGuid) && (!playerGuid || key.second == playerGuid);
+}
+
+static bool AnyResetMatches(const std::vector<SentimentKey>& resets, const SentimentKey& key)
+{
+    return std::any_of(resets.begin(), resets.end(), [&key](const SentimentKey& reset) {
+        return SentimentKeyMatches(key, reset.first, reset.second);
+    });
+}
+
+// Value of a pair that is not resident but has a change not yet in the database. Caller holds the shard lock.
+// Changes are looked at newest first; a reset reads as the default value, hiding older values and the row.
+static bool FindUnsavedSentiment(const RelationshipShard& shard, const SentimentKey& key, float& value)
+{
+    auto dirtyIt = shard.dirtySentiments.find(key);
+    if (dirtyIt != shard.dirtySentiments.end())
+    {
+        value = dirtyIt->second;
+        return true;
+    }
+    if (AnyResetMatches(shard.pendingSentimentResets, key))
+    {
+        value = g_SentimentDefaultValue;
+        return true;
+    }
+    if (shard.savingSentiments)
+    {
+        auto savingIt = shard.savingSentiments->values.find(key);
+        if (savingIt != shard.savingSentiments->values.end())
+        {
+            value = savingIt->second;
+            return true;
+        }
+        if (AnyResetMatches(shard.savingSentiments->resets, key))
+        {
+            value = g_SentimentDefaultValue;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Resident value of a pair, marking it most recently used. Caller holds the shard lock, shared is enough.
+static bool FindResidentSentiment(RelationshipShard& shard, const SentimentKey& key, float& value)
+{
+    RelationshipState* state = shard.pairs.Find(key.first, key.second);
+    if (!state || !state->HasSentiment())
+        return false;
+    MarkRelationshipUsed(shard, *state);
+    value = state->sentiment;
+    return true;
+}
+
+// Makes a value read from the database resident, unless the pair was set or saved while the
+// query ran; that value is newer than the row. Caller holds the shard lock exclusively.
+static float StoreLoadedSentiment(RelationshipShard& shard, const SentimentKey& key, float stored)
+{
+    float value;
+    if (FindResidentSentiment(shard, key, value))
+        return value;
+    if (!FindUnsavedSentiment(shard, key, value))
+        value = stored;
+    StoreResidentSentiment(shard, key, value);
+    return value;
+}
+
+// Reads a pair from memory, the unsaved changes or the database, in that order, and makes it resident
+static float FetchBotPlayerSentiment(const SentimentKey& key)
+{
+    RelationshipShard& shard = GetRelationshipShard(key.first);
+    float value = g_SentimentDefaultValue;
+    {
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+        if (FindResidentSentiment(shard, key, value))
+            return value;
+    }
+    {
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        if (FindResidentSentiment(shard, key, value))
+            return value;
+        if (FindUnsavedSentiment(shard, key, value))
+        {
+            StoreResidentSentiment(shard, key, value);
+            return value;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    QueryResult result = CharacterDatabase.Query(fmt::format(
+        "SELECT sentiment_value FROM mod_ollama_chat_bot_player_sentiments WHERE bot_guid = {} AND player_guid = {}",
+        key.first, key.second));
+    float stored = result ? result->Fetch()[0].Get<float>() : g_SentimentDefaultValue;
+
+    TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+    value = StoreLoadedSentiment(shard, key, stored);
+
+    if (g_DebugEnabled)
+    {
+        uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("server.loading", "[OllamaChat] Loaded sentiment for bot {} and player {} in {} us ({} pairs in shard)",
+                 key.first, key.second, micros, shard.sentimentPairs);
+    }
+    return value;
+}
+
+// Reads queued pairs in batches, one query per batch
+static void SentimentLoaderMain()
+{
+    for (;;)
+    {
+        std::vector<SentimentKey> keys;
+        {
+            std::unique_lock<std::mutex> lock(sentimentLoadMutex);
+            sentimentLoadWake.wait(lock, [] { return !sentimentLoadQueue.empty(); });
+            while (!sentimentLoadQueue.empty() && keys.size() < SENTIMENT_LOAD_BATCH)
+            {
+                keys.push_back(sentimentLoadQueue.front());
+                sentimentLoadQueue.pop_front();
+            }
+        }
+
+        std::string pairs;
+        for (const SentimentKey& key : keys)
+            pairs += fmt::format("{}({}, {})", pairs.empty() ? "" : ", ", key.first, key.second);
+
+        std::map<SentimentKey, float> stored;
+        QueryResult result = CharacterDatabase.Query(
+            "SELECT bot_guid, player_guid, sentiment_value FROM mod_ollama_chat_bot_player_sentiments "
+            "WHERE (bot_guid, player_guid) IN (" + pairs + ")");
+        if (result)
+        {
+            do {
+                Field* fields = result->Fetch();
+                stored[{ fields[0].Get<uint64_t>(), fields[1].Get<uint64_t>() }] = fields[2].Get<float>();
+            } while (result->NextRow());
+        }
+
+        for (const SentimentKey& key : keys)
+        {
+            auto it = stored.find(key);
+            RelationshipShard& shard = GetRelationshipShard(key.first);
+            TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+            StoreLoadedSentiment(shard, key, it != stored.end() ? it->second : g_SentimentDefaultValue);
+            shard.sentimentLoads.erase(key);
+        }
+    }
+}
+
+static void QueueSentimentLoad(const SentimentKey& key)
+{
+    // Started on first use; it waits for work for the rest of the process lifetime
+    std::call_once(sentimentLoaderStarted, [] { std::thread(SentimentLoaderMain).detach(); });
+    {
+        std::lock_guard<std::mutex> lock(sentimentLoadMutex);
+        sentimentLoadQueue.push_back(key);
+    }
+    sentimentLoadWake.notify_one();
+}
 
 float GetBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid)
 {
     if (!g_EnableSentimentTracking)
         return g_SentimentDefaultValue;
 
-    std::lock_guard<std::mutex> lock(g_SentimentMutex);
-    
-    auto botIt = g_BotPlayerSentiments.find(botGuid);
-    if (botIt != g_BotPlayerSentiments.end())
+    SentimentKey key{ botGuid, playerGuid };
+    RelationshipShard& shard = GetRelationshipShard(botGuid);
+    float value;
     {
-        auto playerIt = botIt->second.find(playerGuid);
-        if (playerIt != botIt->second.end())
+        // The common case, a resident pair, only needs the shared lock
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+        if (FindResidentSentiment(shard, key, value))
+            return value;
+    }
+    {
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        if (FindResidentSentiment(shard, key, value))
+            return value;
+        if (FindUnsavedSentiment(shard, key, value))
         {
-            return playerIt->second;
+            StoreResidentSentiment(shard, key, value);
+            return value;
         }
+        // Already being read for an earlier caller
+        if (!shard.sentimentLoads.insert(key).second)
+            return g_SentimentDefaultValue;
     }
-    
-    // Return default value if not found
+
+    QueueSentimentLoad(key);
     return g_SentimentDefaultValue;
 }
 
+float LoadBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid)
+{
+    if (!g_EnableSentimentTracking)
+        return g_SentimentDefaultValue;
+
+    return FetchBotPlayerSentiment({ botGuid, playerGuid });
+}
+
 void SetBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid, float sentimentValue)
 {
     if (!g_EnableSentimentTracking)
@@ -38,8 +261,15 @@ void SetBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid, float sentimen
     // Clamp sentiment value to valid range [0.0, 1.0]
     sentimentValue = std::max(0.0f, std::min(1.0f, sentimentValue));
     
-    std::lock_guard<std::mutex> lock(g_SentimentMutex);
-    g_BotPlayerSentiments[botGuid][playerGuid] = sentimentValue;
+    // Stored and queued under one lock, so the pair cannot be evicted and read back from
+    // the database in between
+    {
+        RelationshipShard& shard = GetRelationshipShard(botGuid);
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        StoreResidentSentiment(shard, { botGuid, playerGuid }, sentimentValue);
+        shard.dirtySentiments[{ botGuid, playerGuid }] = sentimentValue;
+        JournalSentimentChange(botGuid, playerGuid, sentimentValue);
+    }
     
     if (g_DebugEnabled)
     {
@@ -104,8 +334,8 @@ void UpdateBotPlayerSentiment(Player* bot, Player* player, const std::string& me
     uint64_t botGuid = bot->GetGUID().GetRawValue();
     uint64_t playerGuid = player->GetGUID().GetRawValue();
     
-    // Get current sentiment
-    float currentSentiment = GetBotPlayerSentiment(botGuid, playerGuid);
+    // Get current sentiment; this runs on the reply thread, so the stored value can be waited for
+    float currentSentiment = LoadBotPlayerSentiment(botGuid, playerGuid);
     
     // Analyze the message sentiment
     float adjustment = AnalyzeMessageSentiment(message);
@@ -140,36 +370,198 @@ std::string GetSentimentPromptAddition(Player* bot, Player* player)
     );
 }
 
-void LoadBotPlayerSentimentsFromDB()
+std::string GetSentimentPromptAddition(uint64_t botGuid, uint64_t playerGuid, const std::string& playerName)
 {
-    if (!g_EnableSentimentTracking)
-        return;
+    if (!g_EnableSentimentTracking || g_SentimentPromptTemplate.empty())
+        return "";
 
-    std::lock_guard<std::mutex> lock(g_SentimentMutex);
-    g_BotPlayerSentiments.clear();
-    
-    QueryResult result = CharacterDatabase.Query("SELECT bot_guid, player_guid, sentiment_value FROM mod_ollama_chat_bot_player_sentiments");
-    
-    if (!result)
+    return SafeFormat(
+        g_SentimentPromptTemplate,
+        fmt::arg("player_name", playerName),
+        fmt::arg("sentiment_value", LoadBotPlayerSentiment(botGuid, playerGuid))
+    );
+}
+
+// The shard holding a bot's pairs, or every shard if botGuid is 0
+template<typename Fn>
+static void ForEachRelationshipShard(uint64_t botGuid, Fn&& fn)
+{
+    if (botGuid)
     {
-        LOG_INFO("server.loading", "[OllamaChat] No existing sentiment data found in database");
+        fn(GetRelationshipShard(botGuid));
         return;
     }
-    
+    for (size_t i = 0; i < RELATIONSHIP_SHARD_COUNT; ++i)
+        fn(GetRelationshipShardByIndex(i));
+}
+
+std::vector<BotPlayerSentiment> GetResidentBotPlayerSentiments(uint64_t botGuid, uint64_t playerGuid)
+{
+    std::vector<BotPlayerSentiment> sentiments;
+    ForEachRelationshipShard(botGuid, [&](RelationshipShard& shard) {
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+        shard.pairs.ForEach([&](uint64_t pairBot, uint64_t pairPlayer, const RelationshipState& state) {
+            if (state.HasSentiment() && SentimentKeyMatches({ pairBot, pairPlayer }, botGuid, playerGuid))
+                sentiments.push_back({ pairBot, pairPlayer, state.sentiment });
+        });
+    });
+    std::sort(sentiments.begin(), sentiments.end(), [](const BotPlayerSentiment& a, const BotPlayerSentiment& b) {
+        return a.botGuid != b.botGuid ? a.botGuid < b.botGuid : a.playerGuid < b.playerGuid;
+    });
+    return sentiments;
+}
+
+// DELETE for the stored values matching a reset; 0 matches all
+static std::string GetResetSentimentsSql(uint64_t botGuid, uint64_t playerGuid)
+{
+    std::string where;
+    if (botGuid)
+        where += fmt::format(" WHERE bot_guid = {}", botGuid);
+    if (playerGuid)
+        where += fmt::format("{} player_guid = {}", botGuid ? " AND" : " WHERE", playerGuid);
+    return "DELETE FROM mod_ollama_chat_bot_player_sentiments" + where;
+}
+
+uint32_t ResetBotPlayerSentiments(uint64_t botGuid, uint64_t playerGuid)
+{
     uint32_t count = 0;
-    do
+    ForEachRelationshipShard(botGuid, [&](RelationshipShard& shard) {
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        // Journaled under the lock that queues the reset, so a drain that takes it also sees
+        // its record, and values of this shard set before or after land on the right side
+        JournalSentimentReset(shard, botGuid, playerGuid);
+        shard.pairs.EraseIf([&](uint64_t pairBot, uint64_t pairPlayer, RelationshipState& state) {
+            if (state.HasSentiment() && SentimentKeyMatches({ pairBot, pairPlayer }, botGuid, playerGuid))
+            {
+                state.flags &= ~RELATIONSHIP_SENTIMENT_RESIDENT;
+                --shard.sentimentPairs;
+                ++count;
+            }
+            return !state.HasHistory() && !state.HasSentiment();
+        });
+        for (auto it = shard.dirtySentiments.begin(); it != shard.dirtySentiments.end();)
+        {
+            if (SentimentKeyMatches(it->first, botGuid, playerGuid))
+                it = shard.dirtySentiments.erase(it);
+            else
+                ++it;
+        }
+        // The rows, and values of the running save, are hidden by the reset until the next
+        // save deletes them. Deleting now could race that save's upserts.
+        shard.pendingSentimentResets.emplace_back(botGuid, playerGuid);
+    });
+    return count;
+}
+
+SentimentCacheStats GetSentimentCacheStats()
+{
+    SentimentCacheStats stats;
+    ForEachRelationshipShard(0, [&](RelationshipShard& shard) {
+        TimedSharedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP_SHARED);
+        stats.resident += shard.sentimentPairs;
+        stats.pendingWrites += shard.dirtySentiments.size() + shard.pendingSentimentResets.size();
+        if (shard.savingSentiments)
+            stats.pendingWrites += shard.savingSentiments->values.size() + shard.savingSentiments->resets.size();
+        stats.loading += shard.sentimentLoads.size();
+    });
+    return stats;
+}
+
+void UnloadBotPlayerSentiments()
+{
+    ForEachRelationshipShard(0, [](RelationshipShard& shard) {
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        shard.pairs.EraseIf([&shard](uint64_t, uint64_t, RelationshipState& state) {
+            if (state.HasSentiment())
+            {
+                state.flags &= ~RELATIONSHIP_SENTIMENT_RESIDENT;
+                --shard.sentimentPairs;
+            }
+            return !state.HasHistory();
+        });
+    });
+}
+
+// Returns false if the commit failed
+static bool WriteBotPlayerSentiments(const std::vector<std::shared_ptr<const SentimentChanges>>& shardSentiments)
+{
+    auto start = std::chrono::steady_clock::now();
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+
+    // Resets first: every value taken is newer than every reset taken from its shard. A reset
+    // of all bots is queued in every shard, so duplicates are dropped.
+    std::set<SentimentKey> resets;
+    for (const auto& sentiments : shardSentiments)
+        resets.insert(sentiments->resets.begin(), sentiments->resets.end());
+    for (const auto& [botGuid, playerGuid] : resets)
+        trans->Append(GetResetSentimentsSql(botGuid, playerGuid));
+
+    // Upsert in multi-row batches; unlike REPLACE this keeps the row id and created_at
+    BatchedStatementWriter upserts(trans,
+        "INSERT INTO mod_ollama_chat_bot_player_sentiments (bot_guid, player_guid, sentiment_value) VALUES ",
+        " ON DUPLICATE KEY UPDATE sentiment_value = VALUES(sentiment_value)");
+
+    for (const auto& sentiments : shardSentiments)
     {
-        Field* fields = result->Fetch();
-        uint64_t botGuid = fields[0].Get<uint64_t>();
-        uint64_t playerGuid = fields[1].Get<uint64_t>();
-        float sentimentValue = fields[2].Get<float>();
-        
-        g_BotPlayerSentiments[botGuid][playerGuid] = sentimentValue;
-        count++;
-        
-    } while (result->NextRow());
-    
-    LOG_INFO("server.loading", "[OllamaChat] Loaded {} sentiment records from database", count);
+        for (const auto& [key, sentimentValue] : sentiments->values)
+        {
+            upserts.AddRow(fmt::format("({}, {}, {:.3f})", key.first, key.second, sentimentValue));
+        }
+    }
+    upserts.Flush();
+    if (!CommitTransactionAndWait(trans))
+    {
+        LOG_ERROR("server.loading", "[OllamaChat] Saving {} sentiment values and {} resets failed; they are kept for the next save.",
+                  upserts.Rows(), resets.size());
+        return false;
+    }
+
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    RecordDatabaseSave(DB_SAVE_SENTIMENT, upserts.Rows(), upserts.Statements() + uint32_t(resets.size()), micros);
+    return true;
+}
+
+// Only the changed values and resets are taken, one shard at a time; the swap keeps each
+// lock hold constant-time. They stay visible to loads through savingSentiments until the
+// write has been committed.
+static std::vector<std::shared_ptr<const SentimentChanges>> TakeDirtySentiments()
+{
+    std::vector<std::shared_ptr<const SentimentChanges>> shardSentiments;
+    ForEachRelationshipShard(0, [&](RelationshipShard& shard) {
+        auto sentiments = std::make_shared<SentimentChanges>();
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        if (shard.dirtySentiments.empty() && shard.pendingSentimentResets.empty())
+            return;
+        sentiments->values.swap(shard.dirtySentiments);
+        sentiments->resets.swap(shard.pendingSentimentResets);
+        shard.savingSentiments = sentiments;
+        shardSentiments.push_back(std::move(sentiments));
+    });
+    return shardSentiments;
+}
+
+// Changes of a failed save are queued again under the same lock that hides them, so loads
+// never see the stored value in between. They are older than anything queued since: the
+// resets go first and a value only comes back where no newer change or reset exists.
+static void RequeueSentimentChanges(RelationshipShard& shard, const SentimentChanges& saving)
+{
+    for (const auto& [key, sentimentValue] : saving.values)
+    {
+        if (!shard.dirtySentiments.count(key) && !AnyResetMatches(shard.pendingSentimentResets, key))
+            shard.dirtySentiments.emplace(key, sentimentValue);
+    }
+    shard.pendingSentimentResets.insert(shard.pendingSentimentResets.begin(), saving.resets.begin(), saving.resets.end());
+}
+
+static void FinishSentimentSave(bool committed)
+{
+    ForEachRelationshipShard(0, [committed](RelationshipShard& shard) {
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        if (!committed && shard.savingSentiments)
+            RequeueSentimentChanges(shard, *shard.savingSentiments);
+        shard.savingSentiments.reset();
+    });
+    sentimentSaveRunning = false;
 }
 
 void SaveBotPlayerSentimentsToDB()
@@ -177,26 +569,59 @@ void SaveBotPlayerSentimentsToDB()
     if (!g_EnableSentimentTracking)
         return;
 
-    std::lock_guard<std::mutex> lock(g_SentimentMutex);
-    
-    if (g_BotPlayerSentiments.empty())
+    if (sentimentSaveRunning.exchange(true))
+    {
+        if (g_DebugEnabled)
+            LOG_INFO("server.loading", "[OllamaChat] Previous sentiment save still running, skipping.");
         return;
-    
-    // Use REPLACE INTO to update existing records or insert new ones
-    for (const auto& [botGuid, playerMap] : g_BotPlayerSentiments)
+    }
+
+    std::vector<std::shared_ptr<const SentimentChanges>> shardSentiments = TakeDirtySentiments();
+    if (shardSentiments.empty())
     {
-        for (const auto& [playerGuid, sentimentValue] : playerMap)
-        {
-            CharacterDatabase.Execute(SafeFormat(
-                "REPLACE INTO mod_ollama_chat_bot_player_sentiments (bot_guid, player_guid, sentiment_value) "
-                "VALUES ({}, {}, {:.3f})",
-                botGuid, playerGuid, sentimentValue));
-        }
+        sentimentSaveRunning = false;
+        return;
     }
-    
-    if (g_DebugEnabled)
+
+    std::thread([shardSentiments = std::move(shardSentiments)]() {
+        FinishSentimentSave(WriteBotPlayerSentiments(shardSentiments));
+    }).detach();
+}
+
+bool FlushBotPlayerSentimentsToDB()
+{
+    if (sentimentSaveRunning.exchange(true))
+        return false;
+
+    // Changes queued before tracking was turned off are still written
+    std::vector<std::shared_ptr<const SentimentChanges>> shardSentiments = TakeDirtySentiments();
+    bool committed = shardSentiments.empty() || WriteBotPlayerSentiments(shardSentiments);
+    FinishSentimentSave(committed);
+    return committed;
+}
+
+void QueueJournaledSentiments(const std::vector<std::pair<uint64_t, uint64_t>>& resets, const std::vector<BotPlayerSentiment>& values)
+{
+    for (const auto& [botGuid, playerGuid] : resets)
+    {
+        ForEachRelationshipShard(botGuid, [&](RelationshipShard& shard) {
+            TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+            for (auto it = shard.dirtySentiments.begin(); it != shard.dirtySentiments.end();)
+            {
+                if (SentimentKeyMatches(it->first, botGuid, playerGuid))
+                    it = shard.dirtySentiments.erase(it);
+                else
+                    ++it;
+            }
+            shard.pendingSentimentResets.emplace_back(botGuid, playerGuid);
+        });
+    }
+
+    for (const BotPlayerSentiment& sentiment : values)
     {
-        LOG_INFO("server.loading", "[OllamaChat] Saved sentiment data to database");
+        RelationshipShard& shard = GetRelationshipShard(sentiment.botGuid);
+        TimedLockGuard lock(shard.mutex, TRACKED_LOCK_RELATIONSHIP);
+        shard.dirtySentiments[{ sentiment.botGuid, sentiment.playerGuid }] = sentiment.value;
     }
 }
 
@@ -210,8 +635,8 @@ void InitializeSentimentTracking()
     
     LOG_INFO("server.loading", "[OllamaChat] Initializing sentiment tracking system...");
     
-    // Load existing sentiment data from database
-    LoadBotPlayerSentimentsFromDB();
+    // Stored values are read per pair the first time the pair is used
+    UnloadBotPlayerSentiments();
     
     // Initialize the last save time
     g_LastSentimentSaveTime = time(nullptr);
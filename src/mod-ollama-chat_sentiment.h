@@ -2,7 +2,10 @@
 #define MOD_OLLAMA_CHAT_SENTIMENT_H
 
 #include <string>
+#include <cstddef>
 #include <cstdint>
+#include <utility>
+#include <vector>
 #include "Player.h"
 
 // --------------------------------------------
@@ -10,13 +13,21 @@
 // --------------------------------------------
 
 /**
- * Get the current sentiment value between a bot and player
+ * Get the current sentiment value between a bot and player without blocking.
+ * A pair that is not in memory is queued for the sentiment loader thread, which reads
+ * queued pairs in batches; until then the default value is returned.
  * @param botGuid GUID of the bot
  * @param playerGuid GUID of the player
- * @return Sentiment value (0.0-1.0), or default value if not found
+ * @return Sentiment value (0.0-1.0), or default value if not found or not loaded yet
  */
 float GetBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid);
 
+/**
+ * Like GetBotPlayerSentiment, but reads a pair that is not in memory before returning.
+ * Blocks on the database, so the world thread only uses it for rare calls such as GM commands.
+ */
+float LoadBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid);
+
 /**
  * Set the sentiment value between a bot and player
  * @param botGuid GUID of the bot
@@ -49,15 +60,72 @@ void UpdateBotPlayerSentiment(Player* bot, Player* player, const std::string& me
 std::string GetSentimentPromptAddition(Player* bot, Player* player);
 
 /**
- * Load all sentiment data from database into memory
+ * Sentiment prompt addition for a pair, loading it first if needed. Off the world thread only.
+ * @param playerName Name used for {player_name}
  */
-void LoadBotPlayerSentimentsFromDB();
+std::string GetSentimentPromptAddition(uint64_t botGuid, uint64_t playerGuid, const std::string& playerName);
+
+// One bot/player sentiment value held in memory
+struct BotPlayerSentiment
+{
+    uint64_t botGuid;
+    uint64_t playerGuid;
+    float    value;
+};
 
 /**
- * Save all sentiment data from memory to database
+ * Sentiment values currently held in memory. Pairs that were never used since startup,
+ * or were evicted, are only in the database and not listed.
+ * @param botGuid Only this bot, or 0 for all
+ * @param playerGuid Only this player, or 0 for all
+ */
+std::vector<BotPlayerSentiment> GetResidentBotPlayerSentiments(uint64_t botGuid, uint64_t playerGuid);
+
+/**
+ * Forget matching sentiment values in memory and delete their rows from the database.
+ * The rows are deleted by the next save, ahead of the values it writes; until then the
+ * matching pairs read as the default value.
+ * @param botGuid Only this bot, or 0 for all
+ * @param playerGuid Only this player, or 0 for all
+ * @return Number of values that were held in memory
+ */
+uint32_t ResetBotPlayerSentiments(uint64_t botGuid, uint64_t playerGuid);
+
+struct SentimentCacheStats
+{
+    size_t resident = 0;       // Pairs held in memory
+    size_t pendingWrites = 0;  // Changed values and resets waiting for the next save, evicted or not
+    size_t loading = 0;        // Pairs being read from the database
+};
+
+SentimentCacheStats GetSentimentCacheStats();
+
+/**
+ * Drop the sentiment values held in memory; pairs are read back from the database the
+ * next time they are needed. Changed values not yet saved are kept for the next save.
+ */
+void UnloadBotPlayerSentiments();
+
+/**
+ * Save the values changed since the last save, including ones evicted from memory
  */
 void SaveBotPlayerSentimentsToDB();
 
+/**
+ * Like SaveBotPlayerSentimentsToDB, but writes on the calling thread and returns once
+ * the commit has finished. Used by the persistence thread.
+ * @return false if another save was still running or the commit failed, so some changes
+ *         may not be stored yet. Changes of a failed commit are queued again.
+ */
+bool FlushBotPlayerSentimentsToDB();
+
+/**
+ * Queue replayed journal changes for the next save, as if they had just been made.
+ * The resets (0 matches all, as in ResetBotPlayerSentiments) are deleted before the
+ * values are written, so values journaled before a reset must already be left out.
+ */
+void QueueJournaledSentiments(const std::vector<std::pair<uint64_t, uint64_t>>& resets, const std::vector<BotPlayerSentiment>& values);
+
 /**
  * Initialize the sentiment tracking system
  */
@@ -0,0 +1,645 @@
+#include "mod-ollama-chat_snapshot.h"
+#include "mod-ollama-chat_config.h"
+#include "mod-ollama-chat_spellcache.h"
+#include "mod-ollama-chat-utilities.h"
+#include "Log.h"
+#include "Player.h"
+#include "Group.h"
+#include "Creature.h"
+#include "GameObject.h"
+#include "Map.h"
+#include "ObjectAccessor.h"
+#include "ObjectMgr.h"
+#include "QuestDef.h"
+#include "SharedDefines.h"
+#include "GridNotifiers.h"
+#include "GridNotifiersImpl.h"
+#include "CellImpl.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <initializer_list>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+// Helper function to format class name for any player
+static std::string FormatPlayerClass(uint8_t classId)
+{
+    switch (classId)
+    {
+        case CLASS_WARRIOR:      return "Warrior";
+        case CLASS_PALADIN:      return "Paladin";
+        case CLASS_HUNTER:       return "Hunter";
+        case CLASS_ROGUE:        return "Rogue";
+        case CLASS_PRIEST:       return "Priest";
+        case CLASS_DEATH_KNIGHT: return "Death Knight";
+        case CLASS_SHAMAN:       return "Shaman";
+        case CLASS_MAGE:         return "Mage";
+        case CLASS_WARLOCK:      return "Warlock";
+        case CLASS_DRUID:        return "Druid";
+        default:                 return "Unknown";
+    }
+}
+
+// Helper function to format race name for any player
+static std::string FormatPlayerRace(uint8_t raceId)
+{
+    switch (raceId)
+    {
+        case RACE_HUMAN:         return "Human";
+        case RACE_ORC:           return "Orc";
+        case RACE_DWARF:         return "Dwarf";
+        case RACE_NIGHTELF:      return "Night Elf";
+        case RACE_UNDEAD_PLAYER: return "Undead";
+        case RACE_TAUREN:        return "Tauren";
+        case RACE_GNOME:         return "Gnome";
+        case RACE_TROLL:         return "Troll";
+        case RACE_BLOODELF:      return "Blood Elf";
+        case RACE_DRAENEI:       return "Draenei";
+        default:                 return "Unknown";
+    }
+}
+
+// --- Helper: Spells ---
+std::string ChatHandler_GetBotSpellInfo(Player* bot)
+{
+    std::shared_ptr<const BotSpellDigest> digest = GetBotSpellDigest(bot);
+    std::vector<bool> onCooldown = GetBotSpellCooldownMask(bot, *digest);
+
+    std::ostringstream spellSummary;
+    for (size_t i = 0; i < digest->spells.size(); ++i)
+    {
+        if (onCooldown[i])
+            continue;
+
+        const BotSpellDigestEntry& spell = digest->spells[i];
+        spellSummary << "**" << spell.name << "**";
+        if (spell.rank > 0)
+        {
+            spellSummary << " (Rank " << spell.rank << ")";
+        }
+        spellSummary << " - Costs " << spell.costText << "\n";
+    }
+    return spellSummary.str();
+}
+
+// --- Helper: Group info ---
+std::vector<std::string> ChatHandler_GetGroupStatus(Player* bot)
+{
+    std::vector<std::string> info;
+    if (!bot || !bot->GetGroup()) return info;
+    Group* group = bot->GetGroup();
+    for (GroupReference* ref = group->GetFirstMember(); ref; ref = ref->next())
+    {
+        Player* member = ref->GetSource();
+        if (!member || !member->GetMap()) continue;
+        if(bot == member) continue;
+        float dist = bot->GetDistance(member);
+        std::string beingAttacked = "";
+        if (Unit* attacker = member->GetVictim())
+        {
+            beingAttacked = " [Under Attack by " + attacker->GetName() +
+                            ", Level: " + std::to_string(attacker->GetLevel()) + ", HP: " + std::to_string(attacker->GetHealth()) +
+                            "/" + std::to_string(attacker->GetMaxHealth()) + ")]";
+        }
+        std::string className = FormatPlayerClass(member->getClass());
+        std::string raceName = FormatPlayerRace(member->getRace());
+        info.push_back(
+            member->GetName() +
+            " (Level: " + std::to_string(member->GetLevel()) +
+            ", Class: " + className +
+            ", Race: " + raceName +
+            ", HP: " + std::to_string(member->GetHealth()) + "/" + std::to_string(member->GetMaxHealth()) +
+            ", Dist: " + std::to_string(dist) + ")" + beingAttacked
+        );
+
+    }
+    return info;
+}
+
+// --- Helper: Visible players ---
+std::vector<std::string> ChatHandler_GetVisiblePlayers(Player* bot, float radius = 40.0f)
+{
+    std::vector<std::string> players;
+    if (!bot || !bot->GetMap()) return players;
+    for (auto const& pair : ObjectAccessor::GetPlayers())
+    {
+        Player* player = pair.second;
+        if (!player || player == bot) continue;
+        if (!player->IsInWorld() || player->IsGameMaster()) continue;
+        if (player->GetMap() != bot->GetMap()) continue;
+        if (!bot->IsWithinDistInMap(player, radius)) continue;
+        if (!bot->IsWithinLOS(player->GetPositionX(), player->GetPositionY(), player->GetPositionZ())) continue;
+        float dist = bot->GetDistance(player);
+        std::string faction = (player->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
+        std::string className = FormatPlayerClass(player->getClass());
+        std::string raceName = FormatPlayerRace(player->getRace());
+        players.push_back(
+            "Player: " + player->GetName() +
+            " (Level: " + std::to_string(player->GetLevel()) +
+            ", Class: " + className +
+            ", Race: " + raceName +
+            ", Faction: " + faction +
+            ", Distance: " + std::to_string(dist) + ")"
+        );
+
+    }
+    return players;
+}
+
+// --- Helper: Visible locations/objects (creatures and gameobjects) ---
+
+// Grid search checks: only the cheap filters run for every object in the visited cells
+class SnapshotCreatureInRangeCheck
+{
+public:
+    SnapshotCreatureInRangeCheck(Player* bot, float radius) : _bot(bot), _radius(radius) {}
+    bool operator()(Creature* c) const
+    {
+        if (c->GetGUID() == _bot->GetGUID()) return false;
+        if (c->IsPet() || c->IsTotem()) return false;
+        return _bot->IsWithinDistInMap(c, _radius);
+    }
+private:
+    Player* _bot;
+    float _radius;
+};
+
+class SnapshotGameObjectInRangeCheck
+{
+public:
+    SnapshotGameObjectInRangeCheck(Player* bot, float radius) : _bot(bot), _radius(radius) {}
+    bool operator()(GameObject* go) const
+    {
+        return _bot->IsWithinDistInMap(go, _radius);
+    }
+private:
+    Player* _bot;
+    float _radius;
+};
+
+std::vector<std::string> ChatHandler_GetVisibleLocations(Player* bot, float radius = 40.0f)
+{
+    std::vector<std::string> visible;
+    if (!bot || !bot->GetMap()) return visible;
+
+    auto searchStart = std::chrono::steady_clock::now();
+
+    // Only the grid cells within radius are visited instead of every spawn on the map
+    std::list<Creature*> creatures;
+    SnapshotCreatureInRangeCheck creatureCheck(bot, radius);
+    Acore::CreatureListSearcher<SnapshotCreatureInRangeCheck> creatureSearcher(bot, creatures, creatureCheck);
+    Cell::VisitObjects(bot, creatureSearcher, radius);
+
+    std::list<GameObject*> gameObjects;
+    SnapshotGameObjectInRangeCheck goCheck(bot, radius);
+    Acore::GameObjectListSearcher<SnapshotGameObjectInRangeCheck> goSearcher(bot, gameObjects, goCheck);
+    Cell::VisitObjects(bot, goSearcher, radius);
+
+    // Nearest first, so LOS (the expensive test) stops once the cap is reached
+    std::vector<std::pair<float, WorldObject*>> candidates;
+    candidates.reserve(creatures.size() + gameObjects.size());
+    for (Creature* c : creatures)
+        candidates.emplace_back(bot->GetDistance(c), c);
+    for (GameObject* go : gameObjects)
+        candidates.emplace_back(bot->GetDistance(go), go);
+    std::sort(candidates.begin(), candidates.end(),
+              [](auto const& a, auto const& b) { return a.first < b.first; });
+
+    uint32_t losChecks = 0;
+    for (auto const& [dist, obj] : candidates)
+    {
+        if (g_SnapshotMaxVisibleObjects > 0 && visible.size() >= g_SnapshotMaxVisibleObjects)
+            break;
+
+        ++losChecks;
+        if (!bot->IsWithinLOS(obj->GetPositionX(), obj->GetPositionY(), obj->GetPositionZ())) continue;
+
+        if (Creature* c = obj->ToCreature())
+        {
+            std::string type;
+            if (c->isDead()) type = "DEAD";
+            else if (c->IsHostileTo(bot)) type = "ENEMY";
+            else if (c->IsFriendlyTo(bot)) type = "FRIENDLY";
+            else type = "NEUTRAL";
+            visible.push_back(
+                type + ": " + c->GetName() +
+                ", Level: " + std::to_string(c->GetLevel()) +
+                ", HP: " + std::to_string(c->GetHealth()) + "/" + std::to_string(c->GetMaxHealth()) +
+                ", Distance: " + std::to_string(dist) + ")"
+            );
+        }
+        else if (GameObject* go = obj->ToGameObject())
+        {
+            visible.push_back(
+                go->GetName() +
+                ", Type: " + std::to_string(go->GetGoType()) +
+                ", Distance: " + std::to_string(dist) + ")"
+            );
+        }
+    }
+
+    if (g_DebugEnabled)
+    {
+        auto searchUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - searchStart).count();
+        LOG_INFO("server.loading", "[Ollama Chat] Visible objects for {}: {} in range, {} LOS checks, {} kept in {}us",
+                 bot->GetName(), candidates.size(), losChecks, visible.size(), searchUs);
+    }
+    return visible;
+}
+
+// --- Helper: Combat summary ---
+std::string ChatHandler_GetCombatSummary(Player* bot)
+{
+    std::ostringstream oss;
+    bool inCombat = bot->IsInCombat();
+    Unit* victim = bot->GetVictim();
+
+    // Class-specific resource reporting
+    auto classId = bot->getClass();
+
+    auto printResource = [&](std::ostringstream& oss) {
+        switch (classId)
+        {
+            case CLASS_WARRIOR:
+                oss << ", Rage: " << bot->GetPower(POWER_RAGE) << "/" << bot->GetMaxPower(POWER_RAGE);
+                break;
+            case CLASS_ROGUE:
+                oss << ", Energy: " << bot->GetPower(POWER_ENERGY) << "/" << bot->GetMaxPower(POWER_ENERGY);
+                break;
+            case CLASS_DEATH_KNIGHT:
+                oss << ", Runic Power: " << bot->GetPower(POWER_RUNIC_POWER) << "/" << bot->GetMaxPower(POWER_RUNIC_POWER);
+                break;
+            case CLASS_HUNTER:
+                oss << ", Focus: " << bot->GetPower(POWER_FOCUS) << "/" << bot->GetMaxPower(POWER_FOCUS);
+                break;
+            default: // Mana classes
+                if (bot->GetMaxPower(POWER_MANA) > 0)
+                    oss << ", Mana: " << bot->GetPower(POWER_MANA) << "/" << bot->GetMaxPower(POWER_MANA);
+                break;
+        }
+    };
+
+    if (inCombat)
+    {
+        oss << "IN COMBAT: ";
+        if (victim)
+        {
+            oss << "Target: " << victim->GetName()
+                << ", Level: " << victim->GetLevel()
+                << ", HP: " << victim->GetHealth() << "/" << victim->GetMaxHealth();
+        }
+        else
+        {
+            oss << "No current target";
+        }
+        oss << ". ";
+        printResource(oss);
+    }
+    else
+    {
+        oss << "NOT IN COMBAT. ";
+        printResource(oss);
+    }
+    return oss.str();
+}
+
+// --- Helper: Quest log ---
+std::string ChatHandler_GetQuestSummary(Player* bot)
+{
+    std::string quests;
+    for (auto const& [questId, qsd] : bot->getQuestStatusMap())
+    {
+        // look up the template
+        Quest const* quest = sObjectMgr->GetQuestTemplate(questId);
+        if (!quest)
+            continue;
+
+        // get the English title as a fallback
+        std::string title = quest->GetTitle();
+
+        // then, if we have a locale record, overwrite it
+        if (auto const* locale = sObjectMgr->GetQuestLocale(questId))
+        {
+            int locIdx = bot->GetSession()->GetSessionDbLocaleIndex();
+            if (locIdx >= 0)
+                ObjectMgr::GetLocaleString(locale->Title, locIdx, title);
+        }
+
+        // Convert quest status to readable string
+        std::string statusText;
+        switch (qsd.Status)
+        {
+            case QUEST_STATUS_NONE:       statusText = "not started"; break;
+            case QUEST_STATUS_COMPLETE:   statusText = "complete (ready to turn in)"; break;
+            case QUEST_STATUS_INCOMPLETE: statusText = "in progress"; break;
+            case QUEST_STATUS_FAILED:     statusText = "failed"; break;
+            case QUEST_STATUS_REWARDED:   statusText = "completed and rewarded"; break;
+            default:                      statusText = "unknown"; break;
+        }
+
+        quests += "Quest \"" + title + "\" is " + statusText + "\n";
+    }
+    return quests;
+}
+
+// --------------------------------------------
+// Per-bot section cache
+// --------------------------------------------
+
+enum SnapshotSection
+{
+    SNAPSHOT_COMBAT = 0,
+    SNAPSHOT_GROUP,
+    SNAPSHOT_SPELLS,
+    SNAPSHOT_QUESTS,
+    SNAPSHOT_LOS,
+    SNAPSHOT_PLAYERS,
+    SNAPSHOT_SECTION_COUNT
+};
+
+static std::string BuildCombatSection(Player* bot)
+{
+    return ChatHandler_GetCombatSummary(bot);
+}
+
+static std::string BuildGroupSection(Player* bot)
+{
+    std::string group;
+    std::vector<std::string> groupInfo = ChatHandler_GetGroupStatus(bot);
+    if (!groupInfo.empty()) {
+        group += "Group members:\n";
+        for (const auto& entry : groupInfo) group += " - " + entry + "\n";
+    }
+    return group;
+}
+
+static std::string BuildLosSection(Player* bot)
+{
+    std::string los;
+    std::vector<std::string> losLocs = ChatHandler_GetVisibleLocations(bot);
+    for (const auto& entry : losLocs) los += " - " + entry + "\n";
+    return los;
+}
+
+static std::string BuildPlayersSection(Player* bot)
+{
+    std::string players;
+    std::vector<std::string> nearbyPlayers = ChatHandler_GetVisiblePlayers(bot);
+    for (const auto& entry : nearbyPlayers) players += " - " + entry + "\n";
+    return players;
+}
+
+struct SnapshotSectionInfo
+{
+    const char* name;
+    const uint32_t* ttlMs;
+    bool deferrable;    // Aged-out text may be served while a refresh is queued
+    std::string (*build)(Player* bot);
+};
+
+static const SnapshotSectionInfo snapshotSections[SNAPSHOT_SECTION_COUNT] =
+{
+    { "combat",  &g_SnapshotCombatTTLMs,  false, BuildCombatSection },
+    { "group",   &g_SnapshotGroupTTLMs,   false, BuildGroupSection },
+    { "spells",  &g_SnapshotSpellsTTLMs,  false, ChatHandler_GetBotSpellInfo },
+    { "quests",  &g_SnapshotQuestsTTLMs,  true,  ChatHandler_GetQuestSummary },
+    { "los",     &g_SnapshotLosTTLMs,     true,  BuildLosSection },
+    { "players", &g_SnapshotPlayersTTLMs, false, BuildPlayersSection }
+};
+
+struct CachedSnapshotSection
+{
+    std::string text;
+    std::chrono::steady_clock::time_point builtAt;
+    bool built = false;
+    uint32_t version = 0;        // Bumped when a game event invalidates the section
+    uint32_t builtVersion = 0;   // Version the cached text was built from
+};
+
+struct BotSnapshotCache
+{
+    CachedSnapshotSection sections[SNAPSHOT_SECTION_COUNT];
+    std::shared_ptr<const BotSpellDigest> spellDigest;   // Digest the spells section was built from
+    bool refreshQueued = false;
+};
+
+// Chat hooks run on map update threads, so the cache is guarded; sections are built outside the lock.
+static std::mutex snapshotCacheMutex;
+static std::unordered_map<uint64_t, BotSnapshotCache> snapshotCache;
+static std::deque<uint64_t> snapshotRefreshQueue;
+
+// A deferrable section older than this many TTLs is rebuilt inline rather than served
+static constexpr uint32_t SNAPSHOT_MAX_STALE_TTLS = 2;
+
+static uint64_t SectionAgeMs(const CachedSnapshotSection& section, std::chrono::steady_clock::time_point now)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - section.builtAt).count());
+}
+
+// spellDigest is the bot's current digest; the spells section is stale once it changes
+static bool IsSectionFresh(const BotSnapshotCache& cache, SnapshotSection id, const std::shared_ptr<const BotSpellDigest>& spellDigest,
+                           std::chrono::steady_clock::time_point now)
+{
+    const CachedSnapshotSection& section = cache.sections[id];
+    if (!section.built || section.version != section.builtVersion)
+        return false;
+    if (id == SNAPSHOT_SPELLS && cache.spellDigest != spellDigest)
+        return false;
+    return SectionAgeMs(section, now) < *snapshotSections[id].ttlMs;
+}
+
+// Rebuilds the given sections for bot and stores them; ids not set in rebuild are left alone
+static void RebuildSnapshotSections(Player* bot, const bool (&rebuild)[SNAPSHOT_SECTION_COUNT],
+                                    const uint32_t (&versions)[SNAPSHOT_SECTION_COUNT],
+                                    std::string (&texts)[SNAPSHOT_SECTION_COUNT])
+{
+    auto now = std::chrono::steady_clock::now();
+    std::shared_ptr<const BotSpellDigest> spellDigest;
+    for (uint32_t i = 0; i < SNAPSHOT_SECTION_COUNT; ++i)
+    {
+        if (!rebuild[i])
+            continue;
+        if (i == SNAPSHOT_SPELLS)
+            spellDigest = GetBotSpellDigest(bot);
+        texts[i] = snapshotSections[i].build(bot);
+    }
+
+    std::lock_guard<std::mutex> lock(snapshotCacheMutex);
+    BotSnapshotCache& cache = snapshotCache[bot->GetGUID().GetRawValue()];
+    for (uint32_t i = 0; i < SNAPSHOT_SECTION_COUNT; ++i)
+    {
+        if (!rebuild[i])
+            continue;
+        CachedSnapshotSection& section = cache.sections[i];
+        section.text = texts[i];
+        section.builtAt = now;
+        section.built = true;
+        // An invalidation that raced with the build leaves the section stale
+        section.builtVersion = versions[i];
+    }
+    if (spellDigest)
+        cache.spellDigest = spellDigest;
+}
+
+std::string GenerateBotGameStateSnapshot(Player* bot)
+{
+    std::string texts[SNAPSHOT_SECTION_COUNT];
+    bool rebuild[SNAPSHOT_SECTION_COUNT] = {};
+    uint32_t versions[SNAPSHOT_SECTION_COUNT] = {};
+
+    if (!g_EnableSnapshotCache)
+    {
+        for (uint32_t i = 0; i < SNAPSHOT_SECTION_COUNT; ++i)
+            texts[i] = snapshotSections[i].build(bot);
+    }
+    else
+    {
+        // Fetched before locking; building a missing digest must not hold up other bots' snapshots
+        std::shared_ptr<const BotSpellDigest> spellDigest = GetBotSpellDigest(bot);
+        auto now = std::chrono::steady_clock::now();
+        uint64_t botGuid = bot->GetGUID().GetRawValue();
+        {
+            std::lock_guard<std::mutex> lock(snapshotCacheMutex);
+            BotSnapshotCache& cache = snapshotCache[botGuid];
+            for (uint32_t i = 0; i < SNAPSHOT_SECTION_COUNT; ++i)
+            {
+                SnapshotSection id = static_cast<SnapshotSection>(i);
+                const CachedSnapshotSection& section = cache.sections[i];
+                versions[i] = section.version;
+                if (IsSectionFresh(cache, id, spellDigest, now))
+                {
+                    texts[i] = section.text;
+                    continue;
+                }
+
+                // Only time has made this section stale: serve it and let the world update refresh it
+                uint64_t ttlMs = *snapshotSections[i].ttlMs;
+                if (snapshotSections[i].deferrable && section.built && section.version == section.builtVersion &&
+                    SectionAgeMs(section, now) < ttlMs * SNAPSHOT_MAX_STALE_TTLS)
+                {
+                    texts[i] = section.text;
+                    if (!cache.refreshQueued)
+                    {
+                        cache.refreshQueued = true;
+                        snapshotRefreshQueue.push_back(botGuid);
+                    }
+                    continue;
+                }
+
+                rebuild[i] = true;
+            }
+        }
+
+        auto buildStart = std::chrono::steady_clock::now();
+        RebuildSnapshotSections(bot, rebuild, versions, texts);
+        if (g_DebugEnabled)
+        {
+            std::string rebuilt;
+            for (uint32_t i = 0; i < SNAPSHOT_SECTION_COUNT; ++i)
+                if (rebuild[i])
+                    rebuilt += std::string(rebuilt.empty() ? "" : ",") + snapshotSections[i].name;
+            auto buildUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - buildStart).count();
+            LOG_INFO("server.loading", "[Ollama Chat] Snapshot for {}: rebuilt [{}] in {}us", bot->GetName(), rebuilt, buildUs);
+        }
+    }
+
+    // Use template
+    PromptVars vars;
+    vars.Set(PROMPT_VAR_COMBAT, std::move(texts[SNAPSHOT_COMBAT]));
+    vars.Set(PROMPT_VAR_GROUP, std::move(texts[SNAPSHOT_GROUP]));
+    vars.Set(PROMPT_VAR_SPELLS, std::move(texts[SNAPSHOT_SPELLS]));
+    vars.Set(PROMPT_VAR_QUESTS, std::move(texts[SNAPSHOT_QUESTS]));
+    vars.Set(PROMPT_VAR_LOS, std::move(texts[SNAPSHOT_LOS]));
+    vars.Set(PROMPT_VAR_PLAYERS, std::move(texts[SNAPSHOT_PLAYERS]));
+    return GetPromptTemplates()->chatBotSnapshot.Render(vars);
+}
+
+void RefreshStaleSnapshotSections()
+{
+    for (uint32_t refreshed = 0; refreshed < g_SnapshotRefreshPerTick; ++refreshed)
+    {
+        uint64_t botGuid;
+        {
+            std::lock_guard<std::mutex> lock(snapshotCacheMutex);
+            if (snapshotRefreshQueue.empty())
+                return;
+            botGuid = snapshotRefreshQueue.front();
+            snapshotRefreshQueue.pop_front();
+        }
+
+        Player* bot = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
+
+        auto now = std::chrono::steady_clock::now();
+        bool rebuild[SNAPSHOT_SECTION_COUNT] = {};
+        uint32_t versions[SNAPSHOT_SECTION_COUNT] = {};
+        bool anyStale = false;
+        {
+            std::lock_guard<std::mutex> lock(snapshotCacheMutex);
+            auto it = snapshotCache.find(botGuid);
+            if (it == snapshotCache.end())
+                continue;
+            if (!bot)
+            {
+                snapshotCache.erase(it);
+                continue;
+            }
+
+            BotSnapshotCache& cache = it->second;
+            cache.refreshQueued = false;
+            for (uint32_t i = 0; i < SNAPSHOT_SECTION_COUNT; ++i)
+            {
+                versions[i] = cache.sections[i].version;
+                if (snapshotSections[i].deferrable && !IsSectionFresh(cache, static_cast<SnapshotSection>(i), nullptr, now))
+                    anyStale = rebuild[i] = true;
+            }
+        }
+
+        if (anyStale)
+        {
+            std::string texts[SNAPSHOT_SECTION_COUNT];
+            RebuildSnapshotSections(bot, rebuild, versions, texts);
+        }
+    }
+}
+
+static void InvalidateSnapshotSections(Player* player, std::initializer_list<SnapshotSection> ids)
+{
+    std::lock_guard<std::mutex> lock(snapshotCacheMutex);
+    auto it = snapshotCache.find(player->GetGUID().GetRawValue());
+    if (it == snapshotCache.end())
+        return;
+    for (SnapshotSection id : ids)
+        ++it->second.sections[id].version;
+}
+
+void OllamaSnapshotCacheScript::OnPlayerCompleteQuest(Player* player, Quest const* /*quest*/)
+{
+    if (player)
+        InvalidateSnapshotSections(player, { SNAPSHOT_QUESTS });
+}
+
+void OllamaSnapshotCacheScript::OnPlayerQuestAbandon(Player* player, uint32 /*questId*/)
+{
+    if (player)
+        InvalidateSnapshotSections(player, { SNAPSHOT_QUESTS });
+}
+
+void OllamaSnapshotCacheScript::OnPlayerMapChanged(Player* player)
+{
+    if (player)
+        InvalidateSnapshotSections(player, { SNAPSHOT_GROUP, SNAPSHOT_LOS, SNAPSHOT_PLAYERS });
+}
+
+void OllamaSnapshotCacheScript::OnPlayerLogout(Player* player)
+{
+    if (!player)
+        return;
+    std::lock_guard<std::mutex> lock(snapshotCacheMutex);
+    snapshotCache.erase(player->GetGUID().GetRawValue());
+}
@@ -0,0 +1,40 @@
+#ifndef MOD_OLLAMA_CHAT_SNAPSHOT_H
+#define MOD_OLLAMA_CHAT_SNAPSHOT_H
+
+#include "ScriptMgr.h"
+#include <string>
+
+class Player;
+class Quest;
+
+/**
+ * Build the game-state snapshot appended to chat prompts (OllamaChat.ChatBotSnapshotTemplate).
+ * Each section (combat, group, spells, quests, los, players) is cached per bot and only
+ * rebuilt once its OllamaChat.Snapshot*TTLMs has passed or a game event marked it dirty.
+ * Quest and LOS sections that merely aged out are served from cache and refreshed on the
+ * next world update instead of on the reply path.
+ * @param bot The bot replying
+ * @return Formatted snapshot text
+ */
+std::string GenerateBotGameStateSnapshot(Player* bot);
+
+// Rebuilds snapshot sections queued by GenerateBotGameStateSnapshot. Called from the world update.
+void RefreshStaleSnapshotSections();
+
+// Marks snapshot sections dirty on quest and map changes and drops a bot's cache on logout.
+class OllamaSnapshotCacheScript : public PlayerScript
+{
+public:
+    OllamaSnapshotCacheScript() : PlayerScript("OllamaSnapshotCacheScript", {
+        PLAYERHOOK_ON_PLAYER_COMPLETE_QUEST,
+        PLAYERHOOK_ON_QUEST_ABANDON,
+        PLAYERHOOK_ON_MAP_CHANGED,
+        PLAYERHOOK_ON_LOGOUT
+    }) {}
+    void OnPlayerCompleteQuest(Player* player, Quest const* quest) override;
+    void OnPlayerQuestAbandon(Player* player, uint32 questId) override;
+    void OnPlayerMapChanged(Player* player) override;
+    void OnPlayerLogout(Player* player) override;
+};
+
+#endif // MOD_OLLAMA_CHAT_SNAPSHOT_H
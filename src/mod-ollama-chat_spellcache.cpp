@@ -0,0 +1,170 @@
+#include "mod-ollama-chat_spellcache.h"
+#include "mod-ollama-chat_config.h"
+#include "Log.h"
+#include "Player.h"
+#include "SpellMgr.h"
+#include "SpellInfo.h"
+#include "SharedDefines.h"
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+struct SpellDigestEntry
+{
+    std::shared_ptr<const BotSpellDigest> digest;   // Null until built and after each invalidation
+    uint32_t generation = 0;                         // Bumped by every invalidation
+};
+
+// Entries are kept after invalidation so a build that started before it can tell
+static std::mutex spellDigestMutex;
+static std::unordered_map<uint64_t, SpellDigestEntry> spellDigests;
+
+static std::string GetSpellCostText(const SpellInfo* spellInfo)
+{
+    if (!spellInfo->ManaCost && !spellInfo->ManaCostPercentage)
+        return "no cost";
+
+    switch (spellInfo->PowerType)
+    {
+        case POWER_MANA:        return std::to_string(spellInfo->ManaCost) + " mana";
+        case POWER_RAGE:        return std::to_string(spellInfo->ManaCost) + " rage";
+        case POWER_FOCUS:       return std::to_string(spellInfo->ManaCost) + " focus";
+        case POWER_ENERGY:      return std::to_string(spellInfo->ManaCost) + " energy";
+        case POWER_RUNIC_POWER: return std::to_string(spellInfo->ManaCost) + " runic power";
+        default:                return std::to_string(spellInfo->ManaCost) + " unknown resource";
+    }
+}
+
+// Describes the first effect that is interesting to talk about, if any
+static std::string GetSpellEffectText(const SpellInfo* spellInfo)
+{
+    for (int i = 0; i < MAX_SPELL_EFFECTS; ++i)
+    {
+        if (!spellInfo->Effects[i].IsEffect())
+            continue;
+        switch (spellInfo->Effects[i].Effect)
+        {
+            case SPELL_EFFECT_SCHOOL_DAMAGE: return "Deals damage";
+            case SPELL_EFFECT_HEAL:          return "Heals the target";
+            case SPELL_EFFECT_APPLY_AURA:    return "Applies an effect";
+            case SPELL_EFFECT_DISPEL:        return "Dispels magic";
+            case SPELL_EFFECT_THREAT:        return "Generates threat";
+            default:                         break;
+        }
+    }
+    return "";
+}
+
+static std::shared_ptr<const BotSpellDigest> BuildBotSpellDigest(Player* bot)
+{
+    // Highest rank of each spell, keyed by name so the digest comes out sorted
+    std::map<std::string, const SpellInfo*> highestRanks;
+    for (const auto& spellPair : bot->GetSpellMap())
+    {
+        const SpellInfo* spellInfo = sSpellMgr->GetSpellInfo(spellPair.first);
+        if (!spellInfo || spellInfo->Attributes & SPELL_ATTR0_PASSIVE)
+            continue;
+        if (spellInfo->SpellFamilyName == SPELLFAMILY_GENERIC)
+            continue;
+
+        const char* name = spellInfo->SpellName[0];
+        if (!name || !*name)
+            continue;
+
+        const SpellInfo*& best = highestRanks[name];
+        if (!best || spellInfo->GetRank() > best->GetRank())
+            best = spellInfo;
+    }
+
+    auto digest = std::make_shared<BotSpellDigest>();
+    digest->spells.reserve(highestRanks.size());
+    for (const auto& [name, spellInfo] : highestRanks)
+    {
+        digest->spells.push_back({
+            spellInfo->Id,
+            name,
+            spellInfo->GetRank(),
+            GetSpellCostText(spellInfo),
+            GetSpellEffectText(spellInfo)
+        });
+    }
+    return digest;
+}
+
+std::shared_ptr<const BotSpellDigest> GetBotSpellDigest(Player* bot)
+{
+    uint64_t botGuid = bot->GetGUID().GetRawValue();
+    uint32_t generation;
+    {
+        std::lock_guard<std::mutex> lock(spellDigestMutex);
+        SpellDigestEntry& entry = spellDigests[botGuid];
+        if (entry.digest)
+            return entry.digest;
+        generation = entry.generation;
+    }
+
+    // Built outside the lock. Two callers racing build equivalent digests.
+    std::shared_ptr<const BotSpellDigest> digest = BuildBotSpellDigest(bot);
+    if (g_DebugEnabled)
+        LOG_INFO("server.loading", "[Ollama Chat] Built spell digest for {} ({} spells).", bot->GetName(), digest->spells.size());
+
+    // A spell book change during the build may have been missed, so the digest is only
+    // cached if no invalidation came in meanwhile; the next read rebuilds it otherwise
+    std::lock_guard<std::mutex> lock(spellDigestMutex);
+    SpellDigestEntry& entry = spellDigests[botGuid];
+    if (entry.generation == generation)
+        entry.digest = digest;
+    return digest;
+}
+
+std::vector<bool> GetBotSpellCooldownMask(Player* bot, const BotSpellDigest& digest)
+{
+    std::vector<bool> onCooldown(digest.spells.size(), false);
+    for (size_t i = 0; i < digest.spells.size(); ++i)
+        onCooldown[i] = bot->HasSpellCooldown(digest.spells[i].spellId);
+    return onCooldown;
+}
+
+void InvalidateBotSpellDigest(uint64_t botGuid)
+{
+    std::lock_guard<std::mutex> lock(spellDigestMutex);
+    SpellDigestEntry& entry = spellDigests[botGuid];
+    entry.digest.reset();
+    ++entry.generation;
+}
+
+void OllamaSpellCacheScript::OnPlayerLearnSpell(Player* player, uint32 /*spellID*/)
+{
+    if (player)
+        InvalidateBotSpellDigest(player->GetGUID().GetRawValue());
+}
+
+void OllamaSpellCacheScript::OnPlayerForgotSpell(Player* player, uint32 /*spellID*/)
+{
+    if (player)
+        InvalidateBotSpellDigest(player->GetGUID().GetRawValue());
+}
+
+void OllamaSpellCacheScript::OnPlayerLearnTalents(Player* player, uint32 /*talentId*/, uint32 /*talentRank*/, uint32 /*spellid*/)
+{
+    if (player)
+        InvalidateBotSpellDigest(player->GetGUID().GetRawValue());
+}
+
+void OllamaSpellCacheScript::OnPlayerTalentsReset(Player* player, bool /*noCost*/)
+{
+    if (player)
+        InvalidateBotSpellDigest(player->GetGUID().GetRawValue());
+}
+
+void OllamaSpellCacheScript::OnPlayerAfterSpecSlotChanged(Player* player, uint8 /*newSlot*/)
+{
+    if (player)
+        InvalidateBotSpellDigest(player->GetGUID().GetRawValue());
+}
+
+void OllamaSpellCacheScript::OnPlayerLogout(Player* player)
+{
+    if (player)
+        InvalidateBotSpellDigest(player->GetGUID().GetRawValue());
+}
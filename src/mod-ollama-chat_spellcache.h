@@ -0,0 +1,68 @@
+#ifndef MOD_OLLAMA_CHAT_SPELLCACHE_H
+#define MOD_OLLAMA_CHAT_SPELLCACHE_H
+
+#include "ScriptMgr.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Player;
+
+// One active, non-generic spell a bot knows, at the highest rank it has learned.
+struct BotSpellDigestEntry
+{
+    uint32_t    spellId;
+    std::string name;
+    uint32_t    rank;
+    std::string costText;     // e.g. "30 mana", "no cost"
+    std::string effectText;   // Empty if no effect is worth describing
+};
+
+// Per-bot spell summary, sorted by spell name. Everything here depends only on the
+// spell book, so it is built once and reused until the bot learns or forgets a spell.
+struct BotSpellDigest
+{
+    std::vector<BotSpellDigestEntry> spells;
+};
+
+/**
+ * Get the cached spell digest for a bot, building it on first use.
+ * @param bot The bot
+ * @return Immutable digest, safe to keep after the cache is invalidated
+ */
+std::shared_ptr<const BotSpellDigest> GetBotSpellDigest(Player* bot);
+
+/**
+ * Cooldown state of each digest entry, read at call time.
+ * @return Bit i is set if digest.spells[i] is currently on cooldown for the bot
+ */
+std::vector<bool> GetBotSpellCooldownMask(Player* bot, const BotSpellDigest& digest);
+
+/**
+ * Drop the cached digest for a bot; the next read rebuilds it. A digest being built
+ * at the time is returned to its caller but not cached.
+ */
+void InvalidateBotSpellDigest(uint64_t botGuid);
+
+// Keeps the spell digest cache in step with spell book changes.
+class OllamaSpellCacheScript : public PlayerScript
+{
+public:
+    OllamaSpellCacheScript() : PlayerScript("OllamaSpellCacheScript", {
+        PLAYERHOOK_ON_LEARN_SPELL,
+        PLAYERHOOK_ON_FORGOT_SPELL,
+        PLAYERHOOK_ON_LEARN_TALENTS,
+        PLAYERHOOK_ON_TALENTS_RESET,
+        PLAYERHOOK_ON_AFTER_SPEC_SLOT_CHANGED,
+        PLAYERHOOK_ON_LOGOUT
+    }) {}
+    void OnPlayerLearnSpell(Player* player, uint32 spellID) override;
+    void OnPlayerForgotSpell(Player* player, uint32 spellID) override;
+    void OnPlayerLearnTalents(Player* player, uint32 talentId, uint32 talentRank, uint32 spellid) override;
+    void OnPlayerTalentsReset(Player* player, bool noCost) override;
+    void OnPlayerAfterSpecSlotChanged(Player* player, uint8 newSlot) override;
+    void OnPlayerLogout(Player* player) override;
+};
+
+#endif // MOD_OLLAMA_CHAT_SPELLCACHE_H
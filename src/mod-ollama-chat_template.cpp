@@ -0,0 +1,159 @@
+#include "mod-ollama-chat_template.h"
+#include <algorithm>
+
+const char* PromptVarNames[PROMPT_VAR_COUNT] =
+{
+    "bot_name",
+    "bot_level",
+    "bot_class",
+    "bot_race",
+    "bot_gender",
+    "bot_role",
+    "bot_faction",
+    "bot_guild",
+    "bot_group_status",
+    "bot_gold",
+    "bot_area",
+    "bot_zone",
+    "bot_map",
+    "bot_personality",
+    "bot_personality_name",
+    "player_name",
+    "player_level",
+    "player_class",
+    "player_race",
+    "player_gender",
+    "player_role",
+    "player_faction",
+    "player_guild",
+    "player_group_status",
+    "player_gold",
+    "player_distance",
+    "player_message",
+    "bot_reply",
+    "extra_info",
+    "chat_history",
+    "sentiment_info",
+    "rag_info",
+    "environment_info",
+    "event_type",
+    "event_detail",
+    "actor_name",
+    "combat",
+    "group",
+    "spells",
+    "quests",
+    "los",
+    "players"
+};
+
+static bool FindPromptVar(const std::string& name, PromptVar* var)
+{
+    for (uint32_t i = 0; i < PROMPT_VAR_COUNT; ++i)
+    {
+        if (name == PromptVarNames[i])
+        {
+            *var = static_cast<PromptVar>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CompiledPromptTemplate::Compile(const std::string& source, std::initializer_list<PromptVar> allowed, std::string* error)
+{
+    m_source.clear();
+    m_literals.clear();
+    m_segments.clear();
+    m_used.reset();
+
+    std::string literals;
+    std::bitset<PROMPT_VAR_COUNT> used;
+    std::vector<Segment> segments;
+    auto fail = [error](std::string message)
+    {
+        if (error)
+            *error = std::move(message);
+        return false;
+    };
+    // Extends the literal run at the end of segments, or starts a new one
+    auto appendLiteral = [&literals, &segments](const char* text, size_t length)
+    {
+        if (length == 0)
+            return;
+        if (segments.empty() || segments.back().var != LITERAL)
+            segments.push_back({ LITERAL, static_cast<uint32_t>(literals.size()), 0 });
+        literals.append(text, length);
+        segments.back().length += static_cast<uint32_t>(length);
+    };
+
+    size_t pos = 0;
+    while (pos < source.size())
+    {
+        size_t brace = source.find_first_of("{}", pos);
+        if (brace == std::string::npos)
+        {
+            appendLiteral(source.data() + pos, source.size() - pos);
+            break;
+        }
+        appendLiteral(source.data() + pos, brace - pos);
+
+        char c = source[brace];
+        if (brace + 1 < source.size() && source[brace + 1] == c)
+        {
+            appendLiteral(&c, 1);
+            pos = brace + 2;
+            continue;
+        }
+        if (c == '}')
+            return fail("unmatched '}' at offset " + std::to_string(brace));
+
+        size_t close = source.find('}', brace + 1);
+        if (close == std::string::npos)
+            return fail("unterminated '{' at offset " + std::to_string(brace));
+
+        std::string name = source.substr(brace + 1, close - brace - 1);
+        if (name.empty())
+            return fail("positional placeholder {} at offset " + std::to_string(brace) + " is not supported");
+        if (name.find_first_of(":!{") != std::string::npos)
+            return fail("placeholder {" + name + "} uses a format spec, which is not supported");
+
+        PromptVar var;
+        if (!FindPromptVar(name, &var) || std::find(allowed.begin(), allowed.end(), var) == allowed.end())
+            return fail("unknown placeholder {" + name + "}");
+
+        segments.push_back({ var, 0, 0 });
+        used.set(var);
+        pos = close + 1;
+    }
+
+    m_source = source;
+    m_literals = std::move(literals);
+    m_segments = std::move(segments);
+    m_used = used;
+    return true;
+}
+
+void CompiledPromptTemplate::RenderTo(std::string& out, const PromptVars& vars) const
+{
+    size_t size = m_literals.size();
+    for (const Segment& segment : m_segments)
+        if (segment.var != LITERAL)
+            size += vars.Get(segment.var).size();
+    out.reserve(out.size() + size);
+
+    for (const Segment& segment : m_segments)
+    {
+        if (segment.var == LITERAL)
+            out.append(m_literals, segment.offset, segment.length);
+        else
+            out += vars.Get(segment.var);
+    }
+}
+
+std::string CompiledPromptTemplate::Render(const PromptVars& vars) const
+{
+    std::string out;
+    RenderTo(out, vars);
+    return out;
+}
@@ -0,0 +1,129 @@
+#ifndef MOD_OLLAMA_CHAT_TEMPLATE_H
+#define MOD_OLLAMA_CHAT_TEMPLATE_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fmt/core.h>
+
+// Every placeholder a prompt template may reference. Each template accepts a subset,
+// given when it is compiled.
+enum PromptVar : uint8_t
+{
+    PROMPT_VAR_BOT_NAME = 0,
+    PROMPT_VAR_BOT_LEVEL,
+    PROMPT_VAR_BOT_CLASS,
+    PROMPT_VAR_BOT_RACE,
+    PROMPT_VAR_BOT_GENDER,
+    PROMPT_VAR_BOT_ROLE,
+    PROMPT_VAR_BOT_FACTION,
+    PROMPT_VAR_BOT_GUILD,
+    PROMPT_VAR_BOT_GROUP_STATUS,
+    PROMPT_VAR_BOT_GOLD,
+    PROMPT_VAR_BOT_AREA,
+    PROMPT_VAR_BOT_ZONE,
+    PROMPT_VAR_BOT_MAP,
+    PROMPT_VAR_BOT_PERSONALITY,
+    PROMPT_VAR_BOT_PERSONALITY_NAME,
+    PROMPT_VAR_PLAYER_NAME,
+    PROMPT_VAR_PLAYER_LEVEL,
+    PROMPT_VAR_PLAYER_CLASS,
+    PROMPT_VAR_PLAYER_RACE,
+    PROMPT_VAR_PLAYER_GENDER,
+    PROMPT_VAR_PLAYER_ROLE,
+    PROMPT_VAR_PLAYER_FACTION,
+    PROMPT_VAR_PLAYER_GUILD,
+    PROMPT_VAR_PLAYER_GROUP_STATUS,
+    PROMPT_VAR_PLAYER_GOLD,
+    PROMPT_VAR_PLAYER_DISTANCE,
+    PROMPT_VAR_PLAYER_MESSAGE,
+    PROMPT_VAR_BOT_REPLY,
+    PROMPT_VAR_EXTRA_INFO,
+    PROMPT_VAR_CHAT_HISTORY,
+    PROMPT_VAR_SENTIMENT_INFO,
+    PROMPT_VAR_RAG_INFO,
+    PROMPT_VAR_ENVIRONMENT_INFO,
+    PROMPT_VAR_EVENT_TYPE,
+    PROMPT_VAR_EVENT_DETAIL,
+    PROMPT_VAR_ACTOR_NAME,
+    PROMPT_VAR_COMBAT,
+    PROMPT_VAR_GROUP,
+    PROMPT_VAR_SPELLS,
+    PROMPT_VAR_QUESTS,
+    PROMPT_VAR_LOS,
+    PROMPT_VAR_PLAYERS,
+    PROMPT_VAR_COUNT
+};
+
+// Placeholder name of each PromptVar, without braces
+extern const char* PromptVarNames[PROMPT_VAR_COUNT];
+
+// Values for one render. Unset variables render as empty strings.
+class PromptVars
+{
+public:
+    void Set(PromptVar var, std::string value) { m_values[var] = std::move(value); }
+    void Set(PromptVar var, const char* value) { m_values[var] = value; }
+    // Copies into the existing string, reusing its capacity
+    void Set(PromptVar var, std::string_view value) { m_values[var].assign(value.data(), value.size()); }
+
+    // Numbers are formatted the same way fmt::format("{}") does
+    template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    void Set(PromptVar var, T value) { m_values[var] = fmt::format("{}", value); }
+
+    const std::string& Get(PromptVar var) const { return m_values[var]; }
+
+private:
+    std::array<std::string, PROMPT_VAR_COUNT> m_values;
+};
+
+// A prompt template parsed once into literal spans and placeholder slots.
+//
+// Uses the fmt named-argument syntax the templates were written for: {name} is a
+// placeholder, {{ and }} are literal braces. Format specs and positional arguments
+// are rejected, as are placeholders outside the template's allowed set, so a bad
+// template is reported when the config loads instead of on every request.
+class CompiledPromptTemplate
+{
+public:
+    /**
+     * Parse a template.
+     * @param source  Template text
+     * @param allowed Placeholders this template may use
+     * @param error   Set to a description of the first problem on failure
+     * @return false if the template is malformed; the object is left empty
+     */
+    bool Compile(const std::string& source, std::initializer_list<PromptVar> allowed, std::string* error);
+
+    bool Empty() const { return m_segments.empty(); }
+    // True if the template contains the placeholder, so callers can skip computing unused values
+    bool Uses(PromptVar var) const { return m_used.test(var); }
+    const std::string& Source() const { return m_source; }
+
+    // Appends the rendered template to out
+    void RenderTo(std::string& out, const PromptVars& vars) const;
+    std::string Render(const PromptVars& vars) const;
+
+private:
+    static constexpr PromptVar LITERAL = PROMPT_VAR_COUNT;
+
+    struct Segment
+    {
+        PromptVar var;      // LITERAL for text spans
+        uint32_t  offset;   // Literal span in m_literals
+        uint32_t  length;
+    };
+
+    std::string          m_source;
+    std::string          m_literals;
+    std::vector<Segment> m_segments;
+    std::bitset<PROMPT_VAR_COUNT> m_used;
+};
+
+#endif // MOD_OLLAMA_CHAT_TEMPLATE_H